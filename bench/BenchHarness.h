@@ -0,0 +1,61 @@
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+// Minimal registry for the ObjectTrackingBench cases. Each bench_*.cpp
+// registers its cases with REGISTER_BENCH and prints its own table; the
+// figures worth tracking over time are also handed to benchRecord(), which
+// bench_main writes out as JSON (--json) and checks against a stored
+// baseline (--baseline).
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef OBJECT_TRACKING_DATA_DIR
+#define OBJECT_TRACKING_DATA_DIR "../data/"
+#endif
+
+struct BenchOptions {
+    bool quick = false;                           // Fewer sizes/iterations (smoke run)
+    std::string data_dir = OBJECT_TRACKING_DATA_DIR; // coco.names; weights are optional (batched_detect)
+};
+
+using BenchFn = std::function<void(const BenchOptions&)>;
+
+// One tracked figure. `metric` names the measurement and its parameters,
+// e.g. "decoder_us[input=320,classes=default]".
+struct BenchResult {
+    std::string bench;
+    std::string metric;
+    double value = 0.0;
+    std::string unit;
+    bool lower_is_better = true;
+};
+
+inline std::vector<BenchResult>& benchResults() {
+    static std::vector<BenchResult> results;
+    return results;
+}
+
+inline std::string& currentBench() {
+    static std::string name;
+    return name;
+}
+
+inline void benchRecord(const std::string& metric, double value, const char* unit, bool lower_is_better = true) {
+    benchResults().push_back({currentBench(), metric, value, unit, lower_is_better});
+}
+
+inline std::vector<std::pair<std::string, BenchFn>>& benchRegistry() {
+    static std::vector<std::pair<std::string, BenchFn>> cases;
+    return cases;
+}
+
+struct BenchRegistrar {
+    BenchRegistrar(const char* name, BenchFn fn) { benchRegistry().emplace_back(name, std::move(fn)); }
+};
+
+#define REGISTER_BENCH(name, fn) static BenchRegistrar bench_registrar_##fn(name, fn)
+
+#endif // BENCHHARNESS_H
@@ -0,0 +1,66 @@
+#include "SyntheticScene.h"
+
+#include <cmath>
+
+// Reflect a 1-D position into [0, limit] so objects bounce off the edges
+static float bounce(float p, float limit) {
+    if (limit <= 0) return 0;
+    float period = 2 * limit;
+    float m = std::fmod(p, period);
+    if (m < 0) m += period;
+    return m > limit ? period - m : m;
+}
+
+SyntheticScene::SyntheticScene(cv::Size size, int object_count, uint64_t seed) : frame_size(size)
+{
+    cv::RNG rng(seed);
+    background.create(frame_size, CV_8UC3);
+    cv::randu(background, cv::Scalar::all(40), cv::Scalar::all(90));
+    cv::GaussianBlur(background, background, cv::Size(5, 5), 0);
+
+    for (int i = 0; i < object_count; ++i) {
+        Object obj;
+        obj.size = cv::Size(rng.uniform(30, 80), rng.uniform(40, 120));
+        obj.start = cv::Point2f(rng.uniform(0.f, (float)(frame_size.width - obj.size.width)),
+                                rng.uniform(0.f, (float)(frame_size.height - obj.size.height)));
+        obj.velocity = cv::Point2f(rng.uniform(-4.f, 4.f), rng.uniform(-3.f, 3.f));
+        // High-contrast random texture gives the correlation filter something to lock onto
+        obj.texture.create(obj.size, CV_8UC3);
+        cv::randu(obj.texture, cv::Scalar::all(0), cv::Scalar::all(255));
+        cv::GaussianBlur(obj.texture, obj.texture, cv::Size(3, 3), 0);
+        objects.push_back(obj);
+    }
+}
+
+cv::Rect SyntheticScene::boxAt(const Object& obj, int frame_index) const {
+    float x = bounce(obj.start.x + obj.velocity.x * frame_index, (float)(frame_size.width - obj.size.width));
+    float y = bounce(obj.start.y + obj.velocity.y * frame_index, (float)(frame_size.height - obj.size.height));
+    return cv::Rect(cvRound(x), cvRound(y), obj.size.width, obj.size.height) & cv::Rect(0, 0, frame_size.width, frame_size.height);
+}
+
+void SyntheticScene::render(int frame_index, cv::Mat& out) const {
+    background.copyTo(out);
+    for (const Object& obj : objects) {
+        cv::Rect box = boxAt(obj, frame_index);
+        obj.texture(cv::Rect(0, 0, box.width, box.height)).copyTo(out(box));
+    }
+}
+
+std::vector<cv::Rect> SyntheticScene::boxesAt(int frame_index) const {
+    std::vector<cv::Rect> boxes;
+    boxes.reserve(objects.size());
+    for (const Object& obj : objects) { boxes.push_back(boxAt(obj, frame_index)); }
+    return boxes;
+}
+
+bool SyntheticScene::writeClip(const std::string& path, int frames, double fps) const {
+    cv::VideoWriter writer;
+    if (!writer.open(path, cv::VideoWriter::fourcc('M','J','P','G'), fps, frame_size, true)) return false;
+    cv::Mat frame;
+    for (int f = 0; f < frames; ++f) {
+        render(f, frame);
+        writer.write(frame);
+    }
+    writer.release();
+    return true;
+}
@@ -0,0 +1,57 @@
+// Steady-state allocations: heap and Mat allocations per frame for the
+// tracking/overlay path on a 1080p synthetic stream (no network needed).
+
+#include "AllocationCounters.h"
+#include "BenchHarness.h"
+#include "SyntheticScene.h"
+#include "TrackingPipeline.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <cstdio>
+#include <vector>
+
+static void benchAllocations(const BenchOptions& opt) {
+    AllocationCounters::installMatAllocator();
+    const int warmup = 30;
+    const int frames = opt.quick ? 50 : 300;
+
+    std::printf("%8s %12s %12s %12s %12s\n", "tracks", "heap/frm", "heapB/frm", "mat/frm", "matB/frm");
+    for (int n : {10, 40}) {
+        SyntheticScene scene(cv::Size(1920, 1080), n, 11);
+        PipelineConfig cfg;
+        cfg.data_path = opt.data_dir;
+        cfg.async_detection = false;
+        TrackingPipeline pipeline(cfg);
+        if (!pipeline.loadClassNames()) { std::printf("coco.names not found in %s\n", opt.data_dir.c_str()); return; }
+        pipeline.setDrawTrajectory(true);
+        pipeline.reset();
+
+        cv::Mat frame;
+        std::vector<TrackOverlay> overlay;
+        StageTimings timings;
+        scene.render(0, frame);
+        pipeline.associateAndTrack(frame, scene.boxesAt(0), std::vector<int>(n, 0));
+
+        AllocSnapshot total;
+        for (int f = 1; f <= warmup + frames; ++f) {
+            scene.render(f, frame);
+            AllocSnapshot before = AllocationCounters::snapshot();
+            pipeline.updateTracks(frame);
+            pipeline.collectOverlay(overlay);
+            pipeline.drawOverlay(frame, overlay, f, timings, 30.0);
+            AllocSnapshot delta = AllocationCounters::snapshot() - before;
+            if (f <= warmup) continue;
+            total.heap_allocs += delta.heap_allocs; total.heap_bytes += delta.heap_bytes;
+            total.mat_allocs += delta.mat_allocs; total.mat_bytes += delta.mat_bytes;
+        }
+        std::printf("%8d %12.2f %12.0f %12.2f %12.0f\n", n,
+                    (double)total.heap_allocs / frames, (double)total.heap_bytes / frames,
+                    (double)total.mat_allocs / frames, (double)total.mat_bytes / frames);
+        benchRecord(cv::format("heap_allocs_per_frame[tracks=%d]", n), (double)total.heap_allocs / frames, "allocs");
+        benchRecord(cv::format("mat_allocs_per_frame[tracks=%d]", n), (double)total.mat_allocs / frames, "allocs");
+    }
+    if (!AllocationCounters::heapCountingEnabled()) { std::printf("(heap counting not linked in; heap columns are 0)\n"); }
+}
+
+REGISTER_BENCH("allocations", benchAllocations);
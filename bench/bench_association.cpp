@@ -0,0 +1,184 @@
+// Association cost: legacy greedy IoU scan vs. grid-pruned optimal assignment,
+// scaling track count and detection count independently. lost_index compares
+// per-frame lost-track upkeep and re-ID candidate lookup against the linear
+// walk over every lost track, and checks recentlyLost() against a direct
+// count, including max_lost == recent_window + 1 where both wheel entries of
+// a track land in the same bucket.
+
+#include "Association.h"
+#include "BenchHarness.h"
+#include "LostTrackIndex.h"
+#include "TrackingPipeline.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static cv::Rect randomBox(cv::RNG& rng, cv::Size area) {
+    int w = rng.uniform(30, 90), h = rng.uniform(30, 90);
+    return cv::Rect(rng.uniform(0, area.width - w), rng.uniform(0, area.height - h), w, h);
+}
+
+// The per-track greedy scan associateAndTrack used before the solver
+static int legacyGreedy(const std::vector<cv::Rect>& tracks, const std::vector<cv::Rect>& dets, double min_iou) {
+    std::vector<bool> matched(dets.size(), false);
+    int matches = 0;
+    for (const cv::Rect& t : tracks) {
+        int best = -1; double best_iou = min_iou;
+        for (size_t i = 0; i < dets.size(); ++i) {
+            if (matched[i]) continue;
+            double iou = TrackingPipeline::calculateIoU(t, dets[i]);
+            if (iou > best_iou) { best_iou = iou; best = (int)i; }
+        }
+        if (best != -1) { matched[best] = true; matches++; }
+    }
+    return matches;
+}
+
+static void benchAssociation(const BenchOptions& opt) {
+    const std::vector<int> counts = opt.quick ? std::vector<int>{50, 200} : std::vector<int>{50, 100, 200, 400, 800};
+    const int iters = opt.quick ? 10 : 50;
+    const cv::Size area(1920, 1080);
+    const double min_iou = PipelineConfig().min_iou_threshold;
+
+    std::printf("%7s %7s %11s %11s %9s %8s %8s %6s %6s\n", "tracks", "dets", "greedy_us", "solver_us", "speedup",
+                "greedy", "solver", "pairs", "comps");
+    for (int n_tracks : counts) {
+        for (int n_dets : counts) {
+            cv::RNG rng(42);
+            std::vector<cv::Rect> tracks, dets;
+            for (int i = 0; i < n_tracks; ++i) tracks.push_back(randomBox(rng, area));
+            // 90% of the overlap are jittered re-detections, the rest new objects
+            const int seen = std::min(n_tracks, n_dets) * 9 / 10;
+            for (int i = 0; i < seen; ++i) {
+                cv::Rect b = tracks[i];
+                b.x += rng.uniform(-6, 7); b.y += rng.uniform(-6, 7);
+                b.width += rng.uniform(-4, 5); b.height += rng.uniform(-4, 5);
+                dets.push_back(b);
+            }
+            while ((int)dets.size() < n_dets) dets.push_back(randomBox(rng, area));
+            std::reverse(dets.begin(), dets.end()); // Detector order is unrelated to track order
+
+            int greedy_matches = 0;
+            long long t0 = cv::getTickCount();
+            for (int i = 0; i < iters; ++i) greedy_matches = legacyGreedy(tracks, dets, min_iou);
+            long long t1 = cv::getTickCount();
+
+            Associator associator;
+            std::vector<int> det_to_track;
+            for (int i = 0; i < iters; ++i) associator.match(tracks, dets, min_iou, det_to_track);
+            long long t2 = cv::getTickCount();
+            int solver_matches = (int)std::count_if(det_to_track.begin(), det_to_track.end(), [](int t) { return t != -1; });
+
+            double greedy_us = (double)(t1 - t0) / cv::getTickFrequency() * 1e6 / iters;
+            double solver_us = (double)(t2 - t1) / cv::getTickFrequency() * 1e6 / iters;
+            const AssociationStats& st = associator.lastStats();
+            std::printf("%7d %7d %11.1f %11.1f %8.2fx %8d %8d %6d %6d\n", n_tracks, n_dets, greedy_us, solver_us,
+                        solver_us > 0 ? greedy_us / solver_us : 0.0, greedy_matches, solver_matches,
+                        st.candidate_pairs, st.components);
+            benchRecord(cv::format("solver_us[tracks=%d,dets=%d]", n_tracks, n_dets), solver_us, "us");
+        }
+    }
+}
+
+// Churns tracks through an index (loss, re-ID, expiry) and returns the
+// number of steps on which recentlyLost() disagreed with a direct count
+static int recentCountErrors(int max_lost, int recent_window, int slots, int steps) {
+    LostTrackIndex index;
+    index.configure(max_lost, recent_window);
+    index.setFrameSize(cv::Size(640, 480));
+    cv::RNG rng(11);
+    std::vector<int> expired;
+    int errors = 0;
+    for (long long now = 1; now <= steps; ++now) {
+        index.expire(now, expired);
+        for (int k = 0; k < 3; ++k) {
+            int slot = rng.uniform(0, slots);
+            if (!index.contains(slot)) index.add(slot, now, randomBox(rng, cv::Size(640, 480)));
+            else if (rng.uniform(0, 4) == 0) index.remove(slot, now);
+        }
+        int expected = 0;
+        for (int slot = 0; slot < slots; ++slot) { if (index.contains(slot) && now - index.lostAt(slot) <= recent_window) expected++; }
+        if (index.recentlyLost() != expected) errors++;
+    }
+    return errors;
+}
+
+static void benchLostIndex(const BenchOptions& opt) {
+    const std::vector<int> counts = opt.quick ? std::vector<int>{100, 400} : std::vector<int>{100, 400, 1600};
+    const int frames = opt.quick ? 60 : 300;
+    const int max_lost = PipelineConfig().max_lost_frames;
+    const cv::Size area(1920, 1080);
+
+    std::printf("%7s %12s %12s %12s %12s %10s\n", "lost", "walk_us/frm", "wheel_us/frm", "scan_us/q", "index_us/q", "cand/q");
+    for (int n_lost : counts) {
+        // Steady state: n_lost tracks alive, n_lost / max_lost lost (and expiring) per frame
+        cv::RNG rng(7);
+        const int per_frame = std::max(1, n_lost / max_lost);
+        std::vector<cv::Rect> boxes(n_lost * 2);
+        for (cv::Rect& b : boxes) b = randomBox(rng, area);
+        std::vector<int> frames_since_seen;
+        std::vector<int> lost_slots, expired, candidates;
+        LostTrackIndex index;
+        index.configure(max_lost, PipelineConfig().detect_interval);
+        index.setFrameSize(area);
+
+        double walk_us = 0.0, wheel_us = 0.0;
+        int next_slot = 0;
+        for (long long now = 1; now <= frames + max_lost; ++now) {
+            const bool timed = now > max_lost; // Past the warm-up
+            long long t0 = cv::getTickCount();
+            // Linear walk (the old per-frame loop): bump every lost track, collect expired ones
+            size_t kept = 0;
+            for (size_t i = 0; i < lost_slots.size(); ++i) {
+                if (++frames_since_seen[i] > max_lost) continue;
+                lost_slots[kept] = lost_slots[i]; frames_since_seen[kept++] = frames_since_seen[i];
+            }
+            lost_slots.resize(kept); frames_since_seen.resize(kept);
+            long long t1 = cv::getTickCount();
+            index.expire(now, expired);
+            long long t2 = cv::getTickCount();
+            for (int k = 0; k < per_frame; ++k) {
+                int slot = next_slot; next_slot = (next_slot + 1) % (int)boxes.size();
+                if (index.contains(slot)) continue;
+                lost_slots.push_back(slot); frames_since_seen.push_back(1);
+                index.add(slot, now, boxes[slot]);
+            }
+            if (timed) { walk_us += (double)(t1 - t0) / cv::getTickFrequency() * 1e6; wheel_us += (double)(t2 - t1) / cv::getTickFrequency() * 1e6; }
+        }
+
+        // Re-ID lookup for 50 unmatched detections
+        std::vector<cv::Rect> dets;
+        for (int i = 0; i < 50; ++i) dets.push_back(randomBox(rng, area));
+        const int iters = opt.quick ? 20 : 100;
+        int scan_hits = 0;
+        long long t0 = cv::getTickCount();
+        for (int it = 0; it < iters; ++it) {
+            scan_hits = 0;
+            for (const cv::Rect& d : dets)
+                for (int slot : lost_slots) { if ((boxes[slot] & d).area() > 0) scan_hits++; }
+        }
+        long long t1 = cv::getTickCount();
+        for (int it = 0; it < iters; ++it) { index.query(dets, candidates); }
+        long long t2 = cv::getTickCount();
+        (void)scan_hits;
+
+        std::printf("%7zu %12.2f %12.2f %12.1f %12.1f %10.1f\n", index.size(), walk_us / frames, wheel_us / frames,
+                    (double)(t1 - t0) / cv::getTickFrequency() * 1e6 / iters,
+                    (double)(t2 - t1) / cv::getTickFrequency() * 1e6 / iters, (double)candidates.size() / dets.size());
+        benchRecord(cv::format("wheel_us_per_frame[lost=%d]", n_lost), wheel_us / frames, "us");
+        benchRecord(cv::format("query_us[lost=%d]", n_lost), (double)(t2 - t1) / cv::getTickFrequency() * 1e6 / iters, "us");
+    }
+
+    const int steps = opt.quick ? 500 : 3000;
+    for (int window : {PipelineConfig().detect_interval, max_lost - 1, max_lost + 5}) {
+        int errors = recentCountErrors(max_lost, window, 200, steps);
+        std::printf("recently_lost [max_lost=%d, window=%d]: %s\n", max_lost, window,
+                    errors == 0 ? "matches" : cv::format("WRONG on %d of %d steps", errors, steps).c_str());
+    }
+}
+
+REGISTER_BENCH("association", benchAssociation);
+REGISTER_BENCH("lost_index", benchLostIndex);
@@ -0,0 +1,111 @@
+// Multi-stream detection: N streams each asking for detections as fast as
+// they can, through one shared BatchedDetector. Compares batch-1 forwards
+// (batch_max = 1) against batched ones and reports aggregate detections/s
+// and per-stream latency. Uses yolov4-tiny when its weights are in the data
+// folder, otherwise a small synthetic conv stack so no download is needed.
+
+#include "BatchedDetector.h"
+#include "BenchHarness.h"
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// conv3x3 -> ReLU layers; roughly a fifth of yolov4-tiny's cost at 320x320
+static cv::dnn::Net syntheticNet() {
+    cv::dnn::Net net;
+    const int channels[][3] = {{3, 16, 2}, {16, 32, 2}, {32, 64, 2}, {64, 128, 1}, {128, 128, 1}}; // in, out, stride
+    cv::RNG rng(5);
+    for (int i = 0; i < 5; ++i) {
+        cv::dnn::LayerParams conv;
+        conv.set("kernel_size", 3); conv.set("pad", 1); conv.set("stride", channels[i][2]);
+        conv.set("num_output", channels[i][1]); conv.set("bias_term", false);
+        int wsize[4] = {channels[i][1], channels[i][0], 3, 3};
+        cv::Mat weights(4, wsize, CV_32F);
+        rng.fill(weights, cv::RNG::NORMAL, 0.0, 0.1);
+        conv.blobs.push_back(weights);
+        net.addLayerToPrev(cv::format("conv%d", i), "Convolution", conv);
+        cv::dnn::LayerParams relu;
+        net.addLayerToPrev(cv::format("relu%d", i), "ReLU", relu);
+    }
+    net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    return net;
+}
+
+static void benchBatchedDetect(const BenchOptions& opt) {
+    const std::vector<int> stream_counts = opt.quick ? std::vector<int>{1, 4} : std::vector<int>{1, 2, 4, 8, 16};
+    const int requests = opt.quick ? 4 : 20; // Per stream
+    const bool have_weights = std::ifstream(opt.data_dir + "yolov4-tiny.weights").good();
+    cv::dnn::Net synthetic = have_weights ? cv::dnn::Net() : syntheticNet();
+    std::printf("network: %s\n", have_weights ? "yolov4-tiny" : "synthetic conv stack (no weights found)");
+
+    std::printf("%8s %8s %10s %12s %12s %12s\n", "streams", "batch", "det/s", "lat_ms", "lat_p95_ms", "imgs/batch");
+    for (int n : stream_counts) {
+        for (int batch_max : {1, 8}) {
+            PipelineConfig cfg;
+            cfg.data_path = opt.data_dir;
+            cfg.batch_max = batch_max;
+            BatchedDetector detector(cfg);
+            if (have_weights) {
+                if (!detector.loadNetwork()) return;
+            } else {
+                detector.setForward([&synthetic](const cv::Mat& blob, std::vector<cv::Mat>& outs) {
+                    synthetic.setInput(blob);
+                    cv::Mat out = synthetic.forward();
+                    int shape[3] = {out.size[0], out.size[1], out.size[2] * out.size[3]}; // Split-able like a YOLO head
+                    outs.assign(1, out.reshape(1, 3, shape));
+                    return true;
+                });
+            }
+            detector.setStreamCount(n);
+
+            // One warm-up round so lazy allocations are not timed
+            cv::Mat warm_blob;
+            cv::dnn::blobFromImage(cv::Mat(cfg.input_height, cfg.input_width, CV_8UC3, cv::Scalar(90, 120, 150)), warm_blob,
+                                   1. / 255., cv::Size(cfg.input_width, cfg.input_height), cv::Scalar(), true, false);
+            std::vector<cv::Mat> warm_outs;
+            detector.infer(warm_blob, warm_outs);
+            detector.resetStats();
+
+            std::vector<std::vector<double>> latencies(n);
+            std::vector<std::thread> threads;
+            long long start_tick = cv::getTickCount();
+            for (int s = 0; s < n; ++s) {
+                threads.emplace_back([&, s] {
+                    cv::Mat image(cfg.input_height, cfg.input_width, CV_8UC3);
+                    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(255));
+                    cv::Mat blob;
+                    cv::dnn::blobFromImage(image, blob, 1. / 255., cv::Size(cfg.input_width, cfg.input_height), cv::Scalar(), true, false);
+                    std::vector<cv::Mat> outs;
+                    for (int r = 0; r < requests; ++r) {
+                        long long t0 = cv::getTickCount();
+                        detector.infer(blob, outs);
+                        latencies[s].push_back(((double)(cv::getTickCount() - t0) / cv::getTickFrequency()) * 1000);
+                    }
+                });
+            }
+            for (std::thread& t : threads) { t.join(); }
+            double wall_sec = (double)(cv::getTickCount() - start_tick) / cv::getTickFrequency();
+
+            std::vector<double> all;
+            for (const std::vector<double>& l : latencies) { all.insert(all.end(), l.begin(), l.end()); }
+            std::sort(all.begin(), all.end());
+            double mean = 0.0;
+            for (double v : all) { mean += v; }
+            mean /= all.size();
+            BatchStats b = detector.stats();
+            std::printf("%8d %8d %10.1f %12.1f %12.1f %12.2f\n", n, batch_max, all.size() / wall_sec, mean,
+                        all[std::min(all.size() - 1, (size_t)(all.size() * 0.95))],
+                        b.batches ? (double)b.images / b.batches : 0.0);
+            benchRecord(cv::format("detections_per_sec[streams=%d,batch=%d]", n, batch_max), all.size() / wall_sec, "1/s", false);
+        }
+    }
+}
+
+REGISTER_BENCH("batched_detect", benchBatchedDetect);
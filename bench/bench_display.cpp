@@ -0,0 +1,48 @@
+// Encode thread -> GUI hand-off (built with BUILD_GUI only): FrameMailbox
+// publish + take, which shares the frame's pixels with a QImage, against
+// the copy-and-convert the worker used to do for every frame (BGR -> RGB
+// plus a deep QImage copy).
+
+#include "BenchHarness.h"
+#include "FrameMailbox.h"
+#include "SyntheticScene.h"
+
+#include <QImage>
+
+#include <opencv2/opencv.hpp>
+
+#include <cstdio>
+
+static QImage legacyConvert(const cv::Mat& frame, cv::Mat& rgb) {
+    cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
+    return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
+}
+
+static void benchFrameHandoff(const BenchOptions& opt) {
+    const int iters = opt.quick ? 50 : 500;
+    std::printf("%10s %14s %14s %9s\n", "frame", "legacy_us", "mailbox_us", "speedup");
+    for (cv::Size size : {cv::Size(1280, 720), cv::Size(1920, 1080)}) {
+        SyntheticScene scene(size, 10, 3);
+        cv::Mat frame, rgb;
+        scene.render(0, frame);
+
+        long long t0 = cv::getTickCount();
+        long long checksum = 0;
+        for (int i = 0; i < iters; ++i) { checksum += legacyConvert(frame, rgb).width(); }
+        long long t1 = cv::getTickCount();
+
+        FrameMailbox mailbox(nullptr);
+        QImage shown;
+        for (int i = 0; i < iters; ++i) { mailbox.publish(frame); mailbox.take(shown); checksum += shown.width(); }
+        long long t2 = cv::getTickCount();
+        (void)checksum;
+
+        double legacy_us = (double)(t1 - t0) / cv::getTickFrequency() * 1e6 / iters;
+        double mailbox_us = (double)(t2 - t1) / cv::getTickFrequency() * 1e6 / iters;
+        std::printf("%10s %14.1f %14.1f %8.1fx\n", cv::format("%dx%d", size.width, size.height).c_str(), legacy_us, mailbox_us,
+                    mailbox_us > 0 ? legacy_us / mailbox_us : 0.0);
+        benchRecord(cv::format("mailbox_us[frame=%dx%d]", size.width, size.height), mailbox_us, "us");
+    }
+}
+
+REGISTER_BENCH("frame_handoff", benchFrameHandoff);
@@ -0,0 +1,131 @@
+// ObjectTrackingBench: synthetic benchmarks for the tracking core.
+// Runs on a CPU-only box with no model weights downloaded.
+//
+// Usage: ObjectTrackingBench [case ...] [--quick] [--data <dir>] [--list]
+//                            [--json <file>] [--baseline <file>] [--tolerance <f>]
+//   With no case names every registered case runs.
+//   --json <file>      Write every recorded figure (benchRecord) as JSON
+//   --baseline <file>  Compare against a JSON file written earlier by --json;
+//                      exits with status 3 if any figure regressed
+//   --tolerance <f>    Relative change that counts as a regression (default 0.15)
+//
+// Record a baseline on the reference machine with
+//   ObjectTrackingBench --json baseline.json
+// and check a later build with
+//   ObjectTrackingBench --baseline baseline.json
+// (use the same --quick setting for both; figures are matched by case and metric).
+
+#include "BenchHarness.h"
+
+#include <opencv2/core.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static bool writeJson(const std::string& path, const BenchOptions& options) {
+    cv::FileStorage fs(path, cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+    if (!fs.isOpened()) return false;
+    fs << "quick" << (int)options.quick;
+    fs << "results" << "[";
+    for (const BenchResult& r : benchResults()) {
+        fs << "{" << "case" << r.bench << "metric" << r.metric << "value" << r.value
+           << "unit" << r.unit << "lower_is_better" << (int)r.lower_is_better << "}";
+    }
+    fs << "]";
+    fs.release();
+    return true;
+}
+
+static bool readJson(const std::string& path, std::vector<BenchResult>& out, int& quick) {
+    out.clear();
+    cv::FileStorage fs;
+    try {
+        if (!fs.open(path, cv::FileStorage::READ | cv::FileStorage::FORMAT_JSON)) return false;
+    } catch (const cv::Exception&) {
+        return false;
+    }
+    quick = fs["quick"].isNone() ? -1 : (int)fs["quick"];
+    cv::FileNode results = fs["results"];
+    for (cv::FileNodeIterator it = results.begin(); it != results.end(); ++it) {
+        cv::FileNode n = *it;
+        BenchResult r;
+        n["case"] >> r.bench; n["metric"] >> r.metric; n["value"] >> r.value; n["unit"] >> r.unit;
+        r.lower_is_better = (int)n["lower_is_better"] != 0;
+        out.push_back(r);
+    }
+    return true;
+}
+
+// Prints one line per figure found in both runs; returns the number of regressions
+static int compareBaseline(const std::vector<BenchResult>& baseline, double tolerance) {
+    int regressions = 0, compared = 0;
+    std::printf("%-16s %-44s %12s %12s %9s\n", "case", "metric", "baseline", "now", "change");
+    for (const BenchResult& now : benchResults()) {
+        const BenchResult* base = nullptr;
+        for (const BenchResult& b : baseline) { if (b.bench == now.bench && b.metric == now.metric) { base = &b; break; } }
+        if (!base) { std::printf("%-16s %-44s %12s %12.3f %9s\n", now.bench.c_str(), now.metric.c_str(), "-", now.value, "new"); continue; }
+        compared++;
+        const double change = base->value != 0 ? (now.value - base->value) / std::fabs(base->value) : 0.0;
+        const bool worse = now.lower_is_better ? change > tolerance : change < -tolerance;
+        const bool better = now.lower_is_better ? change < -tolerance : change > tolerance;
+        if (worse) regressions++;
+        std::printf("%-16s %-44s %12.3f %12.3f %+8.1f%% %s\n", now.bench.c_str(), now.metric.c_str(), base->value, now.value,
+                    100.0 * change, worse ? "REGRESSION" : better ? "improved" : "");
+    }
+    std::printf("%d figure(s) compared, %d regression(s) beyond %.0f%%\n", compared, regressions, 100.0 * tolerance);
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    std::vector<std::string> selected;
+    std::string json_path, baseline_path;
+    double tolerance = 0.15;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quick") { options.quick = true; }
+        else if (arg == "--data" && i + 1 < argc) { options.data_dir = argv[++i]; if (options.data_dir.back() != '/') options.data_dir += '/'; }
+        else if (arg == "--list") { for (auto const& c : benchRegistry()) std::cout << c.first << std::endl; return 0; }
+        else if (arg == "--json" && i + 1 < argc) { json_path = argv[++i]; }
+        else if (arg == "--baseline" && i + 1 < argc) { baseline_path = argv[++i]; }
+        else if (arg == "--tolerance" && i + 1 < argc) { tolerance = std::atof(argv[++i]); }
+        else { selected.push_back(arg); }
+    }
+
+    std::vector<BenchResult> baseline;
+    if (!baseline_path.empty()) {
+        int baseline_quick = -1;
+        if (!readJson(baseline_path, baseline, baseline_quick)) { std::cerr << "Could not read baseline " << baseline_path << std::endl; return 1; }
+        if (baseline_quick >= 0 && baseline_quick != (int)options.quick) {
+            std::cerr << "Warning: baseline was recorded " << (baseline_quick ? "with" : "without") << " --quick" << std::endl;
+        }
+    }
+
+    int ran = 0;
+    for (auto const& [name, fn] : benchRegistry()) {
+        bool wanted = selected.empty();
+        for (const std::string& s : selected) { if (s == name) wanted = true; }
+        if (!wanted) continue;
+        std::cout << "=== " << name << " ===" << std::endl;
+        currentBench() = name;
+        fn(options);
+        std::cout << std::endl;
+        ran++;
+    }
+    if (ran == 0) { std::cerr << "No matching benchmark case. Use --list." << std::endl; return 1; }
+
+    if (!json_path.empty()) {
+        if (writeJson(json_path, options)) { std::cout << "Wrote " << benchResults().size() << " figure(s) to " << json_path << std::endl; }
+        else { std::cerr << "Could not write " << json_path << std::endl; return 1; }
+    }
+    if (!baseline_path.empty()) {
+        std::cout << "=== baseline " << baseline_path << " ===" << std::endl;
+        if (compareBaseline(baseline, tolerance) > 0) return 3;
+    }
+    return 0;
+}
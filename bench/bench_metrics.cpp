@@ -0,0 +1,84 @@
+// Instrumentation overhead: cost of one LatencyHistogram::observe() and
+// Counter::add() with 1..8 threads hitting the same series, and of a
+// LOG_DEBUG call site while debug logging is off.
+// events: EventBus::publish() from one producer while EventLogWriter drains
+// the ring to a JSONL file, and how many events a small ring drops in a burst.
+
+#include "BenchHarness.h"
+#include "EventLog.h"
+#include "Log.h"
+#include "Metrics.h"
+
+#include <opencv2/core.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+static double nsPerOp(int threads, long long ops, const std::function<void(int)>& body) {
+    long long start = cv::getTickCount();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) { workers.emplace_back(body, t); }
+    for (std::thread& w : workers) { w.join(); }
+    return ((double)(cv::getTickCount() - start) / cv::getTickFrequency()) * 1e9 / ops;
+}
+
+static void benchMetrics(const BenchOptions& opt) {
+    const long long per_thread = opt.quick ? 200000 : 2000000;
+    LatencyHistogram histogram;
+    Counter counter;
+
+    std::printf("%8s %14s %14s\n", "threads", "observe ns", "add ns");
+    for (int threads : {1, 2, 4, 8}) {
+        histogram.reset(); counter.reset();
+        double observe_ns = nsPerOp(threads, per_thread * threads, [&](int t) {
+            double ms = 0.05 * (t + 1);
+            for (long long i = 0; i < per_thread; ++i) { histogram.observe(ms); ms = ms < 500 ? ms * 1.7 : 0.05; }
+        });
+        double add_ns = nsPerOp(threads, per_thread * threads, [&](int) {
+            for (long long i = 0; i < per_thread; ++i) { counter.add(); }
+        });
+        std::printf("%8d %14.1f %14.1f\n", threads, observe_ns, add_ns);
+        benchRecord(cv::format("observe_ns[threads=%d]", threads), observe_ns, "ns");
+    }
+    LatencyHistogram::Snapshot s = histogram.snapshot();
+    std::printf("last run: %llu observations, p50 %.2f ms, p99 %.2f ms\n", (unsigned long long)s.count, s.quantile(0.5), s.quantile(0.99));
+
+    const LogLevel saved = Log::level();
+    Log::setLevel(LogLevel::Info);
+    int id = 0;
+    double log_ns = nsPerOp(1, per_thread, [&](int) {
+        for (long long i = 0; i < per_thread; ++i) { LOG_DEBUG("Moved Track ID " << id++ << " to lost tracks."); }
+    });
+    Log::setLevel(saved);
+    std::printf("LOG_DEBUG while off: %.2f ns/call\n", log_ns);
+}
+
+static void benchEvents(const BenchOptions& opt) {
+    const long long events = opt.quick ? 200000 : 2000000;
+    const std::string path = cv::tempfile(".jsonl");
+    TrackEvent e;
+    e.type = EventType::ZoneEnter; e.class_id = 0; e.zone = 0; e.box = cv::Rect(412, 96, 58, 131);
+
+    std::printf("%10s %12s %12s %12s\n", "ring", "publish ns", "written", "dropped");
+    for (size_t capacity : {(size_t)256, (size_t)4096, (size_t)65536}) {
+        std::remove(path.c_str());
+        EventBus bus(capacity, cv::format("bench%zu", capacity));
+        EventLogWriter log;
+        if (!log.start(path, {&bus}, 5.0)) { std::printf("could not write %s\n", path.c_str()); return; }
+        long long start = cv::getTickCount();
+        for (long long i = 0; i < events; ++i) { e.track_id = (int)(i & 1023); e.frame_index = i / 16; bus.publish(e); }
+        double ns = ((double)(cv::getTickCount() - start) / cv::getTickFrequency()) * 1e9 / events;
+        log.stop();
+        std::printf("%10zu %12.1f %12llu %12llu\n", capacity, ns, (unsigned long long)log.written(), (unsigned long long)bus.dropped());
+        benchRecord(cv::format("publish_ns[ring=%zu]", capacity), ns, "ns");
+    }
+    std::ifstream in(path, std::ios::ate);
+    std::printf("last log: %.0f bytes\n", (double)in.tellg());
+    std::remove(path.c_str());
+}
+
+REGISTER_BENCH("metrics", benchMetrics);
+REGISTER_BENCH("events", benchEvents);
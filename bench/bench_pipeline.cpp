@@ -0,0 +1,412 @@
+// Pipeline pieces in isolation and together:
+//  - iou: TrackingPipeline::calculateIoU on random box pairs
+//  - associate: a full associateAndTrack() call (matching, motion-model
+//    corrections, tracker init for new tracks) on synthetic detections
+//  - end_to_end: a generated clip written to disk and read back through
+//    cv::VideoCapture, then capture -> track -> detect -> associate ->
+//    overlay per frame. The network is replaced by the clip's ground truth
+//    (jittered, with misses) so it runs without weights; when
+//    yolov4-tiny.weights is in the data folder, processFrame() with the real
+//    network is timed as well.
+//  - replay: a detection trace written from the same synthetic detections,
+//    then replayed with no video (motion model only) and with decoded
+//    frames; replay is run twice to check the tracks come out identical.
+//  - overlay_sidecar: what record_raw moves off the worker. drawOverlay() on
+//    a 1080p frame against flattening the same overlay and writing it to a
+//    sidecar, plus sidecar size and random-access read time.
+//  - preroll: record_on_alert's in-memory ring. JPEG encode per pushed frame,
+//    memory held for a full 5 s pre-roll, and the decode cost of flushing it
+//    into an incident file, at 720p and 1080p.
+//  - preroll_incident: a RecordingWriter with record_on_alert fed at 30 fps
+//    in real time, quiet for the whole pre-roll and then alerting, so the
+//    pre-roll flush overlaps live frames. Reports frames dropped (expected
+//    0) and how full the recorder queue got.
+
+#include "BenchHarness.h"
+#include "DetectionTrace.h"
+#include "Metrics.h"
+#include "OverlaySidecar.h"
+#include "PrerollBuffer.h"
+#include "RecordingWriter.h"
+#include "SyntheticScene.h"
+#include "TrackingPipeline.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// What a detector would report for `frame_index`: every box jittered by a
+// few pixels, about one in ten missed
+static void syntheticDetections(const SyntheticScene& scene, int frame_index, cv::RNG& rng, std::vector<cv::Rect>& boxes, std::vector<int>& class_ids) {
+    boxes.clear(); class_ids.clear();
+    for (const cv::Rect& truth : scene.boxesAt(frame_index)) {
+        if (rng.uniform(0.f, 1.f) < 0.1f) continue;
+        cv::Rect b = truth;
+        b.x += rng.uniform(-3, 4); b.y += rng.uniform(-3, 4);
+        b.width += rng.uniform(-2, 3); b.height += rng.uniform(-2, 3);
+        boxes.push_back(b & cv::Rect(cv::Point(), scene.frameSize()));
+        class_ids.push_back(0); // "person"
+    }
+}
+
+static double msSince(long long tick) {
+    return ((double)(cv::getTickCount() - tick) / cv::getTickFrequency()) * 1000;
+}
+
+static void benchIoU(const BenchOptions& opt) {
+    const int pairs = 4096;
+    const int iters = opt.quick ? 100 : 1000;
+    cv::RNG rng(3);
+    std::vector<cv::Rect> a(pairs), b(pairs);
+    for (int i = 0; i < pairs; ++i) {
+        a[i] = cv::Rect(rng.uniform(0, 1800), rng.uniform(0, 1000), rng.uniform(20, 120), rng.uniform(20, 120));
+        b[i] = a[i] + cv::Point(rng.uniform(-60, 61), rng.uniform(-60, 61)); // About half overlap
+    }
+    double sum = 0.0;
+    long long t0 = cv::getTickCount();
+    for (int it = 0; it < iters; ++it)
+        for (int i = 0; i < pairs; ++i) { sum += TrackingPipeline::calculateIoU(a[i], b[i]); }
+    double ns = msSince(t0) * 1e6 / ((double)iters * pairs);
+    std::printf("%12s %12s\n", "ns/call", "mean_iou");
+    std::printf("%12.2f %12.4f\n", ns, sum / ((double)iters * pairs));
+    benchRecord("ns_per_call", ns, "ns");
+}
+
+static void benchAssociate(const BenchOptions& opt) {
+    const std::vector<int> counts = opt.quick ? std::vector<int>{10, 40} : std::vector<int>{10, 40, 160};
+    const int iters = opt.quick ? 20 : 100;
+
+    std::printf("%8s %14s %14s %8s\n", "tracks", "match_us", "create_us", "alive");
+    for (int n : counts) {
+        SyntheticScene scene(cv::Size(1920, 1080), n, 9);
+        PipelineConfig cfg;
+        cfg.data_path = opt.data_dir;
+        cfg.async_detection = false;
+        TrackingPipeline pipeline(cfg);
+        if (!pipeline.loadClassNames()) { std::printf("coco.names not found in %s\n", opt.data_dir.c_str()); return; }
+        cv::Mat frame;
+        scene.render(0, frame);
+        const std::vector<cv::Rect> truth = scene.boxesAt(0);
+        const std::vector<int> classes(n, 0);
+        cv::RNG rng(11);
+        std::vector<cv::Rect> boxes; std::vector<int> class_ids;
+
+        // Every detection new: one tracker init per box (trackers recycled after the first reset)
+        double create_ms = 0.0;
+        for (int it = 0; it < iters; ++it) {
+            pipeline.reset();
+            long long t0 = cv::getTickCount();
+            pipeline.associateAndTrack(frame, truth, classes);
+            create_ms += msSince(t0);
+        }
+        // Every detection matches a live track: assignment and motion-model corrections
+        double match_ms = 0.0;
+        for (int it = 0; it < iters; ++it) {
+            syntheticDetections(scene, 0, rng, boxes, class_ids);
+            long long t0 = cv::getTickCount();
+            pipeline.associateAndTrack(frame, boxes, class_ids);
+            match_ms += msSince(t0);
+        }
+        std::printf("%8d %14.1f %14.1f %8zu\n", n, match_ms * 1000 / iters, create_ms * 1000 / iters, pipeline.activeTrackCount());
+        benchRecord(cv::format("match_us[tracks=%d]", n), match_ms * 1000 / iters, "us");
+        benchRecord(cv::format("create_us[tracks=%d]", n), create_ms * 1000 / iters, "us");
+    }
+}
+
+static void printStage(PipelineStage stage) {
+    LatencyHistogram::Snapshot h = stageLatency(stage).snapshot();
+    if (h.count == 0) return;
+    std::printf("  %-10s %8llu calls %9.3f mean %9.3f p50 %9.3f p99 ms\n", stageName(stage), (unsigned long long)h.count,
+                h.mean(), h.quantile(0.5), h.quantile(0.99));
+}
+
+static void benchEndToEnd(const BenchOptions& opt) {
+    const int frames = opt.quick ? 60 : 300;
+    const int objects = 20;
+    SyntheticScene scene(cv::Size(1280, 720), objects, 21);
+    const std::string clip = cv::tempfile(".avi");
+    if (!scene.writeClip(clip, frames)) { std::printf("could not write a test clip to %s (no MJPG encoder?)\n", clip.c_str()); return; }
+
+    PipelineConfig cfg;
+    cfg.data_path = opt.data_dir;
+    cfg.async_detection = false;
+    TrackingPipeline pipeline(cfg);
+    if (!pipeline.loadClassNames()) { std::printf("coco.names not found in %s\n", opt.data_dir.c_str()); std::remove(clip.c_str()); return; }
+    pipeline.setDrawTrajectory(true);
+
+    // --- Ground truth standing in for the network ---
+    cv::VideoCapture cap;
+    if (!cap.open(clip)) { std::printf("could not read back %s\n", clip.c_str()); std::remove(clip.c_str()); return; }
+    pipeline.reset();
+    MetricsRegistry::global().reset();
+    cv::RNG rng(5);
+    cv::Mat frame;
+    std::vector<cv::Rect> boxes; std::vector<int> class_ids;
+    std::vector<TrackOverlay> overlay;
+    StageTimings timings;
+    std::vector<double> frame_ms;
+    int detections = 0;
+    long long start = cv::getTickCount();
+    for (int f = 0; f < frames; ++f) {
+        long long t0 = cv::getTickCount();
+        if (!cap.read(frame) || frame.empty()) break;
+        pipeline.setCaptureTime(msSince(t0));
+        pipeline.updateTracks(frame);
+        if (pipeline.shouldDetect(frame, f)) {
+            syntheticDetections(scene, f, rng, boxes, class_ids);
+            pipeline.associateAndTrack(frame, boxes, class_ids);
+            detections++;
+        }
+        pipeline.collectOverlay(overlay);
+        pipeline.drawOverlay(frame, overlay, f, timings, 30.0);
+        frame_ms.push_back(msSince(t0));
+    }
+    double wall_sec = msSince(start) / 1000;
+    cap.release();
+    std::sort(frame_ms.begin(), frame_ms.end());
+    const double fps = wall_sec > 0 ? frame_ms.size() / wall_sec : 0.0;
+    const double p95 = frame_ms.empty() ? 0.0 : frame_ms[std::min(frame_ms.size() - 1, (size_t)(frame_ms.size() * 0.95))];
+    std::printf("ground-truth detector: %zu frames, %d detection frames, %.1f fps, p95 %.2f ms/frame, %zu tracks alive\n",
+                frame_ms.size(), detections, fps, p95, pipeline.activeTrackCount());
+    for (PipelineStage s : {PipelineStage::Capture, PipelineStage::Track, PipelineStage::Associate, PipelineStage::Draw}) { printStage(s); }
+    benchRecord("fps[detector=truth]", fps, "fps", false);
+    benchRecord("p95_frame_ms[detector=truth]", p95, "ms");
+
+    // --- Real network, when the weights are there ---
+    if (std::ifstream(opt.data_dir + "yolov4-tiny.weights").good() && pipeline.loadNetwork() && cap.open(clip)) {
+        pipeline.reset();
+        MetricsRegistry::global().reset();
+        frame_ms.clear();
+        start = cv::getTickCount();
+        while (cap.read(frame) && !frame.empty()) {
+            long long t0 = cv::getTickCount();
+            pipeline.processFrame(frame, t0);
+            frame_ms.push_back(msSince(t0));
+        }
+        wall_sec = msSince(start) / 1000;
+        cap.release();
+        std::sort(frame_ms.begin(), frame_ms.end());
+        const double net_fps = wall_sec > 0 ? frame_ms.size() / wall_sec : 0.0;
+        std::printf("yolov4-tiny: %zu frames, %.1f fps, p95 %.2f ms/frame\n", frame_ms.size(), net_fps,
+                    frame_ms.empty() ? 0.0 : frame_ms[std::min(frame_ms.size() - 1, (size_t)(frame_ms.size() * 0.95))]);
+        for (int s = 0; s < (int)PipelineStage::Count; ++s) { printStage((PipelineStage)s); }
+        benchRecord("fps[detector=yolov4-tiny]", net_fps, "fps", false);
+    } else {
+        std::printf("(yolov4-tiny.weights not found: network run skipped)\n");
+    }
+    std::remove(clip.c_str());
+}
+
+// Replays `trace_path` once; returns frames/s and a hash of every frame's track boxes
+static double replayTrace(const BenchOptions& opt, const std::string& trace_path, const std::string& clip, uint64_t& hash) {
+    DetectionTraceReader trace;
+    if (!trace.open(trace_path)) return 0.0;
+    PipelineConfig cfg;
+    cfg.data_path = opt.data_dir;
+    cfg.async_detection = false;
+    if (clip.empty()) { cfg.tracker_engine = TrackerEngine::MotionOnly; }
+    TrackingPipeline pipeline(cfg);
+    if (!pipeline.loadClassNames()) return 0.0;
+    cv::VideoCapture cap;
+    if (!clip.empty() && !cap.open(clip)) return 0.0;
+    cv::Mat frame;
+    if (clip.empty()) { frame = cv::Mat::zeros(trace.header().frame_size, CV_8UC3); }
+    Detections dets;
+    std::vector<TrackOverlay> overlay;
+    long long record_frame = -1, timestamp_us = 0, frames = 0;
+    bool more = trace.next(record_frame, timestamp_us, dets);
+    hash = 1469598103934665603ull; // FNV-1a over id and box of every track, every frame
+    auto mix = [&hash](int v) { hash = (hash ^ (uint32_t)v) * 1099511628211ull; };
+    long long start = cv::getTickCount();
+    for (long long f = 0; ; ++f) {
+        if (!clip.empty()) { if (!cap.read(frame) || frame.empty()) break; }
+        else if (!more) break;
+        pipeline.updateTracks(frame);
+        while (more && record_frame <= f) { pipeline.associateAndTrack(frame, dets.boxes, dets.classIds); more = trace.next(record_frame, timestamp_us, dets); }
+        pipeline.collectOverlay(overlay);
+        for (const TrackOverlay& t : overlay) { mix(t.id); mix(t.boundingBox.x); mix(t.boundingBox.y); mix(t.boundingBox.width); mix(t.boundingBox.height); }
+        frames++;
+    }
+    double sec = msSince(start) / 1000;
+    return sec > 0 ? frames / sec : 0.0;
+}
+
+static void benchReplay(const BenchOptions& opt) {
+    const int frames = opt.quick ? 120 : 600;
+    const int interval = 5; // A detection run every 5 frames
+    SyntheticScene scene(cv::Size(1280, 720), 20, 33);
+    const std::string trace_path = cv::tempfile(".trace");
+    const std::string clip = cv::tempfile(".avi");
+
+    // --- Record ---
+    DetectionTraceWriter writer;
+    if (!writer.open(trace_path, scene.frameSize(), 30.0)) { std::printf("could not write %s\n", trace_path.c_str()); return; }
+    cv::RNG rng(7);
+    Detections dets;
+    long long t0 = cv::getTickCount();
+    for (int f = 0; f < frames; f += interval) {
+        syntheticDetections(scene, f, rng, dets.boxes, dets.classIds);
+        dets.confidences.assign(dets.boxes.size(), 0.9f);
+        writer.write(f, dets);
+    }
+    const double write_us = msSince(t0) * 1000 / writer.records();
+    writer.close();
+    std::ifstream in(trace_path, std::ios::binary | std::ios::ate);
+    const double bytes = (double)in.tellg();
+    std::printf("trace: %llu runs, %.0f bytes (%.1f bytes/run), %.2f us/run to write\n",
+                (unsigned long long)writer.records(), bytes, bytes / writer.records(), write_us);
+    benchRecord("write_us_per_run", write_us, "us");
+
+    // --- Replay ---
+    uint64_t first = 0, second = 0;
+    const double motion_fps = replayTrace(opt, trace_path, std::string(), first);
+    replayTrace(opt, trace_path, std::string(), second);
+    std::printf("no video:   %10.0f fps  %s\n", motion_fps, first == second ? "deterministic" : "TRACKS DIFFER between runs");
+    benchRecord("fps[video=none]", motion_fps, "fps", false);
+    if (scene.writeClip(clip, frames)) {
+        const double video_fps = replayTrace(opt, trace_path, clip, first);
+        replayTrace(opt, trace_path, clip, second);
+        std::printf("with video: %10.0f fps  %s\n", video_fps, first == second ? "deterministic" : "TRACKS DIFFER between runs");
+        benchRecord("fps[video=decoded]", video_fps, "fps", false);
+        std::remove(clip.c_str());
+    }
+    std::remove(trace_path.c_str());
+}
+
+static void benchOverlaySidecar(const BenchOptions& opt) {
+    const int frames = opt.quick ? 60 : 300;
+    const std::vector<int> counts = opt.quick ? std::vector<int>{20} : std::vector<int>{5, 20, 80};
+    PipelineConfig cfg;
+    cfg.data_path = opt.data_dir;
+    TrackingPipeline pipeline(cfg);
+    pipeline.loadClassNames();
+    std::printf("%8s %14s %16s %14s %14s\n", "tracks", "draw_ms", "sidecar_us", "bytes/frame", "read_us");
+    for (int n : counts) {
+        SyntheticScene scene(cv::Size(1920, 1080), n, 11);
+        cv::Mat frame;
+        scene.render(0, frame);
+        std::vector<TrackOverlay> overlay(n);
+        std::vector<SidecarTrack> flat;
+        const std::string path = cv::tempfile(".tracks");
+        OverlaySidecarWriter writer;
+        if (!writer.open(path, scene.frameSize(), 30.0)) { std::printf("could not write %s\n", path.c_str()); return; }
+        StageTimings t;
+        double draw_ms = 0.0, write_ms = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            const std::vector<cv::Rect> boxes = scene.boxesAt(f);
+            for (int i = 0; i < n; ++i) {
+                TrackOverlay& item = overlay[i];
+                item.id = i; item.classId = 0; item.boundingBox = boxes[i]; item.velocity = 42.0; item.in_zone = i % 4 == 0;
+                item.trajectory.assign(cfg.trajectory_length, cv::Point(boxes[i].x, boxes[i].y));
+            }
+            cv::Mat canvas = frame.clone();
+            long long t0 = cv::getTickCount();
+            pipeline.drawOverlay(canvas, overlay, f, t, 30.0);
+            draw_ms += msSince(t0);
+            t0 = cv::getTickCount();
+            toSidecar(overlay, flat);
+            writer.write(f, 0, flat);
+            write_ms += msSince(t0);
+        }
+        writer.close();
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        const double bytes = (double)in.tellg() / frames;
+
+        OverlaySidecarReader reader;
+        double read_us = 0.0;
+        if (reader.open(path) && reader.frameCount() == (size_t)frames) {
+            SidecarFrame record;
+            cv::RNG rng(3);
+            long long t0 = cv::getTickCount();
+            for (int i = 0; i < frames; ++i) { reader.read((size_t)rng.uniform(0, frames), record); } // Seek pattern of a scrubbing reviewer
+            read_us = msSince(t0) * 1000 / frames;
+        }
+        reader.close();
+        std::remove(path.c_str());
+        std::printf("%8d %14.3f %16.2f %14.0f %14.2f\n", n, draw_ms / frames, write_ms * 1000 / frames, bytes, read_us);
+        benchRecord(cv::format("draw_ms[tracks=%d]", n), draw_ms / frames, "ms");
+        benchRecord(cv::format("sidecar_us[tracks=%d]", n), write_ms * 1000 / frames, "us");
+        benchRecord(cv::format("read_us[tracks=%d]", n), read_us, "us");
+    }
+}
+
+static void benchPreroll(const BenchOptions& opt) {
+    const int preroll_frames = 150; // 5 s at 30 fps
+    const int frames = opt.quick ? preroll_frames + 30 : preroll_frames * 2;
+    const std::vector<cv::Size> sizes = {cv::Size(1280, 720), cv::Size(1920, 1080)};
+    const PipelineConfig cfg;
+    std::printf("%10s %12s %14s %12s %14s\n", "size", "push_ms", "held_mb", "limit_mb", "flush_ms");
+    for (const cv::Size& size : sizes) {
+        SyntheticScene scene(size, 20, 5);
+        PrerollBuffer preroll;
+        preroll.configure(preroll_frames, (size_t)cfg.record_preroll_bytes, cfg.record_preroll_quality);
+        std::vector<SidecarTrack> tracks;
+        cv::Mat frame;
+        double push_ms = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            scene.render(f, frame);
+            long long t0 = cv::getTickCount();
+            preroll.push(frame, f, 0, tracks);
+            push_ms += msSince(t0);
+        }
+        cv::Mat decoded;
+        long long t0 = cv::getTickCount();
+        for (size_t i = 0; i < preroll.size(); ++i) { preroll.decode(i, decoded); }
+        const double flush_ms = msSince(t0);
+        const double held_mb = preroll.highWater() / 1048576.0;
+        const std::string label = cv::format("%dp", size.height);
+        std::printf("%10s %12.3f %14.1f %12.1f %14.1f\n", label.c_str(), push_ms / frames, held_mb, preroll.maxBytes() / 1048576.0, flush_ms);
+        benchRecord(cv::format("push_ms[size=%s]", label.c_str()), push_ms / frames, "ms");
+        benchRecord(cv::format("held_mb[size=%s]", label.c_str()), held_mb, "MB");
+        benchRecord(cv::format("flush_ms[size=%s]", label.c_str()), flush_ms, "ms");
+    }
+}
+
+static void benchPrerollIncident(const BenchOptions& opt) {
+    const double fps = 30.0;
+    const std::vector<cv::Size> sizes = opt.quick ? std::vector<cv::Size>{cv::Size(1280, 720)}
+                                                  : std::vector<cv::Size>{cv::Size(1280, 720), cv::Size(1920, 1080)};
+    PipelineConfig cfg;
+    cfg.record_on_alert = true;
+    const int quiet = (int)std::ceil(cfg.record_preroll_seconds * fps) + 30; // Pre-roll full before the alert
+    const int alerting = opt.quick ? 90 : 150;
+    std::vector<TrackOverlay> overlay(1);
+    overlay[0].zone_alert = true;
+
+    std::printf("%10s %10s %10s %10s %12s %10s\n", "size", "fed", "written", "dropped", "queue_high", "capacity");
+    for (const cv::Size& size : sizes) {
+        SyntheticScene scene(size, 20, 5);
+        RecordingWriter writer(cfg);
+        const std::string base = cv::tempfile("");
+        if (!writer.open(base, fps, size)) { std::printf("could not open recorder at %s\n", base.c_str()); return; }
+        auto next = std::chrono::steady_clock::now();
+        for (int f = 0; f < quiet + alerting; ++f) {
+            cv::Mat frame; // Fresh pixels: the recorder keeps the previous ones while queued
+            scene.render(f, frame);
+            writer.write(frame, f >= quiet ? &overlay : nullptr, f);
+            next += std::chrono::microseconds((long long)(1e6 / fps));
+            std::this_thread::sleep_until(next);
+        }
+        writer.close();
+        const RecordingStats st = writer.stats();
+        const std::string label = cv::format("%dp", size.height);
+        std::printf("%10s %10d %10llu %10llu %12zu %10zu\n", label.c_str(), quiet + alerting, (unsigned long long)st.frames_written,
+                    (unsigned long long)st.frames_dropped, st.queue_high_water, st.queue_capacity);
+        benchRecord(cv::format("incident_dropped[size=%s]", label.c_str()), (double)st.frames_dropped, "frames");
+        for (const std::string& path : writer.segmentPaths()) { std::remove(path.c_str()); }
+    }
+}
+
+REGISTER_BENCH("iou", benchIoU);
+REGISTER_BENCH("associate", benchAssociate);
+REGISTER_BENCH("end_to_end", benchEndToEnd);
+REGISTER_BENCH("replay", benchReplay);
+REGISTER_BENCH("overlay_sidecar", benchOverlaySidecar);
+REGISTER_BENCH("preroll", benchPreroll);
+REGISTER_BENCH("preroll_incident", benchPrerollIncident);
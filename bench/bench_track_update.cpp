@@ -0,0 +1,150 @@
+// Tracker update scaling: TrackUpd time vs. track count and thread count,
+// for MosseTracker on the shared grayscale frame and for the legacy MOSSE
+// wrapper that converts the full frame once per track. track_predict then
+// trades appearance updates for motion-model prediction (appearance_interval)
+// and reports what that costs in box accuracy against ground truth.
+// track_scale does the same for processing_scale: trackers on a shrunk
+// 1080p frame (the shrink included in the time), accuracy measured on the
+// native boxes.
+
+#include "BenchHarness.h"
+#include "SyntheticScene.h"
+#include "TrackingPipeline.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static void benchTrackUpdate(const BenchOptions& opt) {
+    const std::vector<int> track_counts = opt.quick ? std::vector<int>{10, 40} : std::vector<int>{10, 20, 40, 80, 160};
+    std::vector<int> thread_counts = {1};
+    for (int t = 2; t <= cv::getNumberOfCPUs(); t *= 2) { thread_counts.push_back(t); }
+    const int frames = opt.quick ? 20 : 100;
+    const int saved_threads = cv::getNumThreads();
+
+    std::printf("%8s %8s %8s %12s %10s %8s\n", "engine", "tracks", "threads", "upd_ms/frm", "speedup", "alive");
+    for (TrackerEngine engine : {TrackerEngine::SharedMosse, TrackerEngine::LegacyMosse})
+    for (int n : track_counts) {
+        SyntheticScene scene(cv::Size(1280, 720), n, 7);
+        double serial_ms = 0.0;
+        for (int threads : thread_counts) {
+            cv::setNumThreads(threads);
+            PipelineConfig cfg;
+            cfg.data_path = opt.data_dir;
+            cfg.async_detection = false;
+            cfg.parallel_track_update = threads > 1;
+            cfg.tracker_engine = engine;
+            TrackingPipeline pipeline(cfg);
+            if (!pipeline.loadClassNames()) { std::printf("coco.names not found in %s\n", opt.data_dir.c_str()); return; }
+            pipeline.reset();
+
+            cv::Mat frame;
+            scene.render(0, frame);
+            pipeline.associateAndTrack(frame, scene.boxesAt(0), std::vector<int>(n, 0));
+
+            double total_ms = 0.0;
+            for (int f = 1; f <= frames; ++f) {
+                scene.render(f, frame);
+                pipeline.updateTracks(frame);
+                total_ms += pipeline.lastTimings().tracker_update_ms;
+            }
+            double per_frame = total_ms / frames;
+            if (threads == 1) serial_ms = per_frame;
+            std::printf("%8s %8d %8d %12.3f %9.2fx %8zu\n", engine == TrackerEngine::SharedMosse ? "shared" : "legacy", n, threads, per_frame,
+                        per_frame > 0 ? serial_ms / per_frame : 0.0, pipeline.activeTrackCount());
+            benchRecord(cv::format("update_ms[engine=%s,tracks=%d,threads=%d]", engine == TrackerEngine::SharedMosse ? "shared" : "legacy", n, threads),
+                        per_frame, "ms");
+        }
+    }
+    cv::setNumThreads(saved_threads);
+}
+
+// One clip through updateTracks() with trackers seeded from frame 0's ground
+// truth; track i was created from object i and is scored against it
+struct ClipResult {
+    double update_ms = 0.0;     // TrackUpd per frame
+    double centre_error = 0.0;  // Mean centre distance, pixels
+    double iou = 0.0;           // Mean IoU with the ground truth box
+    size_t alive = 0;           // Active tracks after the last frame
+};
+
+static bool runClip(const BenchOptions& opt, const SyntheticScene& scene, int n, int frames, PipelineConfig cfg, ClipResult& r) {
+    cfg.data_path = opt.data_dir;
+    cfg.async_detection = false;
+    cfg.parallel_track_update = false;
+    TrackingPipeline pipeline(cfg);
+    if (!pipeline.loadClassNames()) { std::printf("coco.names not found in %s\n", opt.data_dir.c_str()); return false; }
+    pipeline.reset();
+
+    cv::Mat frame;
+    scene.render(0, frame);
+    pipeline.associateAndTrack(frame, scene.boxesAt(0), std::vector<int>(n, 0));
+
+    double total_ms = 0.0, err_sum = 0.0, iou_sum = 0.0; long long err_count = 0;
+    for (int f = 1; f <= frames; ++f) {
+        scene.render(f, frame);
+        pipeline.updateTracks(frame);
+        total_ms += pipeline.lastTimings().tracker_update_ms;
+        const std::vector<cv::Rect> truth = scene.boxesAt(f);
+        const TrackStore& ts = pipeline.tracks();
+        for (int i = 0; i < n; ++i) {
+            int s = ts.findId(i);
+            if (s < 0 || ts.state[s] != TrackState::Active) continue;
+            err_sum += cv::norm(TrackingPipeline::getCenter(ts.bbox[s]) - TrackingPipeline::getCenter(truth[i]));
+            iou_sum += TrackingPipeline::calculateIoU(ts.bbox[s], truth[i]); err_count++;
+        }
+    }
+    r.update_ms = total_ms / frames;
+    r.centre_error = err_count ? err_sum / err_count : 0.0;
+    r.iou = err_count ? iou_sum / err_count : 0.0;
+    r.alive = pipeline.activeTrackCount();
+    return true;
+}
+
+static void benchTrackPredict(const BenchOptions& opt) {
+    const int n = opt.quick ? 20 : 40;
+    const int frames = opt.quick ? 30 : 150;
+    SyntheticScene scene(cv::Size(1280, 720), n, 7);
+
+    std::printf("%8s %8s %12s %10s %10s %8s\n", "tracks", "every_k", "upd_ms/frm", "speedup", "err_px", "alive");
+    double base_ms = 0.0;
+    for (int k : {1, 2, 4, 8}) {
+        PipelineConfig cfg;
+        cfg.appearance_interval = k;
+        ClipResult r;
+        if (!runClip(opt, scene, n, frames, cfg, r)) return;
+        if (k == 1) base_ms = r.update_ms;
+        std::printf("%8d %8d %12.3f %9.2fx %10.2f %8zu\n", n, k, r.update_ms, r.update_ms > 0 ? base_ms / r.update_ms : 0.0,
+                    r.centre_error, r.alive);
+        benchRecord(cv::format("update_ms[k=%d]", k), r.update_ms, "ms");
+        benchRecord(cv::format("centre_error_px[k=%d]", k), r.centre_error, "px");
+    }
+}
+
+static void benchTrackScale(const BenchOptions& opt) {
+    const int n = opt.quick ? 20 : 40;
+    const int frames = opt.quick ? 30 : 150;
+    const std::vector<double> scales = opt.quick ? std::vector<double>{1.0, 0.5} : std::vector<double>{1.0, 0.75, 0.5, 0.35, 0.25};
+    SyntheticScene scene(cv::Size(1920, 1080), n, 7); // Same clip for every scale
+
+    std::printf("%8s %8s %12s %10s %10s %10s %8s\n", "tracks", "scale", "upd_ms/frm", "speedup", "err_px", "iou", "alive");
+    double base_ms = 0.0;
+    for (double scale : scales) {
+        PipelineConfig cfg;
+        cfg.processing_scale = scale;
+        ClipResult r;
+        if (!runClip(opt, scene, n, frames, cfg, r)) return;
+        if (scale >= 1.0) base_ms = r.update_ms;
+        std::printf("%8d %8.2f %12.3f %9.2fx %10.2f %10.3f %8zu\n", n, scale, r.update_ms, r.update_ms > 0 ? base_ms / r.update_ms : 0.0,
+                    r.centre_error, r.iou, r.alive);
+        benchRecord(cv::format("update_ms[scale=%.2f]", scale), r.update_ms, "ms");
+        benchRecord(cv::format("centre_error_px[scale=%.2f]", scale), r.centre_error, "px");
+        benchRecord(cv::format("iou[scale=%.2f]", scale), r.iou, "ratio", false);
+    }
+}
+
+REGISTER_BENCH("track_update", benchTrackUpdate);
+REGISTER_BENCH("track_predict", benchTrackPredict);
+REGISTER_BENCH("track_scale", benchTrackScale);
@@ -0,0 +1,108 @@
+// YOLO output decode: legacy minMaxLoc + NMSBoxes path vs. YoloDecoder.
+
+#include "BenchHarness.h"
+#include "TrackingPipeline.h"
+#include "YoloDecoder.h"
+
+#include <opencv2/dnn.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+// Fake YOLOv4-tiny head outputs: mostly background rows, a handful of
+// objects each reported by a small cluster of neighbouring anchors
+static std::vector<cv::Mat> makeOutputs(int input_size, int class_count, cv::RNG& rng) {
+    const int rows_a = (input_size / 32) * (input_size / 32) * 3;
+    const int rows_b = (input_size / 16) * (input_size / 16) * 3;
+    std::vector<cv::Mat> outs;
+    for (int rows : {rows_a, rows_b}) {
+        cv::Mat out(rows, 5 + class_count, CV_32F, cv::Scalar(0));
+        for (int r = 0; r < rows; ++r) {
+            float* row = out.ptr<float>(r);
+            row[0] = rng.uniform(0.f, 1.f); row[1] = rng.uniform(0.f, 1.f);
+            row[2] = rng.uniform(0.02f, 0.3f); row[3] = rng.uniform(0.02f, 0.3f);
+            float obj = rng.uniform(0.f, 1.f) < 0.03f ? rng.uniform(0.4f, 0.99f) : rng.uniform(0.f, 0.05f);
+            row[4] = obj;
+            for (int c = 0; c < class_count; ++c) { row[5 + c] = obj * rng.uniform(0.f, 0.2f); }
+            if (obj > 0.4f) { row[5 + rng.uniform(0, class_count)] = obj * rng.uniform(0.6f, 1.f); }
+        }
+        outs.push_back(out);
+    }
+    return outs;
+}
+
+// The decode TrackingPipeline used before YoloDecoder
+static void legacyDecode(const std::vector<cv::Mat>& outs, cv::Size img_size, const std::vector<std::string>& class_names,
+                         const PipelineConfig& cfg, Detections& out) {
+    out.clear();
+    std::vector<int> classIds; std::vector<float> confidences; std::vector<cv::Rect> boxes;
+    for (const auto& output : outs) {
+        const float* data = (float*)output.data;
+        for (int i = 0; i < output.rows; ++i, data += output.cols) {
+            cv::Mat scores = output.row(i).colRange(5, output.cols);
+            cv::Point classIdPoint; double confidence;
+            cv::minMaxLoc(scores, 0, &confidence, 0, &classIdPoint);
+            if (confidence > cfg.confidence_threshold) {
+                int centerX = (int)(data[0] * img_size.width); int centerY = (int)(data[1] * img_size.height);
+                int width = (int)(data[2] * img_size.width); int height = (int)(data[3] * img_size.height);
+                classIds.push_back(classIdPoint.x); confidences.push_back((float)confidence);
+                boxes.push_back(cv::Rect(centerX - width / 2, centerY - height / 2, width, height));
+            }
+        }
+    }
+    std::vector<int> indices;
+    cv::dnn::NMSBoxes(boxes, confidences, cfg.confidence_threshold, cfg.nms_threshold, indices);
+    for (int idx : indices) {
+        if (classIds[idx] >= 0 && classIds[idx] < (int)class_names.size() && cfg.desired_classes.count(class_names[classIds[idx]])) {
+            out.boxes.push_back(boxes[idx]); out.classIds.push_back(classIds[idx]); out.confidences.push_back(confidences[idx]);
+        }
+    }
+}
+
+static void benchYoloDecode(const BenchOptions& opt) {
+    PipelineConfig cfg;
+    cfg.data_path = opt.data_dir;
+    TrackingPipeline names_loader(cfg);
+    if (!names_loader.loadClassNames()) { std::printf("coco.names not found in %s\n", opt.data_dir.c_str()); return; }
+    const std::vector<std::string>& class_names = names_loader.classNames();
+    const int class_count = (int)class_names.size();
+    const int iters = opt.quick ? 50 : 500;
+
+    std::set<std::string> all_classes(class_names.begin(), class_names.end());
+    struct ClassSet { const char* name; std::set<std::string> classes; };
+    const std::vector<ClassSet> class_sets = {{"default", cfg.desired_classes}, {"all80", all_classes}};
+    const cv::Size frame_size(1280, 720);
+
+    std::printf("%6s %8s %7s %12s %12s %9s %7s %7s\n", "input", "classes", "rows", "legacy_us", "decoder_us", "speedup", "legacy", "new");
+    for (int input : {320, 608}) {
+        cv::RNG rng(1234);
+        std::vector<cv::Mat> outs = makeOutputs(input, class_count, rng);
+        int rows = 0;
+        for (const auto& o : outs) rows += o.rows;
+
+        for (const ClassSet& set : class_sets) {
+            PipelineConfig run_cfg = cfg;
+            run_cfg.desired_classes = set.classes;
+            YoloDecoder decoder;
+            decoder.configure(class_names, set.classes, run_cfg.confidence_threshold, run_cfg.nms_threshold);
+            Detections legacy_out, new_out;
+
+            long long t0 = cv::getTickCount();
+            for (int i = 0; i < iters; ++i) legacyDecode(outs, frame_size, class_names, run_cfg, legacy_out);
+            long long t1 = cv::getTickCount();
+            for (int i = 0; i < iters; ++i) decoder.decode(outs, frame_size, new_out);
+            long long t2 = cv::getTickCount();
+
+            double legacy_us = (double)(t1 - t0) / cv::getTickFrequency() * 1e6 / iters;
+            double new_us = (double)(t2 - t1) / cv::getTickFrequency() * 1e6 / iters;
+            std::printf("%6d %8s %7d %12.1f %12.1f %8.2fx %7zu %7zu\n", input, set.name, rows, legacy_us, new_us,
+                        new_us > 0 ? legacy_us / new_us : 0.0, legacy_out.boxes.size(), new_out.boxes.size());
+            benchRecord(cv::format("decoder_us[input=%d,classes=%s]", input, set.name), new_us, "us");
+        }
+    }
+}
+
+REGISTER_BENCH("yolo_decode", benchYoloDecode);
@@ -0,0 +1,73 @@
+// Zone membership per track: ZoneMap (one label-grid read per track) vs.
+// testing the track's foot point against every polygon, for 1..64
+// overlapping zones. Also times the one-off rasterisation per frame size.
+
+#include "BenchHarness.h"
+#include "ZoneMap.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Random convex-ish polygons (6 vertices round a centre), fractions of the frame
+static std::vector<Zone> randomZones(int count, cv::RNG& rng) {
+    std::vector<Zone> zones(count);
+    for (int z = 0; z < count; ++z) {
+        zones[z].name = "zone " + std::to_string(z);
+        cv::Point2f c(rng.uniform(0.1f, 0.9f), rng.uniform(0.1f, 0.9f));
+        float r = rng.uniform(0.05f, 0.3f);
+        for (int k = 0; k < 6; ++k) {
+            float a = (float)(k * CV_PI / 3), rk = r * rng.uniform(0.6f, 1.f);
+            zones[z].polygon.emplace_back(c.x + rk * std::cos(a), c.y + rk * std::sin(a));
+        }
+    }
+    return zones;
+}
+
+static void benchZones(const BenchOptions& opt) {
+    const cv::Size frame(1920, 1080);
+    const int tracks = 200;
+    const int frames = opt.quick ? 200 : 2000;
+    const std::vector<std::string> classes = {"person"};
+    cv::RNG rng(17);
+    std::vector<cv::Rect> boxes(tracks);
+    for (cv::Rect& b : boxes) { b = cv::Rect(rng.uniform(0, frame.width - 80), rng.uniform(0, frame.height - 160), 60, 150); }
+
+    std::printf("%6s %12s %14s %14s %10s\n", "zones", "raster_ms", "lookup_ns", "polygon_ns", "hits");
+    for (int count : {1, 4, 16, 64}) {
+        ZoneMap map;
+        map.setZones(randomZones(count, rng));
+        long long t0 = cv::getTickCount();
+        map.prepare(frame, classes);
+        double raster_ms = (double)(cv::getTickCount() - t0) / cv::getTickFrequency() * 1000;
+
+        uint64_t hits = 0;
+        t0 = cv::getTickCount();
+        for (int f = 0; f < frames; ++f)
+            for (const cv::Rect& b : boxes) { hits += map.lookup(b, 0) != 0; }
+        double lookup_ns = (double)(cv::getTickCount() - t0) / cv::getTickFrequency() * 1e9 / ((double)frames * tracks);
+
+        std::vector<std::vector<cv::Point>> polygons(count);
+        for (int z = 0; z < count; ++z) { ZoneMap::scaled(map.zones()[z], frame, polygons[z]); }
+        uint64_t naive_hits = 0;
+        const int naive_frames = std::max(1, frames / 10);
+        t0 = cv::getTickCount();
+        for (int f = 0; f < naive_frames; ++f)
+            for (const cv::Rect& b : boxes) {
+                const cv::Point2f foot((float)(b.x + b.width / 2), (float)(b.y + b.height - 1));
+                uint64_t mask = 0;
+                for (int z = 0; z < count; ++z) { if (cv::pointPolygonTest(polygons[z], foot, false) >= 0) mask |= (uint64_t)1 << z; }
+                naive_hits += mask != 0;
+            }
+        double polygon_ns = (double)(cv::getTickCount() - t0) / cv::getTickFrequency() * 1e9 / ((double)naive_frames * tracks);
+        std::printf("%6d %12.2f %14.1f %14.1f %10.3f\n", count, raster_ms, lookup_ns, polygon_ns, (double)hits / ((double)frames * tracks));
+        benchRecord(cv::format("lookup_ns[zones=%d]", count), lookup_ns, "ns");
+        benchRecord(cv::format("raster_ms[zones=%d]", count), raster_ms, "ms");
+    }
+}
+
+REGISTER_BENCH("zones", benchZones);
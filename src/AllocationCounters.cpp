@@ -0,0 +1,64 @@
+#include "AllocationCounters.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+
+// Constant-initialised, so safe to touch from operator new during static init
+static std::atomic<uint64_t> heap_allocs{0};
+static std::atomic<uint64_t> heap_bytes{0};
+static std::atomic<uint64_t> mat_allocs{0};
+static std::atomic<uint64_t> mat_bytes{0};
+static std::atomic<bool> heap_hooked{false};
+static std::atomic<bool> mat_installed{false};
+
+// Forwards to OpenCV's standard allocator and counts fresh buffers (not
+// Mats wrapping caller-owned data). Freed buffers go straight back to the
+// standard allocator, which it records as their owner.
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    explicit CountingMatAllocator(cv::MatAllocator* base) : base(base) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usage) const CV_OVERRIDE {
+        cv::UMatData* u = base->allocate(dims, sizes, type, data, step, flags, usage);
+        if (u && !data) {
+            mat_allocs.fetch_add(1, std::memory_order_relaxed);
+            mat_bytes.fetch_add(u->size, std::memory_order_relaxed);
+        }
+        return u;
+    }
+    bool allocate(cv::UMatData* data, cv::AccessFlag flags, cv::UMatUsageFlags usage) const CV_OVERRIDE {
+        return base->allocate(data, flags, usage);
+    }
+    void deallocate(cv::UMatData* data) const CV_OVERRIDE { base->deallocate(data); }
+
+private:
+    cv::MatAllocator* base;
+};
+
+void AllocationCounters::installMatAllocator() {
+    if (mat_installed.exchange(true)) return;
+    static CountingMatAllocator allocator(cv::Mat::getStdAllocator());
+    cv::Mat::setDefaultAllocator(&allocator);
+}
+
+bool AllocationCounters::matCountingEnabled() { return mat_installed.load(std::memory_order_relaxed); }
+bool AllocationCounters::heapCountingEnabled() { return heap_hooked.load(std::memory_order_relaxed); }
+
+AllocSnapshot AllocationCounters::snapshot() {
+    AllocSnapshot s;
+    s.heap_allocs = heap_allocs.load(std::memory_order_relaxed);
+    s.heap_bytes = heap_bytes.load(std::memory_order_relaxed);
+    s.mat_allocs = mat_allocs.load(std::memory_order_relaxed);
+    s.mat_bytes = mat_bytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+void AllocationCounters::recordHeap(size_t bytes) {
+    heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    heap_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void AllocationCounters::markHeapHooked() { heap_hooked.store(true, std::memory_order_relaxed); }
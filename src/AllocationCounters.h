@@ -0,0 +1,43 @@
+#ifndef ALLOCATIONCOUNTERS_H
+#define ALLOCATIONCOUNTERS_H
+
+// Process-wide allocation counters, used to check that steady-state frame
+// processing does not allocate.
+//  - Mat allocations are counted once installMatAllocator() has wrapped
+//    OpenCV's default allocator (covers frames, blobs and DNN outputs).
+//  - General heap allocations are only counted in executables that link
+//    HeapCounter.cpp, which replaces the global operator new.
+// Take a snapshot before and after a run of frames and divide the
+// difference by the frame count.
+
+#include <cstddef>
+#include <cstdint>
+
+struct AllocSnapshot {
+    uint64_t heap_allocs = 0;
+    uint64_t heap_bytes = 0;
+    uint64_t mat_allocs = 0;
+    uint64_t mat_bytes = 0;
+
+    AllocSnapshot operator-(const AllocSnapshot& o) const {
+        AllocSnapshot d;
+        d.heap_allocs = heap_allocs - o.heap_allocs; d.heap_bytes = heap_bytes - o.heap_bytes;
+        d.mat_allocs = mat_allocs - o.mat_allocs; d.mat_bytes = mat_bytes - o.mat_bytes;
+        return d;
+    }
+};
+
+class AllocationCounters
+{
+public:
+    static void installMatAllocator();  // Idempotent; call before any frame is processed
+    static bool matCountingEnabled();
+    static bool heapCountingEnabled();  // True when HeapCounter.cpp is linked in
+    static AllocSnapshot snapshot();
+
+    // Hooks for HeapCounter.cpp
+    static void recordHeap(size_t bytes);
+    static void markHeapHooked();
+};
+
+#endif // ALLOCATIONCOUNTERS_H
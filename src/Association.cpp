@@ -0,0 +1,205 @@
+#include "Association.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+// Cost of a component matrix cell with no edge (the pair failed the IoU or
+// gate test, so it was never added); larger than any set of real pairs
+static const double FORBIDDEN = 1e6;
+static const int MIN_CELL = 16;
+
+static double iou(const cv::Rect& a, const cv::Rect& b) {
+    double inter = (a & b).area();
+    if (inter <= 0) return 0.0;
+    double uni = (double)a.area() + b.area() - inter;
+    return uni > 0 ? inter / uni : 0.0;
+}
+
+// --- SpatialGrid ---
+// Dense cell array over the boxes' bounding area, stored CSR-style so a
+// rebuild is two linear passes and no per-cell allocation.
+static const int MAX_GRID_CELLS = 1 << 16;
+
+void SpatialGrid::build(const std::vector<cv::Rect>& boxes, int cell_size) {
+    cell = std::max(cell_size, 1);
+    cols = rows = 0;
+    cell_start.clear(); cell_items.clear();
+    stamp.assign(boxes.size(), -1);
+    stamp_gen = 0;
+
+    cv::Rect bounds;
+    bool any = false;
+    for (const cv::Rect& b : boxes) {
+        if (b.width <= 0 || b.height <= 0) continue; // Empty box never overlaps anything
+        bounds = any ? (bounds | b) : b; any = true;
+    }
+    if (!any) return;
+    // Coarsen the grid if boxes are spread far apart (keeps memory bounded)
+    while ((long long)(bounds.width / cell + 1) * (bounds.height / cell + 1) > MAX_GRID_CELLS) { cell *= 2; }
+    origin_x = bounds.x; origin_y = bounds.y;
+    cols = bounds.width / cell + 1; rows = bounds.height / cell + 1;
+
+    // Count, prefix-sum, fill
+    cell_start.assign((size_t)cols * rows + 1, 0);
+    for (const cv::Rect& b : boxes) {
+        if (b.width <= 0 || b.height <= 0) continue;
+        for (int cy = cellY(b.y); cy <= cellY(b.y + b.height - 1); ++cy)
+            for (int cx = cellX(b.x); cx <= cellX(b.x + b.width - 1); ++cx) { cell_start[cy * cols + cx + 1]++; }
+    }
+    for (size_t c = 1; c < cell_start.size(); ++c) { cell_start[c] += cell_start[c - 1]; }
+    cell_items.resize(cell_start.back());
+    cursor.assign(cell_start.begin(), cell_start.end() - 1);
+    for (int i = 0; i < (int)boxes.size(); ++i) {
+        const cv::Rect& b = boxes[i];
+        if (b.width <= 0 || b.height <= 0) continue;
+        for (int cy = cellY(b.y); cy <= cellY(b.y + b.height - 1); ++cy)
+            for (int cx = cellX(b.x); cx <= cellX(b.x + b.width - 1); ++cx) { cell_items[cursor[cy * cols + cx]++] = i; }
+    }
+}
+
+void SpatialGrid::query(const cv::Rect& q, std::vector<int>& out) {
+    out.clear();
+    if (q.width <= 0 || q.height <= 0 || cols == 0) return;
+    // Queries entirely outside the indexed area hit nothing
+    if (q.x + q.width <= origin_x || q.y + q.height <= origin_y ||
+        q.x >= origin_x + cols * cell || q.y >= origin_y + rows * cell) return;
+    stamp_gen++;
+    for (int cy = cellY(q.y); cy <= cellY(q.y + q.height - 1); ++cy) {
+        for (int cx = cellX(q.x); cx <= cellX(q.x + q.width - 1); ++cx) {
+            const int c = cy * cols + cx;
+            for (int k = cell_start[c]; k < cell_start[c + 1]; ++k) {
+                int idx = cell_items[k];
+                if (stamp[idx] != stamp_gen) { stamp[idx] = stamp_gen; out.push_back(idx); }
+            }
+        }
+    }
+}
+
+// --- Associator ---
+int Associator::find(int x) {
+    while (parent[x] != x) { parent[x] = parent[parent[x]]; x = parent[x]; }
+    return x;
+}
+
+void Associator::match(const std::vector<cv::Rect>& tracks, const std::vector<cv::Rect>& detections, double min_iou,
+                       std::vector<int>& det_to_track, const MotionGate* gate) {
+    const int T = (int)tracks.size(), D = (int)detections.size();
+    det_to_track.assign(D, -1);
+    stats = AssociationStats();
+    if (T == 0 || D == 0) return;
+
+    // 1. Candidate pairs: grid sized to the typical track box
+    sizes.clear();
+    for (const cv::Rect& t : tracks) { sizes.push_back(std::max(t.width, t.height)); }
+    std::nth_element(sizes.begin(), sizes.begin() + T / 2, sizes.end());
+    grid.build(tracks, std::max(MIN_CELL, sizes[T / 2]));
+
+    edges.clear();
+    for (int j = 0; j < D; ++j) {
+        grid.query(detections[j], candidates);
+        const cv::Rect& d = detections[j];
+        const cv::Point2f centre(d.x + d.width * 0.5f, d.y + d.height * 0.5f);
+        for (int i : candidates) {
+            double overlap = iou(tracks[i], d);
+            if (overlap <= min_iou) continue;
+            if (gate && gate->model[i].distance2(centre, gate->meas_var[i]) > gate->max_d2) { stats.gated_pairs++; continue; }
+            edges.push_back({i, j, 1.0 - overlap});
+        }
+    }
+    stats.candidate_pairs = (int)edges.size();
+    if (edges.empty()) return;
+
+    // 2. Split into connected components (tracks are nodes [0,T), detections [T,T+D))
+    parent.resize(T + D);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (const Edge& e : edges) {
+        int a = find(e.track), b = find(T + e.det);
+        if (a != b) { parent[std::max(a, b)] = std::min(a, b); }
+    }
+    comp_of_root.assign(T + D, -1);
+    int count = 0;
+    for (int k = 0; k < (int)edges.size(); ++k) {
+        int root = find(edges[k].track);
+        if (comp_of_root[root] < 0) {
+            comp_of_root[root] = count++;
+            if ((int)comp_edges.size() < count) { comp_edges.resize(count); comp_tracks.resize(count); comp_dets.resize(count); }
+            comp_edges[count - 1].clear(); comp_tracks[count - 1].clear(); comp_dets[count - 1].clear();
+        }
+        comp_edges[comp_of_root[root]].push_back(k);
+    }
+    stats.components = count;
+
+    // 3. Solve each component independently
+    local_index.assign(T + D, -1);
+    for (int c = 0; c < count; ++c) {
+        std::vector<int>& ct = comp_tracks[c];
+        std::vector<int>& cd = comp_dets[c];
+        for (int k : comp_edges[c]) {
+            const Edge& e = edges[k];
+            if (local_index[e.track] < 0) { local_index[e.track] = 0; ct.push_back(e.track); }
+            if (local_index[T + e.det] < 0) { local_index[T + e.det] = 0; cd.push_back(e.det); }
+        }
+        std::sort(ct.begin(), ct.end());
+        std::sort(cd.begin(), cd.end());
+        for (int r = 0; r < (int)ct.size(); ++r) { local_index[ct[r]] = r; }
+        for (int r = 0; r < (int)cd.size(); ++r) { local_index[T + cd[r]] = r; }
+        stats.largest_component = std::max(stats.largest_component, (int)(ct.size() + cd.size()));
+
+        // Rows are the smaller side so the solver always has rows <= cols
+        const bool transposed = ct.size() > cd.size();
+        const int rows = (int)(transposed ? cd.size() : ct.size());
+        const int cols = (int)(transposed ? ct.size() : cd.size());
+        cost.assign((size_t)rows * cols, FORBIDDEN);
+        for (int k : comp_edges[c]) {
+            const Edge& e = edges[k];
+            int ti = local_index[e.track], di = local_index[T + e.det];
+            if (transposed) cost[(size_t)di * cols + ti] = e.cost;
+            else cost[(size_t)ti * cols + di] = e.cost;
+        }
+        solve(rows, cols);
+        for (int r = 0; r < rows; ++r) {
+            int col = row_to_col[r];
+            if (col < 0 || cost[(size_t)r * cols + col] >= FORBIDDEN) continue;
+            if (transposed) det_to_track[cd[r]] = ct[col];
+            else det_to_track[cd[col]] = ct[r];
+        }
+    }
+}
+
+// Shortest augmenting path with dual potentials, one row at a time
+void Associator::solve(int rows, int cols) {
+    if (rows == 1) { // Most components are a single track/detection pair or fan
+        row_to_col.assign(1, (int)(std::min_element(cost.begin(), cost.begin() + cols) - cost.begin()));
+        return;
+    }
+    const double INF = std::numeric_limits<double>::infinity();
+    u.assign(rows + 1, 0.0); v.assign(cols + 1, 0.0);
+    p.assign(cols + 1, 0); way.assign(cols + 1, 0);
+    for (int i = 1; i <= rows; ++i) {
+        p[0] = i;
+        int j0 = 0;
+        minv.assign(cols + 1, INF);
+        used.assign(cols + 1, 0);
+        do {
+            used[j0] = 1;
+            int i0 = p[j0], j1 = 0;
+            double delta = INF;
+            const double* row = &cost[(size_t)(i0 - 1) * cols];
+            for (int j = 1; j <= cols; ++j) {
+                if (used[j]) continue;
+                double cur = row[j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) { minv[j] = cur; way[j] = j0; }
+                if (minv[j] < delta) { delta = minv[j]; j1 = j; }
+            }
+            for (int j = 0; j <= cols; ++j) {
+                if (used[j]) { u[p[j]] += delta; v[j] -= delta; }
+                else { minv[j] -= delta; }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do { int j1 = way[j0]; p[j0] = p[j1]; j0 = j1; } while (j0);
+    }
+    row_to_col.assign(rows, -1);
+    for (int j = 1; j <= cols; ++j) { if (p[j] > 0) row_to_col[p[j] - 1] = j - 1; }
+}
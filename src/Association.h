@@ -0,0 +1,103 @@
+#ifndef ASSOCIATION_H
+#define ASSOCIATION_H
+
+// Detection-to-track association for dense scenes.
+//
+// Track boxes are bucketed into a uniform grid so each detection is only
+// scored against tracks in the cells it touches (IoU > 0 needs overlap, so
+// no valid pair is ever pruned). Surviving pairs form a sparse bipartite
+// graph; each connected component is solved on its own with a
+// shortest-augmenting-path (Hungarian / Jonker-Volgenant) assignment that
+// maximises the number of matches, then total IoU. Components, rows and
+// columns are always visited in a fixed order, so the same inputs always
+// give the same matches (unlike the old first-come greedy scan).
+// An optional motion gate additionally drops pairs whose detection centre
+// is implausibly far from where the track's motion model puts it.
+
+#include "MotionModel.h"
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class SpatialGrid
+{
+public:
+    // Bucket `boxes` into square cells of `cell_size` pixels
+    void build(const std::vector<cv::Rect>& boxes, int cell_size);
+
+    // Indices of boxes sharing at least one cell with `query`, each reported
+    // once, in a fixed order (cells row-major, then box index)
+    void query(const cv::Rect& query, std::vector<int>& out);
+
+private:
+    int cell = 64;
+    int origin_x = 0, origin_y = 0;   // Cell (0,0) top-left, in pixels
+    int cols = 0, rows = 0;
+    std::vector<int> cell_start;      // CSR offsets, cols * rows + 1
+    std::vector<int> cell_items;      // Box indices, ascending within a cell
+    std::vector<int> cursor;          // Fill position per cell during build()
+    std::vector<int> stamp;           // Per box: last query that reported it
+    int stamp_gen = 0;
+
+    int cellX(int x) const { return std::min(std::max((x - origin_x) / cell, 0), cols - 1); }
+    int cellY(int y) const { return std::min(std::max((y - origin_y) / cell, 0), rows - 1); }
+};
+
+// Per-track gate, indexed like the `tracks` passed to match(): a pair is
+// allowed if model.distance2(detection centre, meas_var) <= max_d2
+struct MotionGate {
+    std::vector<MotionModel> model;   // Track state
+    std::vector<float> meas_var;      // Variance of a detection centre for the track's box size
+    double max_d2 = 9.21;             // Chi-square, 2 dof (9.21 = 99%)
+
+    void clear() { model.clear(); meas_var.clear(); }
+};
+
+struct AssociationStats {
+    int candidate_pairs = 0;    // Pairs that passed the grid and the IoU gate
+    int gated_pairs = 0;        // Pairs that passed IoU but not the motion gate
+    int components = 0;         // Independent sub-problems solved
+    int largest_component = 0;  // Rows + columns of the biggest one
+};
+
+class Associator
+{
+public:
+    // det_to_track[j] = index into `tracks` matched to detections[j], or -1.
+    // Only pairs with IoU strictly above `min_iou` (and inside `gate`, if
+    // given) may be matched.
+    void match(const std::vector<cv::Rect>& tracks, const std::vector<cv::Rect>& detections, double min_iou,
+               std::vector<int>& det_to_track, const MotionGate* gate = nullptr);
+
+    const AssociationStats& lastStats() const { return stats; }
+
+private:
+    struct Edge { int track; int det; double cost; };
+
+    SpatialGrid grid;
+    AssociationStats stats;
+
+    // Reused scratch
+    std::vector<int> candidates;
+    std::vector<Edge> edges;
+    std::vector<int> parent;          // Union-find over tracks then detections
+    std::vector<int> comp_of_root;
+    std::vector<std::vector<int>> comp_tracks, comp_dets, comp_edges;
+    std::vector<int> local_index;
+    std::vector<int> sizes;
+    std::vector<double> cost;
+    std::vector<int> row_to_col;
+    std::vector<double> u, v, minv;
+    std::vector<int> p, way;
+    std::vector<char> used;
+
+    int find(int x);
+    // Rectangular assignment with rows <= cols; fills row_to_col
+    void solve(int rows, int cols);
+};
+
+#endif // ASSOCIATION_H
@@ -0,0 +1,78 @@
+#include "AsyncDetector.h"
+
+AsyncDetector::AsyncDetector(DetectFn fn) : detect_fn(std::move(fn))
+{
+    worker = std::thread(&AsyncDetector::run, this);
+}
+
+AsyncDetector::~AsyncDetector()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) { worker.join(); }
+}
+
+bool AsyncDetector::submit(cv::Mat blob, const std::vector<cv::Rect>& regions, long long frame_index, std::vector<std::pair<int, cv::Rect>> track_boxes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state.load(std::memory_order_relaxed) != Idle) { skipped_.fetch_add(1, std::memory_order_relaxed); return false; }
+        pending_blob = std::move(blob);
+        pending_regions.assign(regions.begin(), regions.end()); // Keeps capacity
+        pending_generation = generation;
+        pending = DetectionResult();
+        pending.frame_index = frame_index;
+        pending.track_boxes = std::move(track_boxes);
+        state.store(Pending, std::memory_order_release);
+    }
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    wake.notify_one();
+    return true;
+}
+
+bool AsyncDetector::poll(DetectionResult& out) {
+    if (state.load(std::memory_order_acquire) != Done) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state.load(std::memory_order_relaxed) != Done) return false;
+    out = std::move(result);
+    result = DetectionResult();
+    state.store(Idle, std::memory_order_release);
+    return true;
+}
+
+void AsyncDetector::discard() {
+    std::lock_guard<std::mutex> lock(mutex);
+    generation++;
+    int s = state.load(std::memory_order_relaxed);
+    if (s == Pending || s == Done) {
+        pending_blob.release(); result = DetectionResult();
+        state.store(Idle, std::memory_order_release);
+    }
+    // A Running job finishes on its own and is dropped by its stale generation
+}
+
+void AsyncDetector::run() {
+    for (;;) {
+        cv::Mat blob; uint64_t job_generation = 0; DetectionResult job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return quit || state.load(std::memory_order_relaxed) == Pending; });
+            if (quit) return;
+            blob = std::move(pending_blob); job_regions.assign(pending_regions.begin(), pending_regions.end());
+            job_generation = pending_generation; job = std::move(pending);
+            state.store(Running, std::memory_order_release);
+        }
+
+        long long start_tick = cv::getTickCount();
+        job.ok = detect_fn(blob, job_regions, job.detections, job.detection_ms);
+        busy_ticks_.fetch_add((uint64_t)(cv::getTickCount() - start_tick), std::memory_order_relaxed);
+        completed_.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (job_generation != generation) { state.store(Idle, std::memory_order_release); continue; }
+        result = std::move(job);
+        state.store(Done, std::memory_order_release);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef ASYNCDETECTOR_H
+#define ASYNCDETECTOR_H
+
+// Runs the DNN forward pass on its own thread so a detection frame no
+// longer stalls the frames around it. Only one snapshot is ever in flight:
+// submit() is refused while the worker is busy and the caller simply tries
+// again on a later frame. Results are picked up with a non-blocking poll().
+
+#include "TrackingPipeline.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// A finished detection, plus where each track was when the snapshot was
+// taken so the caller can move boxes forward to the frame it is on now
+struct DetectionResult {
+    long long frame_index = -1;  // Frame the snapshot came from
+    bool ok = false;
+    Detections detections;
+    double detection_ms = 0.0;
+    std::vector<std::pair<int, cv::Rect>> track_boxes; // Track id -> box at snapshot
+};
+
+class AsyncDetector
+{
+public:
+    // Forward + decode on a prepared blob (one image per region, in frame
+    // coordinates); runs on the worker thread
+    using DetectFn = std::function<bool(const cv::Mat& blob, const std::vector<cv::Rect>& regions, Detections& out, double& detection_ms)>;
+
+    explicit AsyncDetector(DetectFn fn);
+    ~AsyncDetector();
+
+    AsyncDetector(const AsyncDetector&) = delete;
+    AsyncDetector& operator=(const AsyncDetector&) = delete;
+
+    // Hand a snapshot to the worker. Returns false (and counts a skip) if a
+    // previous snapshot is still being processed or not yet collected.
+    bool submit(cv::Mat blob, const std::vector<cv::Rect>& regions, long long frame_index, std::vector<std::pair<int, cv::Rect>> track_boxes);
+    bool poll(DetectionResult& out);
+    bool idle() const { return state.load(std::memory_order_acquire) == Idle; }
+    void discard(); // Throw away any in-flight result (e.g. source restarted)
+
+    // --- Counters ---
+    uint64_t submitted() const { return submitted_.load(std::memory_order_relaxed); }
+    uint64_t completed() const { return completed_.load(std::memory_order_relaxed); }
+    uint64_t skipped() const { return skipped_.load(std::memory_order_relaxed); }
+    double busyMs() const { return ((double)busy_ticks_.load(std::memory_order_relaxed) / cv::getTickFrequency()) * 1000; }
+
+private:
+    enum State { Idle = 0, Pending, Running, Done };
+
+    DetectFn detect_fn;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<int> state{Idle};
+    bool quit = false;
+    uint64_t generation = 0;   // Bumped by discard(); stale results are dropped
+
+    // Mailbox (guarded by mutex)
+    cv::Mat pending_blob;
+    std::vector<cv::Rect> pending_regions;
+    std::vector<cv::Rect> job_regions;   // Worker's copy
+    uint64_t pending_generation = 0;
+    DetectionResult pending;
+    DetectionResult result;
+
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> skipped_{0};
+    std::atomic<uint64_t> busy_ticks_{0};
+
+    void run();
+};
+
+#endif // ASYNCDETECTOR_H
@@ -0,0 +1,195 @@
+#include "BatchedDetector.h"
+#include "Log.h"
+#include "YoloDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static double ticksToMs(long long ticks) {
+    return ((double)ticks / cv::getTickFrequency()) * 1000;
+}
+
+BatchedDetector::BatchedDetector(const PipelineConfig& config) : cfg(config)
+{
+    worker = std::thread(&BatchedDetector::run, this);
+}
+
+BatchedDetector::~BatchedDetector()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) { worker.join(); }
+    // Release anyone still waiting; their batch will never run
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Request* r : pending) { r->done = true; r->ok = false; }
+        pending.clear();
+    }
+    finished.notify_all();
+}
+
+bool BatchedDetector::loadNetwork() {
+    std::string model_weights = cfg.data_path + "yolov4-tiny.weights";
+    std::string model_config = cfg.data_path + "yolov4-tiny.cfg";
+    LOG_DEBUG("Loading shared network from: " << model_config << " and " << model_weights);
+    try {
+        net = cv::dnn::readNetFromDarknet(model_config, model_weights);
+        if (net.empty()) {
+            std::cerr << "Error: Can't load network using provided files." << std::endl;
+            return false;
+        }
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        output_layer_names = net.getUnconnectedOutLayersNames();
+    } catch (const cv::Exception& ex) {
+        std::cerr << "Error: OpenCV exception loading network: " << ex.what() << std::endl;
+        return false;
+    }
+    setForward([this](const cv::Mat& batch_input, std::vector<cv::Mat>& outs) {
+        net.setInput(batch_input); net.forward(outs, output_layer_names);
+        return true;
+    });
+    return true;
+}
+
+void BatchedDetector::setForward(ForwardFn fn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    forward_fn = std::move(fn);
+}
+
+void BatchedDetector::setStreamCount(int count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stream_count.store(std::max(1, count), std::memory_order_relaxed);
+    }
+    wake.notify_all(); // A waiting batch may now be complete
+}
+
+bool BatchedDetector::infer(const cv::Mat& blob, std::vector<cv::Mat>& outs) {
+    Request req;
+    req.blob = &blob; req.outs = &outs;
+    req.arrival = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    if (quit || blob.empty()) return false;
+    pending.push_back(&req);
+    wake.notify_one();
+    finished.wait(lock, [&req] { return req.done; });
+    return req.ok;
+}
+
+// Waits for a batch to close and moves its requests from `pending` into
+// `batch`. Returns false when the detector is shutting down.
+bool BatchedDetector::takeBatch(std::unique_lock<std::mutex>& lock) {
+    wake.wait(lock, [this] { return quit || !pending.empty(); });
+    if (quit) return false;
+
+    const size_t batch_max = (size_t)std::max(1, cfg.batch_max);
+    auto target = [this, batch_max] { return std::min(batch_max, (size_t)stream_count.load(std::memory_order_relaxed)); };
+    auto deadline = pending.front()->arrival + std::chrono::microseconds((long long)(cfg.batch_deadline_ms * 1000));
+    bool filled = wake.wait_until(lock, deadline, [&] { return quit || pending.size() >= target(); });
+    if (quit) return false;
+    if (!filled) { stats_.deadline_closes++; }
+
+    // Only blobs shaped like the oldest request can share its forward. A
+    // request may carry several images (crops); the oldest always goes in.
+    batch.clear();
+    const cv::Mat& first = *pending.front()->blob;
+    size_t images = 0;
+    for (auto it = pending.begin(); it != pending.end();) {
+        const cv::Mat& b = *(*it)->blob;
+        bool same_shape = b.dims == 4 && first.dims == 4 && b.type() == first.type() &&
+                          b.size[1] == first.size[1] && b.size[2] == first.size[2] && b.size[3] == first.size[3];
+        if (same_shape && (batch.empty() || images + b.size[0] <= batch_max)) {
+            images += b.size[0];
+            batch.push_back(*it); it = pending.erase(it);
+        } else { ++it; }
+    }
+    auto now = std::chrono::steady_clock::now();
+    for (Request* r : batch) { stats_.wait_ms += std::chrono::duration<double, std::milli>(now - r->arrival).count(); }
+    return true;
+}
+
+void BatchedDetector::run() {
+    for (;;) {
+        ForwardFn forward;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!takeBatch(lock)) return;
+            forward = forward_fn;
+        }
+
+        const cv::Mat& first = *batch[0]->blob;
+        bool ok = (bool)forward;
+        size_t n = 0;
+        for (Request* r : batch) {
+            r->first_image = (int)n;
+            n += r->blob->size[0];
+            ok = ok && r->blob->isContinuous();
+        }
+        long long start_tick = cv::getTickCount();
+        if (ok) {
+            try {
+                if (batch.size() == 1) {
+                    ok = forward(first, batch_outs);
+                } else {
+                    // Stack the requests' kxCxHxW blobs into one NxCxHxW input
+                    int sizes[4] = {(int)n, first.size[1], first.size[2], first.size[3]};
+                    batch_blob.create(4, sizes, first.type());
+                    const size_t image_bytes = (first.total() / first.size[0]) * first.elemSize();
+                    for (Request* r : batch) { std::memcpy(batch_blob.data + r->first_image * image_bytes, r->blob->data, r->blob->size[0] * image_bytes); }
+                    ok = forward(batch_blob, batch_outs);
+                }
+                ok = ok && scatter(n);
+            } catch (const cv::Exception& ex) {
+                std::cerr << "OpenCV Exception during batched forward: " << ex.what() << std::endl;
+                ok = false;
+            }
+        }
+        double forward_ms = ticksToMs(cv::getTickCount() - start_tick);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Request* r : batch) { r->ok = ok; r->done = true; }
+            stats_.batches++;
+            stats_.images += n;
+            stats_.largest_batch = std::max(stats_.largest_batch, n);
+            stats_.forward_ms += forward_ms;
+        }
+        finished.notify_all();
+    }
+}
+
+// Copy each request's images of every output head back to its caller.
+// Darknet region layers give [N, rows, cols] for N > 1, older builds N*rows
+// stacked; a single-image request always gets a 2D head.
+bool BatchedDetector::scatter(size_t n) {
+    cv::Mat view;
+    for (Request* r : batch) {
+        std::vector<cv::Mat>& dst = *r->outs;
+        dst.resize(batch_outs.size());
+        for (size_t h = 0; h < batch_outs.size(); ++h) {
+            const cv::Mat& o = batch_outs[h];
+            if (YoloDecoder::batchSlice(o, (int)n, r->first_image, r->blob->size[0], view)) { view.copyTo(dst[h]); }
+            else if (n == 1) { o.copyTo(dst[h]); }
+            else {
+                std::cerr << "Error: Cannot split batched output head " << h << " across " << n << " images." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+BatchStats BatchedDetector::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats_;
+}
+
+void BatchedDetector::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats_ = BatchStats();
+}
@@ -0,0 +1,105 @@
+#ifndef BATCHEDDETECTOR_H
+#define BATCHEDDETECTOR_H
+
+// One YOLO network shared by several streams. Each stream's detecting
+// thread (its AsyncDetector worker, or the detect stage) calls infer() with
+// its own blob and blocks; a single worker gathers the waiting
+// blobs into one NxCxHxW batch and runs one forward for all of them. A
+// batch closes as soon as every registered stream has a request in it,
+// batch_max is reached, or batch_deadline_ms has passed since its first
+// request arrived. Each caller gets back its own slice of every output head
+// and decodes it with its own YoloDecoder, so tracker state never leaves
+// the stream it belongs to.
+
+#include "PipelineConfig.h"
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BatchStats {
+    uint64_t batches = 0;
+    uint64_t images = 0;
+    uint64_t deadline_closes = 0; // Batches that ran part-full because the deadline expired
+    size_t largest_batch = 0;
+    double forward_ms = 0.0;      // Total time spent in forward passes
+    double wait_ms = 0.0;         // Total time requests waited for their batch to start
+};
+
+class BatchedDetector
+{
+public:
+    // Runs the network on a prepared NxCxHxW blob; `outs` receives one Mat per
+    // output head with the N images' rows stacked (2D) or split by image (3D)
+    using ForwardFn = std::function<bool(const cv::Mat& batch_blob, std::vector<cv::Mat>& outs)>;
+
+    explicit BatchedDetector(const PipelineConfig& config = PipelineConfig());
+    ~BatchedDetector();
+
+    BatchedDetector(const BatchedDetector&) = delete;
+    BatchedDetector& operator=(const BatchedDetector&) = delete;
+
+    // Loads yolov4-tiny from cfg.data_path and uses it for every forward.
+    // Call (or setForward) before the first infer().
+    bool loadNetwork();
+    // Replace the network with any batch forward (benchmarks, other backends)
+    void setForward(ForwardFn fn);
+
+    // Streams currently feeding the detector; a batch holding one request
+    // from each closes without waiting for the deadline. Safe from any thread.
+    void setStreamCount(int count);
+    int streamCount() const { return stream_count.load(std::memory_order_relaxed); }
+
+    // Blocks until the batch containing `blob` (kxCxHxW, usually k = 1 but
+    // several crops of one frame in ROI mode) has run, then copies these k
+    // images' share of each output head into `outs` (reused across calls)
+    bool infer(const cv::Mat& blob, std::vector<cv::Mat>& outs);
+
+    BatchStats stats() const;
+    void resetStats();
+
+private:
+    struct Request {
+        const cv::Mat* blob = nullptr;
+        std::vector<cv::Mat>* outs = nullptr;
+        std::chrono::steady_clock::time_point arrival;
+        int first_image = 0;   // Offset of this request's images in the batch
+        bool done = false;
+        bool ok = false;
+    };
+
+    PipelineConfig cfg;
+    cv::dnn::Net net;
+    std::vector<std::string> output_layer_names;
+    ForwardFn forward_fn;
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable wake;      // Worker: a request arrived / stream count changed
+    std::condition_variable finished;  // Callers: a batch completed
+    std::vector<Request*> pending;     // Guarded by mutex
+    bool quit = false;
+    std::atomic<int> stream_count{1};
+
+    // Worker-thread scratch, reused across batches
+    std::vector<Request*> batch;
+    cv::Mat batch_blob;
+    std::vector<cv::Mat> batch_outs;
+
+    BatchStats stats_; // Guarded by mutex
+
+    void run();
+    bool takeBatch(std::unique_lock<std::mutex>& lock);
+    bool scatter(size_t n);
+};
+
+#endif // BATCHEDDETECTOR_H
@@ -0,0 +1,61 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+// Recycles objects (frame packets with their Mat and vector storage)
+// from the stage that finishes with them back to the stage that needs a
+// fresh one, so steady-state processing reuses the same memory instead of
+// allocating per frame. One thread returns items, one thread borrows them.
+
+#include "SpscQueue.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// True if nothing but `m` references its pixels, i.e. writing into it
+// cannot corrupt an image some other consumer still holds
+inline bool soleOwner(const cv::Mat& m) {
+    return m.u != nullptr && CV_XADD(&m.u->refcount, 0) == 1;
+}
+
+template <typename T>
+class BufferPool
+{
+public:
+    explicit BufferPool(size_t capacity) : free_items(capacity) {}
+
+    // Borrow a recycled item. Returns false when the pool is empty and the
+    // caller has to construct a new one.
+    bool acquire(T& out) {
+        if (free_items.tryPop(out)) { hits_.fetch_add(1, std::memory_order_relaxed); return true; }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Hand an item back; it is simply destroyed if the pool is already full
+    void release(T& item) {
+        if (!free_items.tryPush(item)) { dropped_.fetch_add(1, std::memory_order_relaxed); }
+    }
+
+    // --- Counters ---
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    size_t available() const { return free_items.size(); }
+
+    // Only safe while neither side is running
+    void clear() {
+        free_items.clear();
+        hits_.store(0); misses_.store(0); dropped_.store(0);
+    }
+
+private:
+    SpscQueue<T> free_items;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+#endif // BUFFERPOOL_H
@@ -0,0 +1,152 @@
+#include "DetectionScheduler.h"
+#include "TrackStore.h"
+
+#include <algorithm>
+
+static const int THUMB_WIDTH = 160;      // Motion is measured on a thumbnail this wide
+static const int DIFF_THRESHOLD = 25;    // Grey-level change that counts as motion
+
+DetectionScheduler::DetectionScheduler(const PipelineConfig& config) : cfg(config)
+{
+    reset();
+}
+
+void DetectionScheduler::reset() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        published = TrackSignals();
+    }
+    current = TrackSignals();
+    prev_thumb.release(); motion_valid = false;
+    last_detect_index = -1;
+    tokens = std::max(1, cfg.detect_burst);
+    for (auto& c : triggered_) { c.store(0, std::memory_order_relaxed); }
+    for (auto& c : skipped_) { c.store(0, std::memory_order_relaxed); }
+    last_motion = 0.0;
+}
+
+static bool inBorder(const cv::Rect& box, cv::Size frame, double margin) {
+    int mx = (int)(frame.width * margin), my = (int)(frame.height * margin);
+    return box.x < mx || box.y < my || box.br().x > frame.width - mx || box.br().y > frame.height - my;
+}
+
+void DetectionScheduler::observeTracks(const TrackStore& ts, cv::Size frame_size, int failed_updates, int recently_lost) {
+    std::lock_guard<std::mutex> lock(mutex);
+    TrackSignals& p = published;
+    p.active = (int)ts.activeCount();
+    p.failed_updates = failed_updates;
+    p.oldest_undetected = 0; p.edge_tracks = 0; p.recently_lost = recently_lost; p.min_psr = 0.f;
+    p.boxes.clear();
+    for (int s : ts.activeSlots()) {
+        p.boxes.push_back(ts.bbox[s]);
+        if (ts.psr[s] > 0.f && (p.min_psr == 0.f || ts.psr[s] < p.min_psr)) { p.min_psr = ts.psr[s]; }
+        p.oldest_undetected = std::max(p.oldest_undetected, ts.frames_since_detected[s]);
+        if (inBorder(ts.bbox[s], frame_size, cfg.edge_margin)) { p.edge_tracks++; }
+    }
+}
+
+// Fraction of thumbnail pixels that changed since the previous decide() and
+// are not covered by a track box, overall and within the border band
+void DetectionScheduler::measureMotion(const cv::Mat& frame, double& motion, double& edge_motion) {
+    motion = 0.0; edge_motion = 0.0; motion_valid = false;
+    const int tw = std::min(THUMB_WIDTH, frame.cols);
+    const int th = std::max(1, frame.rows * tw / std::max(1, frame.cols));
+    cv::resize(frame, thumb, cv::Size(tw, th), 0, 0, cv::INTER_AREA);
+    if (thumb.channels() == 3) { cv::cvtColor(thumb, thumb, cv::COLOR_BGR2GRAY); }
+    if (prev_thumb.size() != thumb.size()) { thumb.copyTo(prev_thumb); return; }
+
+    cv::absdiff(thumb, prev_thumb, diff);
+    cv::threshold(diff, diff, DIFF_THRESHOLD, 255, cv::THRESH_BINARY);
+    std::swap(thumb, prev_thumb);
+
+    // Motion inside (slightly grown) track boxes is already accounted for
+    const double sx = (double)tw / frame.cols, sy = (double)th / frame.rows;
+    const cv::Rect bounds(0, 0, tw, th);
+    for (const cv::Rect& b : current.boxes) {
+        cv::Rect r((int)((b.x - b.width * 0.1) * sx), (int)((b.y - b.height * 0.1) * sy),
+                   (int)(b.width * 1.2 * sx) + 1, (int)(b.height * 1.2 * sy) + 1);
+        r &= bounds;
+        if (r.area() > 0) { diff(r).setTo(0); }
+    }
+
+    const int total = cv::countNonZero(diff);
+    const int mx = (int)(tw * cfg.edge_margin), my = (int)(th * cfg.edge_margin);
+    const cv::Rect inner(mx, my, tw - 2 * mx, th - 2 * my);
+    const int inside = inner.area() > 0 ? cv::countNonZero(diff(inner)) : 0;
+    const int border_area = tw * th - std::max(0, inner.area());
+    motion_valid = true;
+    motion = (double)total / (tw * th);
+    edge_motion = border_area > 0 ? (double)(total - inside) / border_area : 0.0;
+}
+
+bool DetectionScheduler::trigger(DetectReason r, long long frame_index) {
+    triggered_[(int)r].fetch_add(1, std::memory_order_relaxed);
+    last_detect_index = frame_index;
+    tokens = std::max(0.0, tokens - 1.0);
+    return true;
+}
+
+bool DetectionScheduler::skip(SkipReason r) {
+    skipped_[(int)r].fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool DetectionScheduler::decide(const cv::Mat& frame, long long frame_index) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current.active = published.active; current.failed_updates = published.failed_updates; current.recently_lost = published.recently_lost;
+        current.min_psr = published.min_psr;
+        current.oldest_undetected = published.oldest_undetected; current.edge_tracks = published.edge_tracks;
+        current.boxes.assign(published.boxes.begin(), published.boxes.end()); // Keeps capacity
+    }
+    const long long since = last_detect_index < 0 ? -1 : frame_index - last_detect_index;
+
+    if (!cfg.adaptive_detection) {
+        if (since < 0 || since >= cfg.detect_interval) return trigger(DetectReason::Interval, frame_index);
+        if (current.active == 0) return trigger(DetectReason::NoTracks, frame_index);
+        return skip(SkipReason::Healthy);
+    }
+
+    double motion = 0.0, edge_motion = 0.0;
+    motion_valid = false;
+    if (!frame.empty()) { measureMotion(frame, motion, edge_motion); }
+    last_motion.store(motion, std::memory_order_relaxed);
+    tokens = std::min((double)std::max(1, cfg.detect_burst), tokens + cfg.detect_budget);
+
+    if (since < 0 || since >= cfg.detect_max_interval) return trigger(DetectReason::Forced, frame_index);
+    if (since < cfg.detect_min_interval) return skip(SkipReason::MinInterval);
+
+    DetectReason want = DetectReason::Count;
+    if (current.failed_updates > 0 || (current.recently_lost > 0 && since >= cfg.detect_interval / 4)) want = DetectReason::TrackFailure;
+    else if (current.min_psr > 0.f && current.min_psr < cfg.detect_min_psr && since >= cfg.detect_interval / 4) want = DetectReason::WeakTracks;
+    else if (edge_motion >= cfg.motion_threshold) want = DetectReason::EdgeMotion;
+    else if (motion >= cfg.motion_threshold) want = DetectReason::NewMotion;
+    else if (current.active > 0 && current.oldest_undetected >= cfg.detect_interval) want = DetectReason::StaleTracks;
+    else if (current.edge_tracks > 0 && since >= cfg.detect_interval / 2) want = DetectReason::EdgeTracks;
+
+    if (want == DetectReason::Count) return skip(current.active == 0 ? SkipReason::Idle : SkipReason::Healthy);
+    if (tokens < 1.0) return skip(SkipReason::Budget);
+    return trigger(want, frame_index);
+}
+
+uint64_t DetectionScheduler::triggeredTotal() const {
+    uint64_t n = 0;
+    for (const auto& c : triggered_) { n += c.load(std::memory_order_relaxed); }
+    return n;
+}
+
+uint64_t DetectionScheduler::skippedTotal() const {
+    uint64_t n = 0;
+    for (const auto& c : skipped_) { n += c.load(std::memory_order_relaxed); }
+    return n;
+}
+
+const char* DetectionScheduler::name(DetectReason r) {
+    static const char* names[] = {"forced", "new-motion", "edge-motion", "track-failure", "weak-tracks", "stale-tracks", "edge-tracks", "interval", "no-tracks"};
+    return r < DetectReason::Count ? names[(int)r] : "?";
+}
+
+const char* DetectionScheduler::name(SkipReason r) {
+    static const char* names[] = {"min-interval", "idle", "healthy", "budget"};
+    return r < SkipReason::Count ? names[(int)r] : "?";
+}
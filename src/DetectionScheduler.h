@@ -0,0 +1,114 @@
+#ifndef DETECTIONSCHEDULER_H
+#define DETECTIONSCHEDULER_H
+
+// Decides per frame whether the detector should run, from cheap signals:
+//  - motion the current tracks do not explain (frame difference on a
+//    ~160px grey thumbnail with the track boxes masked out), with the
+//    border band counted separately for objects entering the frame;
+//  - tracker failures on the last update;
+//  - the weakest MOSSE peak-to-sidelobe ratio among active tracks, so a
+//    target that is fading (occlusion, blur, appearance change) is
+//    re-detected before its tracker gives up (a detection that matches the
+//    track re-initialises its filter, which clears the signal);
+//  - how long the oldest track has gone without a detection confirming it;
+//  - tracks sitting in the border band (about to leave, or just entered).
+// Triggered detections draw from a token bucket that refills at
+// detect_budget per frame, so a busy scene cannot run the network on every
+// frame. detect_max_interval forces a detection even in an idle scene.
+//
+// observeTracks() runs on the tracking thread after each update, decide()
+// on whichever thread picks detection frames; the two may differ.
+
+#include "PipelineConfig.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class TrackStore;
+
+enum class DetectReason {
+    Forced,         // First frame, or detect_max_interval reached
+    NewMotion,      // Untracked motion inside the frame
+    EdgeMotion,     // Untracked motion in the border band (entrants)
+    TrackFailure,   // A tracker lost its target; re-ID needs a detection
+    WeakTracks,     // A tracker's PSR fell below detect_min_psr (at most every detect_interval / 4)
+    StaleTracks,    // A track went detect_interval frames without a detection
+    EdgeTracks,     // Tracks in the border band, refreshed at half the stale interval
+    Interval,       // Fixed schedule (adaptive_detection off)
+    NoTracks,       // Fixed schedule: nothing tracked
+    Count
+};
+
+enum class SkipReason {
+    MinInterval,    // Too soon after the last detection
+    Idle,           // No tracks and no motion
+    Healthy,        // Tracks fine, nothing new moving
+    Budget,         // Wanted, but the token bucket is empty
+    Count
+};
+
+class DetectionScheduler
+{
+public:
+    explicit DetectionScheduler(const PipelineConfig& config = PipelineConfig());
+
+    void reset();
+
+    // Tracking thread: publish the track-side signals for the next decide()
+    void observeTracks(const TrackStore& tracks, cv::Size frame_size, int failed_updates, int recently_lost);
+
+    // Returns true if `frame_index` should run detection. Counts the reason.
+    bool decide(const cv::Mat& frame, long long frame_index);
+
+    // Inputs of the last decide(), for planning detection regions on the same
+    // thread: thumbnail mask of untracked motion (empty if not measured) and
+    // the active track boxes
+    const cv::Mat& motionMask() const { return motion_valid ? diff : empty_mask; }
+    const std::vector<cv::Rect>& trackBoxes() const { return current.boxes; }
+
+    // --- Counters (safe from any thread) ---
+    uint64_t triggered(DetectReason r) const { return triggered_[(int)r].load(std::memory_order_relaxed); }
+    uint64_t skipped(SkipReason r) const { return skipped_[(int)r].load(std::memory_order_relaxed); }
+    uint64_t triggeredTotal() const;
+    uint64_t skippedTotal() const;
+    double lastMotion() const { return last_motion.load(std::memory_order_relaxed); }
+    static const char* name(DetectReason r);
+    static const char* name(SkipReason r);
+
+private:
+    PipelineConfig cfg;
+
+    // Track-side signals, written by observeTracks() (guarded by mutex)
+    struct TrackSignals {
+        int active = 0;
+        int failed_updates = 0;
+        int recently_lost = 0;      // Lost tracks still within detect_interval (re-ID pending)
+        float min_psr = 0.f;        // Lowest measured PSR of an active track; 0 = none measured
+        int oldest_undetected = 0;  // Frames since the least recently detected track was matched
+        int edge_tracks = 0;
+        std::vector<cv::Rect> boxes;
+    };
+    std::mutex mutex;
+    TrackSignals published;
+
+    // Decision thread state
+    TrackSignals current;
+    cv::Mat thumb, prev_thumb, diff, empty_mask;
+    bool motion_valid = false;
+    long long last_detect_index = -1;
+    double tokens = 0.0;
+
+    std::atomic<uint64_t> triggered_[(int)DetectReason::Count];
+    std::atomic<uint64_t> skipped_[(int)SkipReason::Count];
+    std::atomic<double> last_motion{0.0};
+
+    void measureMotion(const cv::Mat& frame, double& motion, double& edge_motion);
+    bool trigger(DetectReason r, long long frame_index);
+    bool skip(SkipReason r);
+};
+
+#endif // DETECTIONSCHEDULER_H
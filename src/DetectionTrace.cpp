@@ -0,0 +1,98 @@
+#include "DetectionTrace.h"
+#include "LittleEndian.h"
+#include "TrackingPipeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char TRACE_MAGIC[4] = {'O', 'D', 'T', 'R'};
+static const uint32_t TRACE_VERSION = 1;
+static const size_t HEADER_BYTES = 4 + 4 + 4 + 4 + 8;
+static const size_t RECORD_BYTES = 8 + 8 + 4;
+static const size_t DETECTION_BYTES = 2 * 4 + 2 + 4;
+
+using namespace LittleEndian;
+
+DetectionTraceWriter::~DetectionTraceWriter() { close(); }
+
+bool DetectionTraceWriter::open(const std::string& path, cv::Size frame_size, double fps) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 16);
+    buffer.clear();
+    buffer.insert(buffer.end(), TRACE_MAGIC, TRACE_MAGIC + 4);
+    put(buffer, TRACE_VERSION, 4);
+    put(buffer, (uint32_t)frame_size.width, 4); put(buffer, (uint32_t)frame_size.height, 4);
+    uint64_t fps_bits; std::memcpy(&fps_bits, &fps, 8); put(buffer, fps_bits, 8);
+    if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) { std::fclose(file); file = nullptr; return false; }
+    open_tick = cv::getTickCount();
+    record_count = 0;
+    return true;
+}
+
+void DetectionTraceWriter::write(long long frame_index, const Detections& detections) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) return;
+    const long long timestamp_us = (long long)((double)(cv::getTickCount() - open_tick) / cv::getTickFrequency() * 1e6);
+    const size_t n = detections.boxes.size();
+    buffer.clear();
+    put(buffer, (uint64_t)frame_index, 8); put(buffer, (uint64_t)timestamp_us, 8); put(buffer, (uint32_t)n, 4);
+    for (size_t i = 0; i < n; ++i) {
+        const cv::Rect& b = detections.boxes[i];
+        put(buffer, (uint16_t)clamp16(b.x), 2); put(buffer, (uint16_t)clamp16(b.y), 2);
+        put(buffer, (uint16_t)clamp16(b.width), 2); put(buffer, (uint16_t)clamp16(b.height), 2);
+        put(buffer, (uint16_t)(i < detections.classIds.size() ? detections.classIds[i] : 0), 2);
+        uint32_t conf_bits; float conf = i < detections.confidences.size() ? detections.confidences[i] : 0.f;
+        std::memcpy(&conf_bits, &conf, 4); put(buffer, conf_bits, 4);
+    }
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    record_count++;
+}
+
+void DetectionTraceWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file) { std::fclose(file); file = nullptr; }
+}
+
+DetectionTraceReader::~DetectionTraceReader() { close(); }
+
+bool DetectionTraceReader::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    unsigned char raw[HEADER_BYTES];
+    if (std::fread(raw, 1, HEADER_BYTES, file) != HEADER_BYTES || std::memcmp(raw, TRACE_MAGIC, 4) != 0) { close(); return false; }
+    const unsigned char* p = raw + 4;
+    if (get(p, 4) != TRACE_VERSION) { close(); return false; }
+    head.frame_size.width = (int)(int32_t)get(p, 4);
+    head.frame_size.height = (int)(int32_t)get(p, 4);
+    uint64_t fps_bits = get(p, 8); std::memcpy(&head.fps, &fps_bits, 8);
+    return true;
+}
+
+bool DetectionTraceReader::next(long long& frame_index, long long& timestamp_us, Detections& out) {
+    out.clear();
+    if (!file) return false;
+    unsigned char raw[RECORD_BYTES];
+    if (std::fread(raw, 1, RECORD_BYTES, file) != RECORD_BYTES) return false;
+    const unsigned char* p = raw;
+    frame_index = (long long)get(p, 8);
+    timestamp_us = (long long)get(p, 8);
+    const uint32_t n = (uint32_t)get(p, 4);
+    buffer.resize((size_t)n * DETECTION_BYTES);
+    if (n > 0 && std::fread(buffer.data(), 1, buffer.size(), file) != buffer.size()) return false;
+    p = buffer.data();
+    for (uint32_t i = 0; i < n; ++i) {
+        int x = (int16_t)get(p, 2), y = (int16_t)get(p, 2), w = (int16_t)get(p, 2), h = (int16_t)get(p, 2);
+        int class_id = (int)get(p, 2);
+        uint32_t conf_bits = (uint32_t)get(p, 4); float conf; std::memcpy(&conf, &conf_bits, 4);
+        out.boxes.emplace_back(x, y, w, h); out.classIds.push_back(class_id); out.confidences.push_back(conf);
+    }
+    return true;
+}
+
+void DetectionTraceReader::close() {
+    if (file) { std::fclose(file); file = nullptr; }
+}
@@ -0,0 +1,81 @@
+#ifndef DETECTIONTRACE_H
+#define DETECTIONTRACE_H
+
+// Binary trace of post-NMS detections, for re-running tracking without the
+// network. A trace is written while a source is processed normally and
+// replayed later (ObjectTrackingCli --replay-trace): the recorded boxes go
+// straight into associateAndTrack() on the frame they were detected on, so
+// association / re-ID / motion-model settings can be tuned over hours of
+// footage in minutes, and two replays of one trace give identical tracks.
+//
+// Layout (little-endian, no padding):
+//   header  "ODTR" | u32 version | i32 width | i32 height | f64 fps
+//   record  i64 frame_index | i64 timestamp_us | u32 count | count x detection
+//   detection  i16 x | i16 y | i16 w | i16 h | u16 class_id | f32 confidence
+// One record per completed detection run, zero detections included (a run
+// that found nothing still tells the tracker nothing was there). Records are
+// appended in the order runs complete; timestamp_us is time since open().
+// A trace cut short by a crash reads back up to its last whole record.
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct Detections;
+
+struct TraceHeader {
+    cv::Size frame_size;
+    double fps = 0.0;
+};
+
+class DetectionTraceWriter
+{
+public:
+    DetectionTraceWriter() = default;
+    ~DetectionTraceWriter();
+
+    DetectionTraceWriter(const DetectionTraceWriter&) = delete;
+    DetectionTraceWriter& operator=(const DetectionTraceWriter&) = delete;
+
+    bool open(const std::string& path, cv::Size frame_size, double fps);
+    // Safe from any thread; records go out in call order
+    void write(long long frame_index, const Detections& detections);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+    uint64_t records() const { return record_count; }
+
+private:
+    std::mutex mutex;
+    std::FILE* file = nullptr;
+    long long open_tick = 0;
+    uint64_t record_count = 0;
+    std::vector<unsigned char> buffer;   // One record, reused
+};
+
+class DetectionTraceReader
+{
+public:
+    DetectionTraceReader() = default;
+    ~DetectionTraceReader();
+
+    DetectionTraceReader(const DetectionTraceReader&) = delete;
+    DetectionTraceReader& operator=(const DetectionTraceReader&) = delete;
+
+    // False if the file is missing or not a trace of a version this build reads
+    bool open(const std::string& path);
+    const TraceHeader& header() const { return head; }
+    // Next record; false at the end of the trace (or at a truncated record)
+    bool next(long long& frame_index, long long& timestamp_us, Detections& out);
+    void close();
+
+private:
+    std::FILE* file = nullptr;
+    TraceHeader head;
+    std::vector<unsigned char> buffer;
+};
+
+#endif // DETECTIONTRACE_H
@@ -0,0 +1,108 @@
+#include "EventLog.h"
+
+#include <chrono>
+
+const char* eventName(EventType type) {
+    switch (type) {
+        case EventType::TrackBorn: return "track_born";
+        case EventType::TrackLost: return "track_lost";
+        case EventType::TrackReidentified: return "track_reidentified";
+        case EventType::TrackExpired: return "track_expired";
+        case EventType::ZoneEnter: return "zone_enter";
+        case EventType::ZoneExit: return "zone_exit";
+        case EventType::SpeedAlert: return "speed_alert";
+        default: return "unknown";
+    }
+}
+
+// Body of a JSON string literal holding `s`
+static std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += (char)c; }
+        else if (c < 0x20) { char esc[8]; std::snprintf(esc, sizeof(esc), "\\u%04x", c); out += esc; }
+        else { out += (char)c; }
+    }
+    return out;
+}
+
+EventBus::EventBus(size_t capacity, const std::string& stream)
+    : ring(capacity), stream_label(stream), stream_json(jsonEscape(stream)),
+      published_(MetricsRegistry::global().counter("objtrack_events_total", "Track and alert events published.", metricLabels({{"stream", stream}}))),
+      dropped_(MetricsRegistry::global().counter("objtrack_events_dropped_total", "Events dropped because the event ring was full.", metricLabels({{"stream", stream}})))
+{
+}
+
+bool EventBus::publish(const TrackEvent& event) {
+    TrackEvent copy = event;
+    if (!ring.tryPush(copy)) { dropped_.add(); return false; }
+    published_.add();
+    return true;
+}
+
+// --- EventLogWriter ---
+EventLogWriter::~EventLogWriter()
+{
+    stop();
+}
+
+bool EventLogWriter::start(const std::string& path, const std::vector<EventBus*>& buses, double flush_interval_ms) {
+    stop();
+    if (path.empty()) return false;
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) return false;
+    sources = buses;
+    interval_ms = flush_interval_ms > 0 ? flush_interval_ms : 50.0;
+    stop_requested = false;
+    batch.reserve(64 * 1024);
+    worker = std::thread(&EventLogWriter::run, this);
+    return true;
+}
+
+void EventLogWriter::stop() {
+    if (!worker.joinable()) return;
+    { std::lock_guard<std::mutex> lock(mutex); stop_requested = true; }
+    wake.notify_all();
+    worker.join();
+    drain(); // Whatever the producers published before they stopped
+    std::fclose(file); file = nullptr;
+}
+
+// Polls on a timer rather than being woken per event, so publish() stays a
+// plain ring push; one write per wake-up carries everything that arrived.
+void EventLogWriter::run() {
+    const auto interval = std::chrono::duration<double, std::milli>(interval_ms);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, interval, [this]() { return stop_requested; })) {
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+size_t EventLogWriter::drain() {
+    batch.clear();
+    size_t n = 0;
+    TrackEvent e;
+    char line[320];
+    for (EventBus* bus : sources) {
+        while (bus->poll(e)) {
+            int len = std::snprintf(line, sizeof(line), "{\"frame\":%lld,\"ts_us\":%lld,", e.frame_index, e.timestamp_us);
+            batch.append(line, (size_t)len);
+            if (!bus->stream().empty()) { batch += "\"stream\":\""; batch += bus->streamJson(); batch += "\","; }
+            len = std::snprintf(line, sizeof(line), "\"event\":\"%s\",\"track\":%d,\"class\":%d,\"box\":[%d,%d,%d,%d]",
+                                eventName(e.type), e.track_id, e.class_id, e.box.x, e.box.y, e.box.width, e.box.height);
+            batch.append(line, (size_t)len);
+            if (e.type == EventType::ZoneEnter || e.type == EventType::ZoneExit) { len = std::snprintf(line, sizeof(line), ",\"zone\":%d", e.zone); batch.append(line, (size_t)len); }
+            if (e.type == EventType::SpeedAlert) { len = std::snprintf(line, sizeof(line), ",\"speed\":%.1f", e.speed); batch.append(line, (size_t)len); }
+            batch += "}\n";
+            n++;
+        }
+    }
+    if (n > 0) {
+        std::fwrite(batch.data(), 1, batch.size(), file);
+        std::fflush(file); // A reader tailing the file sees whole batches
+        written_.fetch_add(n, std::memory_order_relaxed);
+    }
+    return n;
+}
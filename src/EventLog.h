@@ -0,0 +1,115 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+// Track and alert events for machine consumers.
+//  - EventBus: bounded lock-free ring (SpscQueue) between a pipeline's
+//    tracking thread, the only producer, and one consumer. publish() never
+//    blocks; when the ring is full the event is dropped and counted, so a
+//    slow consumer can never stall the frame loop.
+//  - EventLogWriter: the consumer. Drains one or more buses on its own
+//    thread and appends the events, a batch per wake-up, to a JSONL file:
+//      {"frame":812,"ts_us":1760601234567890,"stream":"0","event":"zone_enter",
+//       "track":14,"class":0,"box":[412,96,58,131],"zone":0}
+//    (`stream` only when the bus has one; `zone` / `speed` only on the
+//    events that carry them).
+//
+// Events are stamped with the frame they happened on and that frame's
+// wall-clock time, so every event of one frame has the same timestamp.
+
+#include "Metrics.h"
+#include "SpscQueue.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class EventType : uint8_t {
+    TrackBorn,           // New track from an unmatched detection
+    TrackLost,           // Active -> lost
+    TrackReidentified,   // Lost -> active again on a detection
+    TrackExpired,        // Lost for max_lost_frames, deleted
+    ZoneEnter,           // Box's foot point (bottom centre) moved into a zone
+    ZoneExit,            // ...moved out of it (or the track was lost)
+    SpeedAlert,          // Speed went over speed_threshold_pixels_per_sec
+    Count
+};
+
+const char* eventName(EventType type);
+
+// Plain data: copied through the ring, nothing allocated per event
+struct TrackEvent {
+    EventType type = EventType::TrackBorn;
+    int track_id = -1;
+    int class_id = -1;
+    int zone = -1;                 // ZoneEnter / ZoneExit
+    float speed = 0.f;             // SpeedAlert: pixels per second
+    cv::Rect box;
+    long long frame_index = -1;
+    long long timestamp_us = 0;    // Frame's wall-clock time, microseconds since the Unix epoch
+};
+
+class EventBus
+{
+public:
+    explicit EventBus(size_t capacity = 4096, const std::string& stream = std::string());
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    // Producer (one thread). False when the ring was full and the event dropped.
+    bool publish(const TrackEvent& event);
+    // Consumer (one thread)
+    bool poll(TrackEvent& out) { return ring.tryPop(out); }
+
+    const std::string& stream() const { return stream_label; }
+    const std::string& streamJson() const { return stream_json; } // Escaped for a JSON string, once
+    size_t capacity() const { return ring.capacity(); }
+    uint64_t published() const { return published_.value(); }
+    uint64_t dropped() const { return dropped_.value(); }
+
+private:
+    SpscQueue<TrackEvent> ring;
+    std::string stream_label;
+    std::string stream_json;
+    Counter& published_;           // objtrack_events_total{stream}
+    Counter& dropped_;             // objtrack_events_dropped_total{stream}
+};
+
+class EventLogWriter
+{
+public:
+    EventLogWriter() = default;
+    ~EventLogWriter();
+
+    EventLogWriter(const EventLogWriter&) = delete;
+    EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+    // Appends to `path`; the buses must outlive stop()
+    bool start(const std::string& path, const std::vector<EventBus*>& buses, double flush_interval_ms = 50.0);
+    void stop(); // Drains what is left, flushes and joins; safe to call more than once
+    bool isRunning() const { return worker.joinable(); }
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<EventBus*> sources;
+    double interval_ms = 50.0;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stop_requested = false;   // Guarded by mutex
+    std::atomic<uint64_t> written_{0};
+    std::string batch;             // Worker thread only
+
+    void run();
+    size_t drain();                // One pass over every bus into `batch`, written out
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,72 @@
+#include "FrameMailbox.h"
+#include "Metrics.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <utility>
+
+FrameMailbox::FrameMailbox(NotifyFn notify_fn) : notify(std::move(notify_fn)) {}
+
+// QImage cleanup hook: drops the Mat reference taken in wrap()
+static void releaseSharedMat(void* info) {
+    delete static_cast<cv::Mat*>(info);
+}
+
+QImage FrameMailbox::wrap(const cv::Mat& frame) {
+    if (frame.empty() || frame.depth() != CV_8U) return QImage();
+    cv::Mat shared = frame; // Header copy; pixels are shared
+    QImage::Format format;
+    if (frame.channels() == 3) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        format = QImage::Format_BGR888; // OpenCV's native order, no conversion
+#else
+        cv::cvtColor(frame, shared, cv::COLOR_BGR2RGB); // No BGR888 before Qt 5.14
+        format = QImage::Format_RGB888;
+#endif
+    } else if (frame.channels() == 1) {
+        format = QImage::Format_Grayscale8;
+    } else {
+        return QImage();
+    }
+    cv::Mat* hold = new cv::Mat(shared);
+    return QImage(hold->data, hold->cols, hold->rows, static_cast<int>(hold->step), format, releaseSharedMat, hold);
+}
+
+bool FrameMailbox::publish(const cv::Mat& frame, const std::vector<TrackOverlay>* overlay) {
+    static Counter& dropped_metric = MetricsRegistry::global().counter("objtrack_display_frames_dropped_total",
+                                                                       "Frames replaced before the GUI showed them.");
+    long long start_tick = cv::getTickCount();
+    QImage image = wrap(frame);
+    stageLatency(PipelineStage::Convert).observe(((double)(cv::getTickCount() - start_tick) / cv::getTickFrequency()) * 1000);
+    if (image.isNull()) return false;
+    bool was_empty;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        was_empty = !has_frame;
+        if (has_frame) { dropped_.fetch_add(1, std::memory_order_relaxed); dropped_metric.add(); }
+        std::swap(latest, image); // Old image (if any) is released outside the lock
+        if (overlay) { latest_overlay = *overlay; } else { latest_overlay.clear(); } // Element-wise: capacity is reused
+        has_frame = true;
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+    if (was_empty && notify) { notify(); }
+    return true;
+}
+
+bool FrameMailbox::take(QImage& out, std::vector<TrackOverlay>* overlay) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!has_frame) return false;
+    out = std::move(latest);
+    latest = QImage();
+    if (overlay) { overlay->swap(latest_overlay); }
+    has_frame = false;
+    taken_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void FrameMailbox::clear() {
+    QImage discard;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(latest, discard);
+    has_frame = false;
+}
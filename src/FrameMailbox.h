@@ -0,0 +1,64 @@
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+// Single-slot, latest-frame-wins handoff from the encode thread to the GUI.
+//
+// publish() wraps the frame's pixels in a QImage that shares the cv::Mat
+// buffer (the Mat reference is held until the last QImage copy goes away),
+// so the worker neither copies nor converts pixels and never builds a
+// QPixmap. If the GUI has not collected the previous frame yet it is
+// replaced and counted as dropped. Only the empty -> full transition
+// notifies, so at most one wake-up is ever queued and a slow GUI cannot
+// make frames pile up.
+//
+// In record_raw mode the frame arrives unannotated and its TrackOverlay
+// snapshot rides along in the same slot, so the GUI draws boxes at display
+// resolution on exactly the frame they belong to.
+
+#include "TrackingPipeline.h" // TrackOverlay
+
+#include <QImage>
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class FrameMailbox
+{
+public:
+    using NotifyFn = std::function<void()>;
+
+    explicit FrameMailbox(NotifyFn notify);
+
+    // Encode thread. Returns false if the frame cannot be displayed.
+    // `overlay` (may be null) is copied into the slot's reused buffer.
+    bool publish(const cv::Mat& frame, const std::vector<TrackOverlay>* overlay = nullptr);
+    // GUI thread. Returns false when no frame is waiting. `overlay` (may be
+    // null) is swapped with the frame's snapshot, empty if none was published.
+    bool take(QImage& out, std::vector<TrackOverlay>* overlay = nullptr);
+    void clear();
+
+    // --- Counters ---
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+    uint64_t taken() const { return taken_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    NotifyFn notify;
+    std::mutex mutex;
+    QImage latest;          // Guarded by mutex
+    std::vector<TrackOverlay> latest_overlay; // Guarded by mutex
+    bool has_frame = false; // Guarded by mutex
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> taken_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    static QImage wrap(const cv::Mat& frame);
+};
+
+#endif // FRAMEMAILBOX_H
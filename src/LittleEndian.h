@@ -0,0 +1,29 @@
+#ifndef LITTLEENDIAN_H
+#define LITTLEENDIAN_H
+
+// Little-endian packing, independent of the host byte order, shared by the
+// binary file formats (DetectionTrace, OverlaySidecar).
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace LittleEndian {
+
+inline void put(std::vector<unsigned char>& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) { out.push_back((unsigned char)(v >> (8 * i))); }
+}
+
+// Reads `bytes` bytes and advances `in` past them
+inline uint64_t get(const unsigned char*& in, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) { v |= (uint64_t)in[i] << (8 * i); }
+    in += bytes;
+    return v;
+}
+
+inline int16_t clamp16(int v) { return (int16_t)std::max(-32768, std::min(32767, v)); }
+
+} // namespace LittleEndian
+
+#endif // LITTLEENDIAN_H
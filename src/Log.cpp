@@ -0,0 +1,12 @@
+#include "Log.h"
+
+std::atomic<int> Log::current_level{(int)LogLevel::Info};
+
+bool Log::parseLevel(const std::string& name, LogLevel& out) {
+    if (name == "error") out = LogLevel::Error;
+    else if (name == "warn") out = LogLevel::Warn;
+    else if (name == "info") out = LogLevel::Info;
+    else if (name == "debug") out = LogLevel::Debug;
+    else return false;
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef LOG_H
+#define LOG_H
+
+// Process-wide log level for the console output of the tracking core. The
+// per-frame and per-track messages (new/lost/re-identified tracks, detection
+// timings, alerts) go through LOG_DEBUG/LOG_INFO, which test the level
+// before anything is formatted, so a quiet run pays one relaxed load per
+// message and timing runs are not skewed by console I/O.
+// Errors keep going straight to std::cerr.
+
+#include <atomic>
+#include <iostream>
+#include <string>
+
+enum class LogLevel { Error = 0, Warn, Info, Debug };
+
+namespace Log {
+extern std::atomic<int> current_level;
+
+inline bool enabled(LogLevel level) { return (int)level <= current_level.load(std::memory_order_relaxed); }
+inline void setLevel(LogLevel level) { current_level.store((int)level, std::memory_order_relaxed); }
+inline LogLevel level() { return (LogLevel)current_level.load(std::memory_order_relaxed); }
+// "error" | "warn" | "info" | "debug"; returns false for anything else
+bool parseLevel(const std::string& name, LogLevel& out);
+}
+
+#define LOG_AT(level, stream, prefix, message) \
+    do { if (Log::enabled(level)) { stream << prefix << message << std::endl; } } while (0)
+#define LOG_WARN(message) LOG_AT(LogLevel::Warn, std::cerr, "WARN: ", message)
+#define LOG_INFO(message) LOG_AT(LogLevel::Info, std::cout, "", message)
+#define LOG_DEBUG(message) LOG_AT(LogLevel::Debug, std::cout, "DEBUG: ", message)
+
+#endif // LOG_H
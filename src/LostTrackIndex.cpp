@@ -0,0 +1,123 @@
+#include "LostTrackIndex.h"
+
+#include <algorithm>
+
+static const int CELL = 64; // Grid cell side, pixels
+
+void LostTrackIndex::configure(int max_lost_frames, int recent_frames) {
+    max_lost = std::max(1, max_lost_frames);
+    recent_window = std::max(0, recent_frames);
+    // Every entry is scheduled less than one turn ahead
+    wheel.resize(std::max(max_lost, recent_window + 1) + 1);
+    clear();
+}
+
+void LostTrackIndex::clear() {
+    for (std::vector<Entry>& bucket : wheel) { bucket.clear(); }
+    for (std::vector<int>& cell : cells) { cell.clear(); }
+    for (size_t s = 0; s < indexed.size(); ++s) { if (indexed[s]) { indexed[s] = 0; generation[s]++; } }
+    count = 0; recent = 0;
+}
+
+void LostTrackIndex::setFrameSize(cv::Size frame) {
+    if (frame == frame_size) return;
+    frame_size = frame;
+    cols = std::max(1, (frame.width + CELL - 1) / CELL);
+    rows = std::max(1, (frame.height + CELL - 1) / CELL);
+    cells.resize((size_t)cols * rows);
+    for (std::vector<int>& cell : cells) { cell.clear(); }
+    for (int s = 0; s < (int)indexed.size(); ++s) { if (indexed[s]) insertCells(s); }
+}
+
+void LostTrackIndex::ensureSlot(int slot) {
+    if (slot < (int)indexed.size()) return;
+    indexed.resize(slot + 1, 0); generation.resize(slot + 1, 0); lost_at.resize(slot + 1, 0);
+    swept_box.resize(slot + 1); cell_span.resize(slot + 1); stamp.resize(slot + 1, 0);
+}
+
+// Cells covered by `box`, clamped to the grid
+cv::Rect LostTrackIndex::span(const cv::Rect& box) const {
+    auto cx = [this](int x) { return std::min(std::max(x < 0 ? 0 : x / CELL, 0), cols - 1); };
+    auto cy = [this](int y) { return std::min(std::max(y < 0 ? 0 : y / CELL, 0), rows - 1); };
+    const int x0 = cx(box.x), y0 = cy(box.y);
+    const int x1 = cx(box.x + std::max(box.width, 1) - 1), y1 = cy(box.y + std::max(box.height, 1) - 1);
+    return cv::Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+}
+
+void LostTrackIndex::insertCells(int slot) {
+    const cv::Rect sp = span(swept_box[slot]);
+    cell_span[slot] = sp;
+    for (int y = sp.y; y < sp.y + sp.height; ++y)
+        for (int x = sp.x; x < sp.x + sp.width; ++x) { cells[(size_t)y * cols + x].push_back(slot); }
+}
+
+void LostTrackIndex::eraseCells(int slot) {
+    const cv::Rect sp = cell_span[slot];
+    for (int y = sp.y; y < sp.y + sp.height; ++y) {
+        for (int x = sp.x; x < sp.x + sp.width; ++x) {
+            std::vector<int>& cell = cells[(size_t)y * cols + x];
+            auto it = std::find(cell.begin(), cell.end(), slot);
+            if (it != cell.end()) { *it = cell.back(); cell.pop_back(); }
+        }
+    }
+}
+
+void LostTrackIndex::schedule(long long step, int slot, Kind kind) {
+    wheel[(size_t)(step % (long long)wheel.size())].push_back({slot, generation[slot], kind});
+}
+
+void LostTrackIndex::add(int slot, long long now, const cv::Rect& swept) {
+    if (wheel.empty()) { configure(max_lost, recent_window); }
+    ensureSlot(slot);
+    if (indexed[slot]) { unindex(slot, now); }
+    generation[slot]++;
+    indexed[slot] = 1; lost_at[slot] = now; swept_box[slot] = swept;
+    insertCells(slot);
+    count++; recent++;
+    schedule(now + max_lost, slot, Expire);
+    if (recent_window < max_lost) { schedule(now + recent_window + 1, slot, RecentEnds); }
+}
+
+void LostTrackIndex::unindex(int slot, long long now) {
+    eraseCells(slot);
+    indexed[slot] = 0; generation[slot]++; count--;
+    if (now - lost_at[slot] <= recent_window) { recent--; }
+}
+
+void LostTrackIndex::remove(int slot, long long now) {
+    if (contains(slot)) { unindex(slot, now); }
+}
+
+void LostTrackIndex::expire(long long now, std::vector<int>& out) {
+    out.clear();
+    if (wheel.empty()) return;
+    std::vector<Entry>& bucket = wheel[(size_t)(now % (long long)wheel.size())];
+    // RecentEnds first: with max_lost == recent_window + 1 both entries of a
+    // track share this bucket, and unindex() no longer counts it as recent
+    for (const Entry& e : bucket) {
+        if (e.kind != RecentEnds || !contains(e.slot) || generation[e.slot] != e.generation) continue; // Re-identified since
+        recent--;
+    }
+    for (const Entry& e : bucket) {
+        if (e.kind != Expire || !contains(e.slot) || generation[e.slot] != e.generation) continue;
+        unindex(e.slot, now);
+        out.push_back(e.slot);
+    }
+    bucket.clear();
+}
+
+void LostTrackIndex::query(const std::vector<cv::Rect>& boxes, std::vector<int>& out) {
+    out.clear();
+    if (count == 0) return;
+    stamp_gen++;
+    for (const cv::Rect& box : boxes) {
+        const cv::Rect sp = span(box);
+        for (int y = sp.y; y < sp.y + sp.height; ++y) {
+            for (int x = sp.x; x < sp.x + sp.width; ++x) {
+                for (int slot : cells[(size_t)y * cols + x]) {
+                    if (stamp[slot] != stamp_gen) { stamp[slot] = stamp_gen; out.push_back(slot); }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef LOSTTRACKINDEX_H
+#define LOSTTRACKINDEX_H
+
+// Bookkeeping for lost tracks that costs nothing per frame for the tracks
+// that just sit there:
+//  - a timing wheel with one bucket per frame of max_lost_frames: losing a
+//    track drops an entry into the bucket of the frame it expires on, and
+//    expire() only looks at the current bucket. Re-identified tracks are
+//    not searched for; their generation is bumped and stale entries are
+//    skipped when their bucket comes round. The same wheel ends a track's
+//    "recently lost" window for the detection scheduler.
+//  - a uniform grid over the frame keyed by the area the track's predicted
+//    box can sweep before it expires (constant velocity: the union of its
+//    box at loss and at expiry), so a re-ID query only touches lost tracks
+//    whose prediction can overlap the detection. Boxes beyond the frame
+//    edge are clamped into the border cells, so no candidate is missed.
+// "Steps" are the pipeline's updateTracks() calls.
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class LostTrackIndex
+{
+public:
+    LostTrackIndex() : cells(1) {}
+
+    // max_lost_frames: steps a lost track lives; recent_frames: steps it
+    // counts towards recentlyLost()
+    void configure(int max_lost_frames, int recent_frames);
+    void setFrameSize(cv::Size frame);       // Re-buckets indexed tracks if the size changed
+    void clear();
+
+    // Track in `slot` was lost at step `now`; `swept` bounds its predicted box until expiry
+    void add(int slot, long long now, const cv::Rect& swept);
+    // Track was re-identified at step `now`
+    void remove(int slot, long long now);
+    // Tracks whose time ran out at step `now`, removed from the index.
+    // Call once per step.
+    void expire(long long now, std::vector<int>& out);
+    // Indexed slots whose swept area shares a cell with any of `boxes`, each once
+    void query(const std::vector<cv::Rect>& boxes, std::vector<int>& out);
+
+    bool contains(int slot) const { return slot < (int)indexed.size() && indexed[slot]; }
+    long long lostAt(int slot) const { return lost_at[slot]; }
+    size_t size() const { return count; }
+    int recentlyLost() const { return recent; }
+
+private:
+    enum Kind : uint8_t { Expire, RecentEnds };
+    struct Entry { int slot; uint32_t generation; Kind kind; };
+
+    int max_lost = 60;
+    int recent_window = 30;
+    std::vector<std::vector<Entry>> wheel;
+    size_t count = 0;
+    int recent = 0;
+
+    // Per slot
+    std::vector<uint8_t> indexed;
+    std::vector<uint32_t> generation;
+    std::vector<long long> lost_at;
+    std::vector<cv::Rect> swept_box;         // Frame coordinates
+    std::vector<cv::Rect> cell_span;         // Cell coordinates (inclusive origin, exclusive end)
+    std::vector<int> stamp;
+    int stamp_gen = 0;
+
+    // Grid
+    cv::Size frame_size;
+    int cols = 1, rows = 1;
+    std::vector<std::vector<int>> cells;
+
+    void ensureSlot(int slot);
+    cv::Rect span(const cv::Rect& box) const;
+    void insertCells(int slot);
+    void eraseCells(int slot);
+    void unindex(int slot, long long now);
+    void schedule(long long step, int slot, Kind kind);
+};
+
+#endif // LOSTTRACKINDEX_H
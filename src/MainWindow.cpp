@@ -5,6 +5,8 @@
 #include <QMessageBox>
 #include <QMetaObject>
 #include <QCheckBox>
+#include <QImage>
+#include <QPainter>
 #include <QDesktopServices> // For opening files/URLs
 #include <QUrl>            // For converting file path
 
@@ -20,7 +22,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
     // --- Connect Signals and Slots ---
     // Worker -> MainWindow UI Updates
-    connect(videoProcessorWorker, &VideoProcessor::frameProcessed, this, &MainWindow::updateVideoDisplay, Qt::QueuedConnection);
+    connect(videoProcessorWorker, &VideoProcessor::frameReady, this, &MainWindow::updateVideoDisplay, Qt::QueuedConnection);
     connect(videoProcessorWorker, &VideoProcessor::statusUpdated, this, &MainWindow::updateStatus, Qt::QueuedConnection);
     // --- Connect worker signal providing last saved file path ---
     connect(videoProcessorWorker, &VideoProcessor::recordingFinished, this, &MainWindow::setLastRecordedFile, Qt::QueuedConnection);
@@ -177,10 +179,68 @@ void MainWindow::onOpenRecordingClicked() {
 
 
 // Slot to update video display label
-void MainWindow::updateVideoDisplay(QPixmap pixmap) { /* ... same as before ... */
-    if (!pixmap.isNull()) { videoDisplayLabel->setPixmap(pixmap.scaled(videoDisplayLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation)); }
+// Only the newest frame is ever waiting; frames the GUI was too slow for were
+// already dropped by the mailbox. One fast scale to the label size, then the
+// single image -> pixmap conversion.
+void MainWindow::updateVideoDisplay() {
+    QImage image;
+    if (videoProcessorWorker->frameMailbox()->take(image, &display_overlay) && !image.isNull()) {
+        QImage scaled = image.scaled(videoDisplayLabel->size(), Qt::KeepAspectRatio, Qt::FastTransformation);
+        if (videoProcessorWorker->trackingPipeline().config().record_raw) { paintOverlay(scaled, image.size()); }
+        videoDisplayLabel->setPixmap(QPixmap::fromImage(scaled));
+    }
     else { videoDisplayLabel->setText("Video Stopped / No Frame"); videoDisplayLabel->setStyleSheet("QLabel { background-color : black; color : gray; border: 1px solid gray;}"); } }
 
+// Raw recording: the worker left the frame clean, so the overlay is drawn
+// here on the already scaled image (same rules as TrackingPipeline::drawOverlay)
+void MainWindow::paintOverlay(QImage& image, QSize frame_size) {
+    if (frame_size.isEmpty()) return;
+    if (image.format() != QImage::Format_RGB32) { image = image.convertToFormat(QImage::Format_RGB32); }
+    const TrackingPipeline& pipeline = videoProcessorWorker->trackingPipeline();
+    const bool draw_zone = showRestrictedZoneCheckbox->isChecked(), draw_trajectory = showTrajectoryCheckbox->isChecked();
+    const bool check_speed = checkSpeedAlertCheckbox->isChecked();
+    const double sx = (double)image.width() / frame_size.width(), sy = (double)image.height() / frame_size.height();
+    auto map = [sx, sy](const cv::Point& p) { return QPointF(p.x * sx, p.y * sy); };
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QFont font = painter.font(); font.setPixelSize(11); painter.setFont(font);
+    bool alert = false;
+    for (const TrackOverlay& t : display_overlay) {
+        QColor color(0, 255, 0);
+        QString alert_text;
+        if (draw_zone && t.zone_alert) { alert = true; color = QColor(255, 0, 0); alert_text += "[ZONE]"; }
+        else if (draw_zone && t.in_zone) { color = QColor(200, 200, 200); } // Events-only zone: no alert
+        if (check_speed && t.over_speed) { alert = true; if (!(draw_zone && t.zone_alert)) { color = QColor(255, 165, 0); } alert_text += "[SPEED]"; }
+        const QRectF box(map(t.boundingBox.tl()), map(t.boundingBox.br()));
+        painter.setPen(QPen(color, 2));
+        painter.drawRect(box);
+        painter.drawText(box.topLeft() + QPointF(0, -4), QString("%1 ID:%2 %3").arg(QString::fromStdString(pipeline.className(t.classId))).arg(t.id).arg(alert_text));
+        painter.drawText(box.bottomLeft() + QPointF(0, 12), QString("V:%1 px/s").arg(t.velocity, 0, 'f', 1));
+        if (draw_trajectory && t.trajectory.size() > 1) {
+            painter.setPen(QPen(QColor(255, 255, 0), 2));
+            for (size_t i = 1; i < t.trajectory.size(); ++i) { painter.drawLine(map(t.trajectory[i - 1]), map(t.trajectory[i])); }
+        }
+    }
+    if (draw_zone) {
+        const cv::Size frame(frame_size.width(), frame_size.height());
+        std::vector<cv::Point> polygon;
+        QPolygonF scaled_polygon;
+        for (const Zone& zone : pipeline.zoneMap().zones()) {
+            painter.setPen(QPen(zone.alert ? QColor(255, 0, 0) : QColor(200, 200, 200), 2));
+            ZoneMap::scaled(zone, frame, polygon);
+            scaled_polygon.clear();
+            for (const cv::Point& p : polygon) { scaled_polygon << map(p); }
+            painter.drawPolygon(scaled_polygon);
+            painter.drawText(scaled_polygon.first() + QPointF(5, 15), QString::fromStdString(zone.name));
+        }
+    }
+    if (alert && (draw_zone || check_speed)) {
+        font.setPixelSize(20); painter.setFont(font); painter.setPen(QColor(255, 0, 0));
+        painter.drawText(QPointF(image.width() / 2 - 40, image.height() - 12), "ALERT!");
+    }
+}
+
 // Slot to update status label
 void MainWindow::updateStatus(QString status) { statusLabel->setText(status); }
 
@@ -11,6 +11,11 @@
 #include <QPixmap>
 #include <QString>
 #include <QCheckBox>
+#include <QImage>
+
+#include "TrackingPipeline.h" // TrackOverlay
+
+#include <vector>
 
 class VideoProcessor; // Forward declaration
 
@@ -23,7 +28,7 @@ public:
     ~MainWindow();
 
 public slots:
-    void updateVideoDisplay(QPixmap pixmap);
+    void updateVideoDisplay(); // Pulls the newest frame from the worker's mailbox
     void updateStatus(QString status);
     // --- Slot to receive last recorded file path ---
     void setLastRecordedFile(QString filePath);
@@ -63,7 +68,11 @@ private:
     // --- Store last recorded file path ---
     QString lastRecordedFilePath;
 
+    // Overlay of the frame on screen (record_raw: drawn here, at display size)
+    std::vector<TrackOverlay> display_overlay;
+
     void setupUi();
+    void paintOverlay(QImage& image, QSize frame_size);
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
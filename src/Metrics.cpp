@@ -0,0 +1,227 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+// --- LatencyHistogram ---
+
+static const double BOUNDS_MS[LatencyHistogram::BUCKETS - 1] = {
+    0.01, 0.02, 0.03, 0.05, 0.07, 0.1, 0.2, 0.3, 0.5, 0.7,
+    1, 2, 3, 5, 7, 10, 20, 30, 50, 70,
+    100, 200, 300, 500, 700, 1000, 2000, 3000, 5000, 7000};
+
+double LatencyHistogram::bound(int bucket) {
+    return bucket < BUCKETS - 1 ? BOUNDS_MS[bucket] : std::numeric_limits<double>::infinity();
+}
+
+void LatencyHistogram::observe(double ms) {
+    if (!(ms >= 0)) ms = 0; // Also catches NaN
+    const int b = (int)(std::lower_bound(BOUNDS_MS, BOUNDS_MS + BUCKETS - 1, ms) - BOUNDS_MS); // First bound >= ms
+    counts_[b].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add((uint64_t)(ms * 1e6 + 0.5), std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot s;
+    for (int b = 0; b < BUCKETS; ++b) {
+        s.counts[b] = counts_[b].load(std::memory_order_relaxed);
+        s.count += s.counts[b];
+    }
+    s.sum_ms = sum_ns_.load(std::memory_order_relaxed) / 1e6;
+    return s;
+}
+
+void LatencyHistogram::reset() {
+    for (std::atomic<uint64_t>& c : counts_) { c.store(0, std::memory_order_relaxed); }
+    sum_ns_.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::Snapshot::quantile(double q) const {
+    if (count == 0) return 0.0;
+    const double rank = std::min(std::max(q, 0.0), 1.0) * count;
+    uint64_t below = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        if (counts[b] == 0 || below + counts[b] < rank) { below += counts[b]; continue; }
+        if (b == BUCKETS - 1) return BOUNDS_MS[BUCKETS - 2]; // Overflow: best we can say
+        const double lo = b == 0 ? 0.0 : BOUNDS_MS[b - 1], hi = BOUNDS_MS[b];
+        return lo + (hi - lo) * (rank - below) / counts[b];
+    }
+    return BOUNDS_MS[BUCKETS - 2];
+}
+
+// --- MetricsRegistry ---
+
+MetricsRegistry& MetricsRegistry::global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Series& MetricsRegistry::find(const std::string& name, const std::string& help, Type type, const std::string& labels) {
+    auto family = std::find_if(families.begin(), families.end(), [&name](const Family& f) { return f.name == name; });
+    if (family == families.end()) {
+        families.push_back({name, help, type, {}});
+        family = families.end() - 1;
+    }
+    for (Series& s : family->series) { if (s.labels == labels) return s; }
+    family->series.push_back(Series());
+    family->series.back().labels = labels; // The caller attaches the value
+    return family->series.back();
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Series& s = find(name, help, CounterType, labels);
+    if (!s.counter) { counters.emplace_back(); s.counter = &counters.back(); }
+    return *s.counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Series& s = find(name, help, GaugeType, labels);
+    if (!s.gauge) { gauges.emplace_back(); s.gauge = &gauges.back(); }
+    return *s.gauge;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Series& s = find(name, help, HistogramType, labels);
+    if (!s.histogram) { histograms.emplace_back(); s.histogram = &histograms.back(); }
+    return *s.histogram;
+}
+
+static std::string formatNumber(double v) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", v);
+    return text;
+}
+
+static std::string braces(const std::string& labels, const std::string& extra = std::string()) {
+    if (labels.empty() && extra.empty()) return std::string();
+    if (labels.empty()) return "{" + extra + "}";
+    if (extra.empty()) return "{" + labels + "}";
+    return "{" + labels + "," + extra + "}";
+}
+
+std::string MetricsRegistry::prometheusText() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string out;
+    for (const Family& f : families) {
+        static const char* type_names[] = {"counter", "gauge", "histogram"};
+        out += "# HELP " + f.name + " " + f.help + "\n";
+        out += "# TYPE " + f.name + " " + type_names[f.type] + "\n";
+        for (const Series& s : f.series) {
+            if (s.counter) { out += f.name + braces(s.labels) + " " + std::to_string(s.counter->value()) + "\n"; }
+            else if (s.gauge) { out += f.name + braces(s.labels) + " " + formatNumber(s.gauge->value()) + "\n"; }
+            else if (s.histogram) {
+                const LatencyHistogram::Snapshot snap = s.histogram->snapshot();
+                uint64_t cumulative = 0;
+                for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+                    cumulative += snap.counts[b];
+                    std::string le = b < LatencyHistogram::BUCKETS - 1 ? formatNumber(LatencyHistogram::bound(b) / 1000.0) : "+Inf";
+                    out += f.name + "_bucket" + braces(s.labels, "le=\"" + le + "\"") + " " + std::to_string(cumulative) + "\n";
+                }
+                out += f.name + "_sum" + braces(s.labels) + " " + formatNumber(snap.sum_ms / 1000.0) + "\n";
+                out += f.name + "_count" + braces(s.labels) + " " + std::to_string(snap.count) + "\n";
+            }
+        }
+    }
+    return out;
+}
+
+bool MetricsRegistry::writeFile(const std::string& path) const {
+    const std::string text = prometheusText();
+    const std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) { std::remove(tmp.c_str()); return false; }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) { // Windows will not rename over an existing file
+        std::remove(path.c_str());
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) { std::remove(tmp.c_str()); return false; }
+    }
+    return true;
+}
+
+void MetricsRegistry::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Counter& c : counters) { c.reset(); }
+    for (Gauge& g : gauges) { g.reset(); }
+    for (LatencyHistogram& h : histograms) { h.reset(); }
+}
+
+// --- Stage latencies ---
+
+const char* stageName(PipelineStage stage) {
+    static const char* names[(int)PipelineStage::Count] = {"capture", "preprocess", "forward", "decode", "associate",
+                                                   "track", "draw", "convert", "encode"};
+    return (int)stage >= 0 && stage < PipelineStage::Count ? names[(int)stage] : "?";
+}
+
+std::string metricLabels(std::initializer_list<std::pair<const char*, std::string>> pairs) {
+    std::string out;
+    for (const auto& pair : pairs) {
+        if (pair.second.empty()) continue;
+        if (!out.empty()) out += ",";
+        out += std::string(pair.first) + "=\"";
+        for (char c : pair.second) { // Exposition format escapes
+            if (c == '\\' || c == '"') { out += '\\'; out += c; }
+            else if (c == '\n') { out += "\\n"; }
+            else { out += c; }
+        }
+        out += "\"";
+    }
+    return out;
+}
+
+LatencyHistogram& stageLatency(PipelineStage stage) {
+    struct StageHistograms {
+        LatencyHistogram* h[(int)PipelineStage::Count];
+        StageHistograms() {
+            for (int s = 0; s < (int)PipelineStage::Count; ++s) {
+                h[s] = &MetricsRegistry::global().histogram("objtrack_stage_latency_seconds", "Time spent in each pipeline stage per call.",
+                                                            metricLabels({{"stage", stageName((PipelineStage)s)}}));
+            }
+        }
+    };
+    static StageHistograms stages;
+    return *stages.h[(int)stage];
+}
+
+// --- MetricsExporter ---
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::start(const std::string& file_path, double interval) {
+    stop();
+    if (file_path.empty()) return false;
+    path = file_path;
+    interval_sec = interval > 0 ? interval : 5.0;
+    stop_requested = false;
+    if (!MetricsRegistry::global().writeFile(path)) return false; // Bad path is reported here
+    worker = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!worker.joinable()) return;
+    { std::lock_guard<std::mutex> lock(mutex); stop_requested = true; }
+    wake.notify_all();
+    worker.join();
+    MetricsRegistry::global().writeFile(path);
+}
+
+void MetricsExporter::run() {
+    const auto interval = std::chrono::duration<double>(interval_sec);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, interval, [this]() { return stop_requested; })) {
+        lock.unlock();
+        MetricsRegistry::global().writeFile(path);
+        lock.lock();
+    }
+}
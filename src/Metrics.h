@@ -0,0 +1,164 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Process-wide metrics registry: counters, gauges and latency histograms
+// that the processing threads update without taking a lock.
+//  - Registration (counter()/gauge()/histogram()) takes a mutex and returns
+//    a reference that stays valid for the life of the process; callers look
+//    their metrics up once and keep the reference, so the hot path is a
+//    relaxed atomic add or store.
+//  - Registering the same name and labels twice returns the same series, so
+//    pipelines add to one set of figures unless PipelineConfig::metrics_stream
+//    gives each its own `stream` label.
+//  - prometheusText() renders everything in the Prometheus text format;
+//    MetricsExporter writes it to a file every few seconds (for the
+//    node_exporter textfile collector, or anything that tails a file).
+//
+// Stage latencies go through stageLatency(), one histogram per pipeline
+// stage in milliseconds (exported in seconds, as Prometheus expects).
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class Counter
+{
+public:
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+    void reset() { value_.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge
+{
+public:
+    void set(double v) { value_.store(v, std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+    void reset() { set(0.0); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+// Fixed 1-2-3-5-7 buckets from 10 us to 7 s, plus overflow. observe() is a
+// binary search over 30 bounds and two relaxed adds.
+class LatencyHistogram
+{
+public:
+    static const int BUCKETS = 31;            // 30 finite upper bounds + overflow
+    static double bound(int bucket);          // Upper bound in ms (infinity for the last)
+
+    struct Snapshot {
+        uint64_t counts[BUCKETS] = {};        // Per bucket, not cumulative
+        uint64_t count = 0;
+        double sum_ms = 0.0;
+        double mean() const { return count ? sum_ms / count : 0.0; }
+        // Interpolated within the bucket the q-th observation falls in
+        double quantile(double q) const;
+    };
+
+    void observe(double ms);
+    Snapshot snapshot() const;
+    void reset();
+
+private:
+    std::atomic<uint64_t> counts_[BUCKETS] = {};
+    std::atomic<uint64_t> sum_ns_{0};
+};
+
+// Stages with a latency histogram ("objtrack_stage_latency_seconds{stage=...}")
+enum class PipelineStage {
+    Capture,     // cap.read()
+    Preprocess,  // blobFromImage(s)
+    Forward,     // net.forward(), or the wait for a shared batched forward
+    Decode,      // YOLO output decode + NMS
+    Associate,   // Detections matched to tracks, re-ID, new tracks
+    Track,       // Appearance tracker update for all tracks
+    Draw,        // Overlay
+    Convert,     // Frame wrapped for display (GUI)
+    Encode,      // Recording encoder write
+    Count
+};
+
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry& global();
+
+    // `labels` is the inside of the braces, e.g. `queue="track"` (may be empty)
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = std::string());
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = std::string());
+    LatencyHistogram& histogram(const std::string& name, const std::string& help, const std::string& labels = std::string());
+
+    std::string prometheusText() const;
+    // Written to `path`.tmp and renamed over `path`, so readers never see half a file
+    bool writeFile(const std::string& path) const;
+    // Zero every series (registrations stay)
+    void reset();
+
+private:
+    enum Type { CounterType, GaugeType, HistogramType };
+    struct Series {
+        std::string labels;
+        Counter* counter = nullptr;
+        Gauge* gauge = nullptr;
+        LatencyHistogram* histogram = nullptr;
+    };
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<Series> series;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<Family> families;                 // Registration order; guarded by mutex
+    std::deque<Counter> counters;                 // Deques: references never move
+    std::deque<Gauge> gauges;
+    std::deque<LatencyHistogram> histograms;
+
+    Series& find(const std::string& name, const std::string& help, Type type, const std::string& labels);
+};
+
+LatencyHistogram& stageLatency(PipelineStage stage);
+const char* stageName(PipelineStage stage);
+// `key="value"` pairs joined for the registry, values escaped for the text
+// exposition format; pairs with an empty value are left out
+std::string metricLabels(std::initializer_list<std::pair<const char*, std::string>> pairs);
+
+// Writes the global registry to a file every `interval_sec` on its own thread
+class MetricsExporter
+{
+public:
+    MetricsExporter() = default;
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    bool start(const std::string& path, double interval_sec);
+    void stop(); // Writes a final snapshot and joins; safe to call more than once
+    bool isRunning() const { return worker.joinable(); }
+
+private:
+    std::string path;
+    double interval_sec = 5.0;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stop_requested = false;  // Guarded by mutex
+
+    void run();
+};
+
+#endif // METRICS_H
@@ -0,0 +1,145 @@
+#include "MosseTracker.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+static const double EPS = 1e-5;
+static const double PSR_THRESHOLD = 5.7;   // Below this the target is considered lost
+static const double LEARNING_RATE = 0.2;
+static const int INIT_WARPS = 8;           // Perturbed copies of the first patch the filter is trained on
+
+// --- TrackerFrame ---
+// Convert first, then shrink: the resize then reads one channel instead of three
+const cv::Mat& TrackerFrame::prepare(const cv::Mat& frame) {
+    source = frame.data; source_size = frame.size();
+    const bool convert = gray_output && frame.channels() != 1;
+    if (convert) { cv::cvtColor(frame, gray, frame.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY); }
+    if (factor >= 1.0) {
+        if (!convert) { gray = frame; }
+        return gray;
+    }
+    cv::resize(convert ? gray : frame, scaled, cv::Size(), factor, factor, cv::INTER_AREA);
+    return scaled;
+}
+
+const cv::Mat& TrackerFrame::get(const cv::Mat& frame) {
+    if (source && frame.data == source && frame.size() == source_size) return factor >= 1.0 ? gray : scaled;
+    return prepare(frame);
+}
+
+// --- MosseTracker ---
+const cv::Mat& MosseTracker::toGray(cv::InputArray image) {
+    cv::Mat img = image.getMat();
+    if (img.channels() == 1) { gray = img; }
+    else { cv::cvtColor(img, gray, img.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY); }
+    return gray;
+}
+
+// log, zero mean / unit variance, then the window (all in place)
+void MosseTracker::preprocess(cv::Mat& p) const {
+    p += 1.0f;
+    cv::log(p, p);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(p, mean, stddev);
+    double scale = 1.0 / (stddev[0] + EPS);
+    p.convertTo(p, CV_32F, scale, -mean[0] * scale);
+    cv::multiply(p, window, p);
+}
+
+void MosseTracker::learn(double rate) {
+    cv::mulSpectrums(goal_fft, patch_fft, product, 0, true);   // G .* conj(F)
+    cv::addWeighted(A, 1.0 - rate, product, rate, 0.0, A);
+    cv::mulSpectrums(patch_fft, patch_fft, product, 0, true);  // |F|^2 (real)
+    cv::addWeighted(B, 1.0 - rate, product, rate, 0.0, B);
+    computeFilter();
+}
+
+void MosseTracker::computeFilter() {
+    for (int y = 0; y < H.rows; ++y) {
+        const cv::Vec2f* a = A.ptr<cv::Vec2f>(y); const cv::Vec2f* b = B.ptr<cv::Vec2f>(y); cv::Vec2f* h = H.ptr<cv::Vec2f>(y);
+        for (int x = 0; x < H.cols; ++x) { float d = 1.0f / (b[x][0] + (float)EPS); h[x] = cv::Vec2f(a[x][0] * d, a[x][1] * d); }
+    }
+}
+
+cv::Size MosseTracker::patchSizeFor(const cv::Rect& box) {
+    return cv::Size(cv::getOptimalDFTSize(std::max(box.width, 1)), cv::getOptimalDFTSize(std::max(box.height, 1)));
+}
+
+void MosseTracker::init(cv::InputArray image, const cv::Rect& boundingBox) {
+    const cv::Mat& img = toGray(image);
+    box_size = boundingBox.size(); last_box = boundingBox;
+    center = cv::Point2f(boundingBox.x + boundingBox.width * 0.5f, boundingBox.y + boundingBox.height * 0.5f);
+    const cv::Size size = patchSizeFor(boundingBox);
+    if (size != patch_size || window.empty()) {
+        // Window and desired response (a sharp Gaussian peak at the patch
+        // centre) depend only on the size; kept when re-initialised at the same size
+        patch_size = size;
+        cv::createHanningWindow(window, patch_size, CV_32F);
+        goal.create(patch_size, CV_32F); goal.setTo(0);
+        goal.at<float>(patch_size.height / 2, patch_size.width / 2) = 1.0f;
+        cv::GaussianBlur(goal, goal, cv::Size(-1, -1), 2.0);
+        cv::normalize(goal, goal, 1.0, 0.0, cv::NORM_MINMAX);
+        cv::dft(goal, goal_fft, cv::DFT_COMPLEX_OUTPUT);
+    }
+    // create() is a no-op when the size is unchanged
+    A.create(patch_size, CV_32FC2); A.setTo(0);
+    B.create(patch_size, CV_32FC2); B.setTo(0);
+    H.create(patch_size, CV_32FC2);
+    patch_fft.create(patch_size, CV_32FC2);
+    product.create(patch_size, CV_32FC2);
+    response.create(patch_size, CV_32F);
+
+    // Train on small random rotations/shears of the first patch; fixed seed
+    // so a rerun on the same clip tracks identically
+    cv::getRectSubPix(img, patch_size, center, first, CV_32F);
+    cv::RNG rng(0x4d4f5353);
+    const cv::Point2f mid(patch_size.width * 0.5f, patch_size.height * 0.5f);
+    for (int i = 0; i < INIT_WARPS; ++i) {
+        const double C = 0.1, ang = rng.uniform(-C, C), c = std::cos(ang), s = std::sin(ang);
+        cv::Matx23d W(c + rng.uniform(-C, C), -s + rng.uniform(-C, C), 0.0,
+                      s + rng.uniform(-C, C), c + rng.uniform(-C, C), 0.0);
+        W(0, 2) = mid.x - (W(0, 0) * mid.x + W(0, 1) * mid.y);
+        W(1, 2) = mid.y - (W(1, 0) * mid.x + W(1, 1) * mid.y);
+        cv::warpAffine(first, warped, W, patch_size, cv::INTER_LINEAR, cv::BORDER_REFLECT);
+        preprocess(warped);
+        cv::dft(warped, patch_fft, cv::DFT_COMPLEX_OUTPUT);
+        cv::mulSpectrums(goal_fft, patch_fft, product, 0, true); A += product;
+        cv::mulSpectrums(patch_fft, patch_fft, product, 0, true); B += product;
+    }
+    computeFilter();
+    last_psr = 0.0;
+}
+
+bool MosseTracker::update(cv::InputArray image, cv::Rect& boundingBox) {
+    if (H.empty()) return false;
+    const cv::Mat& img = toGray(image);
+    if (boundingBox != last_box) { center = cv::Point2f(boundingBox.x + boundingBox.width * 0.5f, boundingBox.y + boundingBox.height * 0.5f); }
+
+    // Correlate the filter with the patch at the previous position
+    cv::getRectSubPix(img, patch_size, center, patch, CV_32F);
+    preprocess(patch);
+    cv::dft(patch, patch_fft, cv::DFT_COMPLEX_OUTPUT);
+    cv::mulSpectrums(patch_fft, H, product, 0, false);
+    cv::idft(product, response, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+
+    double max_val; cv::Point max_loc;
+    cv::minMaxLoc(response, nullptr, &max_val, nullptr, &max_loc);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(response, mean, stddev);
+    last_psr = (max_val - mean[0]) / (stddev[0] + EPS);
+    if (last_psr < PSR_THRESHOLD) return false;
+
+    center.x += max_loc.x - patch_size.width / 2;
+    center.y += max_loc.y - patch_size.height / 2;
+
+    // Adapt the filter to the patch at the new position
+    cv::getRectSubPix(img, patch_size, center, patch, CV_32F);
+    preprocess(patch);
+    cv::dft(patch, patch_fft, cv::DFT_COMPLEX_OUTPUT);
+    learn(LEARNING_RATE);
+
+    boundingBox = last_box = cv::Rect(cvRound(center.x - box_size.width * 0.5f), cvRound(center.y - box_size.height * 0.5f), box_size.width, box_size.height);
+    return true;
+}
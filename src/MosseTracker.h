@@ -0,0 +1,88 @@
+#ifndef MOSSETRACKER_H
+#define MOSSETRACKER_H
+
+// MOSSE correlation filter (Bolme et al., CVPR 2010) behind the cv::Tracker
+// interface. Same filter as cv::legacy::TrackerMOSSE, but the per-frame
+// work is split so it can be shared between tracks:
+//  - TrackerFrame converts the frame to 8-bit grayscale once per frame
+//    (optionally downscaled, PipelineConfig::processing_scale), and every
+//    track's init()/update() samples its patch from that image;
+//  - each tracker allocates its patch, window and spectrum buffers at init()
+//    and reuses them, so update() costs one sub-pixel crop, two forward FFTs
+//    and one inverse FFT of the patch, whatever the frame size. init() may
+//    be called again on a new box (see TrackerPool); buffers are only
+//    reallocated if the patch size changes.
+// A colour frame is still accepted (converted per call) for callers that
+// have no shared TrackerFrame.
+// If update() is handed a box other than the one it last reported (the
+// pipeline moves it to the motion model's prediction), the search starts
+// at that box's centre instead of the last position.
+
+#include <opencv2/core.hpp>
+#include <opencv2/tracking.hpp>
+
+// One grayscale copy of the current frame, shared by all trackers
+class TrackerFrame
+{
+public:
+    // `scale` < 1 shrinks the image (INTER_AREA) after conversion; with
+    // `to_gray` false the colour is kept (trackers that convert themselves)
+    void configure(double scale, bool to_gray) { factor = scale; gray_output = to_gray; invalidate(); }
+    double scale() const { return factor; }
+    // Convert `frame` (BGR or gray); the result stays valid until the next call
+    const cv::Mat& prepare(const cv::Mat& frame);
+    // Grayscale of `frame`: the cached image if `frame` is the one last
+    // prepared, otherwise converted now
+    const cv::Mat& get(const cv::Mat& frame);
+    // Stop matching the last source (its buffer may be refilled with a new frame)
+    void invalidate() { source = nullptr; }
+    void clear() { gray.release(); scaled.release(); invalidate(); }
+
+private:
+    cv::Mat gray;
+    cv::Mat scaled;                  // `gray` (or the colour frame) shrunk by `factor`
+    double factor = 1.0;
+    bool gray_output = true;
+    const uchar* source = nullptr;   // Pixels `gray` was made from
+    cv::Size source_size;
+};
+
+class MosseTracker : public cv::Tracker
+{
+public:
+    MosseTracker() = default;
+
+    void init(cv::InputArray image, const cv::Rect& boundingBox) CV_OVERRIDE;
+    bool update(cv::InputArray image, cv::Rect& boundingBox) CV_OVERRIDE;
+
+    // Peak-to-sidelobe ratio of the last update() (higher = more confident)
+    double psr() const { return last_psr; }
+    // Patch (and so buffer) size init() picks for `box`
+    static cv::Size patchSizeFor(const cv::Rect& box);
+    cv::Size patchSize() const { return patch_size; }
+
+private:
+    cv::Point2f center;           // Target centre in frame coordinates
+    cv::Size box_size;            // Reported box size (the tracker keeps it fixed)
+    cv::Rect last_box;            // Box last reported (or given to init())
+    cv::Size patch_size;          // DFT-friendly patch size
+    cv::Mat window;               // Hanning window, CV_32F
+    cv::Mat goal_fft;             // Desired response G, CV_32FC2
+    cv::Mat A, B, H;              // Filter numerator / denominator / A ./ B, CV_32FC2
+    double last_psr = 0.0;
+
+    // Reused scratch
+    cv::Mat gray;                 // Only used for colour input
+    cv::Mat patch;                // CV_32F
+    cv::Mat patch_fft;            // CV_32FC2
+    cv::Mat product;              // CV_32FC2
+    cv::Mat response;             // CV_32F
+    cv::Mat goal, first, warped;  // init() only
+
+    const cv::Mat& toGray(cv::InputArray image);
+    void preprocess(cv::Mat& p) const;
+    void learn(double rate);      // Blend the current patch_fft into A / B
+    void computeFilter();         // H = A ./ B
+};
+
+#endif // MOSSETRACKER_H
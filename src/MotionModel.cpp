@@ -0,0 +1,37 @@
+#include "MotionModel.h"
+
+void MotionModel::init(cv::Point2f centre, float pos_var, float vel_var) {
+    pos = centre; vel = cv::Point2f(0.f, 0.f);
+    p_pp = pos_var; p_pv = 0.f; p_vv = vel_var;
+    corrections = 0;
+}
+
+// x' = F x, P' = F P F^T + Q with F = [1 1; 0 1] and Q the discrete white
+// noise acceleration model q * [1/4 1/2; 1/2 1]
+void MotionModel::predict(float q) {
+    pos += vel;
+    p_pp += 2.f * p_pv + p_vv + 0.25f * q;
+    p_pv += p_vv + 0.5f * q;
+    p_vv += q;
+}
+
+void MotionModel::correct(cv::Point2f z, float r) {
+    const float s = p_pp + r;
+    const float k_p = p_pp / s, k_v = p_pv / s;
+    const cv::Point2f innovation = z - pos;
+    pos += innovation * k_p;
+    vel += innovation * k_v;
+    p_vv -= k_v * p_pv;
+    p_pp *= 1.f - k_p;
+    p_pv *= 1.f - k_p;
+    corrections++;
+}
+
+float MotionModel::distance2(cv::Point2f z, float r) const {
+    const cv::Point2f d = z - pos;
+    return (d.x * d.x + d.y * d.y) / (p_pp + r);
+}
+
+cv::Rect MotionModel::box(cv::Size size) const {
+    return cv::Rect(cvRound(pos.x - size.width * 0.5f), cvRound(pos.y - size.height * 0.5f), size.width, size.height);
+}
@@ -0,0 +1,37 @@
+#ifndef MOTIONMODEL_H
+#define MOTIONMODEL_H
+
+// Constant-velocity Kalman filter on a track's box centre, one frame per
+// time step. x and y are filtered independently with the same noise and
+// are always measured together, so they share one 2x2 covariance
+// (position / velocity) and the whole state is a few floats per track,
+// kept by value in TrackStore.
+//
+// The pipeline predicts every active track once per frame and corrects it
+// with the appearance tracker's box (or a matched detection). A lost track's
+// state is left as it was at loss and only advanced to the current frame
+// when re-ID queries it. The state gives smoothed velocity, the association
+// gate, re-ID positions and the box on frames the appearance tracker skips.
+
+#include <opencv2/core.hpp>
+
+struct MotionModel
+{
+    cv::Point2f pos;              // Centre, pixels
+    cv::Point2f vel;              // Pixels per frame
+    float p_pp = 0.f, p_pv = 0.f, p_vv = 0.f; // Covariance, per axis
+    int corrections = 0;          // Measurements folded in since init()
+
+    void init(cv::Point2f centre, float pos_var, float vel_var);
+    // Advance one frame; `q` = acceleration variance (pixels^2 / frame^4)
+    void predict(float q);
+    // Fold in a measured centre with variance `r` (pixels^2)
+    void correct(cv::Point2f z, float r);
+    // Squared Mahalanobis distance of a measurement with variance `r` from
+    // the current state (chi-square, 2 degrees of freedom)
+    float distance2(cv::Point2f z, float r) const;
+    // Box of `size` around the current centre
+    cv::Rect box(cv::Size size) const;
+};
+
+#endif // MOTIONMODEL_H
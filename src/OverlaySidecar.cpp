@@ -0,0 +1,164 @@
+#include "OverlaySidecar.h"
+#include "LittleEndian.h"
+#include "TrackingPipeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char SIDECAR_MAGIC[4] = {'O', 'T', 'S', 'C'};
+static const char INDEX_MAGIC[4] = {'O', 'T', 'S', 'I'};
+static const uint32_t SIDECAR_VERSION = 1;
+static const size_t HEADER_BYTES = 4 + 4 + 4 + 4 + 8;
+static const size_t RECORD_BYTES = 8 + 8 + 2;
+static const size_t TRACK_BYTES = 4 + 2 + 2 * 4 + 4 + 1;
+static const size_t TRAILER_BYTES = 8 + 8 + 4;
+
+using namespace LittleEndian;
+
+void toSidecar(const std::vector<TrackOverlay>& overlay, std::vector<SidecarTrack>& out) {
+    out.resize(overlay.size());
+    for (size_t i = 0; i < overlay.size(); ++i) {
+        const TrackOverlay& t = overlay[i];
+        SidecarTrack& s = out[i];
+        s.id = t.id; s.class_id = t.classId; s.box = t.boundingBox; s.velocity = (float)t.velocity;
+        s.flags = (uint8_t)((t.in_zone ? SIDECAR_ZONE : 0) | (t.over_speed ? SIDECAR_SPEED : 0) | (t.zone_alert ? SIDECAR_ZONE_ALERT : 0));
+    }
+}
+
+std::string sidecarPath(const std::string& video_path) {
+    const size_t slash = video_path.find_last_of("/\\");
+    const size_t dot = video_path.find_last_of('.');
+    const bool has_ext = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    return (has_ext ? video_path.substr(0, dot) : video_path) + ".tracks";
+}
+
+// --- OverlaySidecarWriter ---
+OverlaySidecarWriter::~OverlaySidecarWriter() { close(); }
+
+bool OverlaySidecarWriter::open(const std::string& path, cv::Size frame_size, double fps) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 16);
+    buffer.clear();
+    buffer.insert(buffer.end(), SIDECAR_MAGIC, SIDECAR_MAGIC + 4);
+    put(buffer, SIDECAR_VERSION, 4);
+    put(buffer, (uint32_t)frame_size.width, 4); put(buffer, (uint32_t)frame_size.height, 4);
+    uint64_t fps_bits; std::memcpy(&fps_bits, &fps, 8); put(buffer, fps_bits, 8);
+    if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) { std::fclose(file); file = nullptr; return false; }
+    offset = buffer.size();
+    index.clear();
+    return true;
+}
+
+void OverlaySidecarWriter::write(long long source_index, long long timestamp_us, const std::vector<SidecarTrack>& tracks) {
+    if (!file) return;
+    const size_t n = std::min(tracks.size(), (size_t)0xFFFF);
+    buffer.clear();
+    put(buffer, (uint64_t)source_index, 8); put(buffer, (uint64_t)timestamp_us, 8); put(buffer, (uint16_t)n, 2);
+    for (size_t i = 0; i < n; ++i) {
+        const SidecarTrack& t = tracks[i];
+        put(buffer, (uint32_t)t.id, 4); put(buffer, (uint16_t)t.class_id, 2);
+        put(buffer, (uint16_t)clamp16(t.box.x), 2); put(buffer, (uint16_t)clamp16(t.box.y), 2);
+        put(buffer, (uint16_t)clamp16(t.box.width), 2); put(buffer, (uint16_t)clamp16(t.box.height), 2);
+        uint32_t v_bits; std::memcpy(&v_bits, &t.velocity, 4); put(buffer, v_bits, 4);
+        put(buffer, t.flags, 1);
+    }
+    index.push_back(offset);
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    offset += buffer.size();
+}
+
+void OverlaySidecarWriter::close() {
+    if (!file) return;
+    buffer.clear();
+    for (uint64_t o : index) { put(buffer, o, 8); }
+    put(buffer, (uint64_t)index.size(), 8); put(buffer, offset, 8);
+    buffer.insert(buffer.end(), INDEX_MAGIC, INDEX_MAGIC + 4);
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    std::fclose(file); file = nullptr;
+}
+
+// --- OverlaySidecarReader ---
+OverlaySidecarReader::~OverlaySidecarReader() { close(); }
+
+bool OverlaySidecarReader::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    unsigned char raw[HEADER_BYTES];
+    if (std::fread(raw, 1, HEADER_BYTES, file) != HEADER_BYTES || std::memcmp(raw, SIDECAR_MAGIC, 4) != 0) { close(); return false; }
+    const unsigned char* p = raw + 4;
+    if (get(p, 4) != SIDECAR_VERSION) { close(); return false; }
+    frame_size.width = (int)(int32_t)get(p, 4);
+    frame_size.height = (int)(int32_t)get(p, 4);
+    uint64_t fps_bits = get(p, 8); std::memcpy(&frame_rate, &fps_bits, 8);
+    std::fseek(file, 0, SEEK_END);
+    const uint64_t file_size = (uint64_t)std::ftell(file);
+    if (!readIndex(file_size)) { scan(file_size); }
+    return true;
+}
+
+bool OverlaySidecarReader::readIndex(uint64_t file_size) {
+    index.clear();
+    if (file_size < HEADER_BYTES + TRAILER_BYTES) return false;
+    unsigned char raw[TRAILER_BYTES];
+    std::fseek(file, (long)(file_size - TRAILER_BYTES), SEEK_SET);
+    if (std::fread(raw, 1, TRAILER_BYTES, file) != TRAILER_BYTES || std::memcmp(raw + 16, INDEX_MAGIC, 4) != 0) return false;
+    const unsigned char* p = raw;
+    const uint64_t count = get(p, 8), index_offset = get(p, 8);
+    if (index_offset < HEADER_BYTES || index_offset + count * 8 + TRAILER_BYTES != file_size) return false;
+    buffer.resize((size_t)count * 8);
+    std::fseek(file, (long)index_offset, SEEK_SET);
+    if (count > 0 && std::fread(buffer.data(), 1, buffer.size(), file) != buffer.size()) return false;
+    p = buffer.data();
+    index.resize((size_t)count);
+    for (uint64_t& o : index) { o = get(p, 8); }
+    return true;
+}
+
+// No trailer: walk the records, stopping at the first incomplete one
+void OverlaySidecarReader::scan(uint64_t file_size) {
+    index.clear();
+    uint64_t at = HEADER_BYTES;
+    unsigned char raw[RECORD_BYTES];
+    while (at + RECORD_BYTES <= file_size) {
+        std::fseek(file, (long)at, SEEK_SET);
+        if (std::fread(raw, 1, RECORD_BYTES, file) != RECORD_BYTES) break;
+        const unsigned char* p = raw + 16;
+        const uint64_t end = at + RECORD_BYTES + get(p, 2) * TRACK_BYTES;
+        if (end > file_size) break;
+        index.push_back(at);
+        at = end;
+    }
+}
+
+bool OverlaySidecarReader::read(size_t n, SidecarFrame& out) {
+    out.tracks.clear();
+    if (!file || n >= index.size()) return false;
+    unsigned char raw[RECORD_BYTES];
+    std::fseek(file, (long)index[n], SEEK_SET);
+    if (std::fread(raw, 1, RECORD_BYTES, file) != RECORD_BYTES) return false;
+    const unsigned char* p = raw;
+    out.source_index = (long long)get(p, 8);
+    out.timestamp_us = (long long)get(p, 8);
+    const size_t count = (size_t)get(p, 2);
+    buffer.resize(count * TRACK_BYTES);
+    if (count > 0 && std::fread(buffer.data(), 1, buffer.size(), file) != buffer.size()) return false;
+    p = buffer.data();
+    out.tracks.resize(count);
+    for (SidecarTrack& t : out.tracks) {
+        t.id = (int)(int32_t)get(p, 4);
+        t.class_id = (int)(int16_t)get(p, 2); // -1 (unknown) survives the round trip
+        int x = (int16_t)get(p, 2), y = (int16_t)get(p, 2), w = (int16_t)get(p, 2), h = (int16_t)get(p, 2);
+        t.box = cv::Rect(x, y, w, h);
+        uint32_t v_bits = (uint32_t)get(p, 4); std::memcpy(&t.velocity, &v_bits, 4);
+        t.flags = (uint8_t)get(p, 1);
+    }
+    return true;
+}
+
+void OverlaySidecarReader::close() {
+    if (file) { std::fclose(file); file = nullptr; }
+    index.clear();
+}
@@ -0,0 +1,100 @@
+#ifndef OVERLAYSIDECAR_H
+#define OVERLAYSIDECAR_H
+
+// Per-frame track metadata stored next to a raw (unannotated) recording,
+// so the overlay can be drawn at whatever resolution it is viewed at and a
+// recording can be searched without decoding it. RecordingWriter writes one
+// sidecar per video segment (PipelineConfig::record_raw), one record per
+// encoded frame, so record n belongs to frame n of the segment.
+//
+// Layout (little-endian, no padding):
+//   header  "OTSC" | u32 version | i32 width | i32 height | f64 fps
+//   frame   i64 source_index | i64 timestamp_us | u16 count | count x track
+//   track   i32 id | i16 class_id | i16 x | i16 y | i16 w | i16 h | f32 velocity | u8 flags
+//   index   u64 offset of every frame record | u64 frame count | u64 index offset | "OTSI"
+// The index is appended by close(); a sidecar without one (the process
+// died mid-recording) is scanned front to back on open instead.
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct TrackOverlay;
+
+static const uint8_t SIDECAR_ZONE = 1;   // SidecarTrack::flags: in any zone
+static const uint8_t SIDECAR_SPEED = 2;  // Over the speed threshold
+static const uint8_t SIDECAR_ZONE_ALERT = 4; // In a zone whose `alert` is set
+
+struct SidecarTrack {
+    int id = -1;
+    int class_id = -1;
+    cv::Rect box;
+    float velocity = 0.f;                // Pixels per second
+    uint8_t flags = 0;                   // SIDECAR_* state on this frame
+};
+
+struct SidecarFrame {
+    long long source_index = -1;         // Frame number in the processed stream
+    long long timestamp_us = 0;          // Wall clock when it was queued for recording
+    std::vector<SidecarTrack> tracks;
+};
+
+// Flattens an overlay snapshot (trajectories are left out: a reader rebuilds
+// them from the boxes of earlier frames)
+void toSidecar(const std::vector<TrackOverlay>& overlay, std::vector<SidecarTrack>& out);
+// "<dir>/name.avi" -> "<dir>/name.tracks"
+std::string sidecarPath(const std::string& video_path);
+
+class OverlaySidecarWriter
+{
+public:
+    OverlaySidecarWriter() = default;
+    ~OverlaySidecarWriter();
+
+    OverlaySidecarWriter(const OverlaySidecarWriter&) = delete;
+    OverlaySidecarWriter& operator=(const OverlaySidecarWriter&) = delete;
+
+    bool open(const std::string& path, cv::Size frame_size, double fps);
+    void write(long long source_index, long long timestamp_us, const std::vector<SidecarTrack>& tracks);
+    void close(); // Appends the index
+    bool isOpen() const { return file != nullptr; }
+
+private:
+    std::FILE* file = nullptr;
+    uint64_t offset = 0;                 // Bytes written so far
+    std::vector<uint64_t> index;         // Offset of every frame record
+    std::vector<unsigned char> buffer;   // One record, reused
+};
+
+class OverlaySidecarReader
+{
+public:
+    OverlaySidecarReader() = default;
+    ~OverlaySidecarReader();
+
+    OverlaySidecarReader(const OverlaySidecarReader&) = delete;
+    OverlaySidecarReader& operator=(const OverlaySidecarReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    cv::Size frameSize() const { return frame_size; }
+    double fps() const { return frame_rate; }
+    size_t frameCount() const { return index.size(); }
+    // Record `n` (0-based frame of the segment); false if out of range or unreadable
+    bool read(size_t n, SidecarFrame& out);
+
+private:
+    std::FILE* file = nullptr;
+    cv::Size frame_size;
+    double frame_rate = 0.0;
+    std::vector<uint64_t> index;
+    std::vector<unsigned char> buffer;
+
+    bool readIndex(uint64_t file_size);
+    void scan(uint64_t file_size);
+};
+
+#endif // OVERLAYSIDECAR_H
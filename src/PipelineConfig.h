@@ -0,0 +1,124 @@
+#ifndef PIPELINECONFIG_H
+#define PIPELINECONFIG_H
+
+#include <opencv2/videoio.hpp>
+
+#include <set>
+#include <string>
+
+// What RecordingWriter does when the encoder falls behind and its queue is full
+enum class RecordFullPolicy {
+    Block,   // Wait for room (recording is lossless, the pipeline slows down)
+    Drop,    // Drop the new frame
+    Degrade  // Lower encode quality once the queue is half full; drop only when full
+};
+
+// What part of the frame the network looks at on a detection frame
+enum class DetectRegionMode {
+    Full,   // Whole frame squashed to input_width x input_height (the original behaviour)
+    Roi,    // Crops around motion and existing tracks; tiles (or full) when nothing stands out
+    Tiles   // Overlapping tile_size tiles covering the frame
+};
+
+// Correlation tracker behind each track
+enum class TrackerEngine {
+    SharedMosse,  // MosseTracker: one grayscale conversion per frame shared by all tracks
+    LegacyMosse,  // cv::legacy::TrackerMOSSE: converts the whole frame again for every track
+    MotionOnly    // No appearance tracker: boxes follow the motion model between detections,
+                  // and a track missed by a detection run is lost (trace replay without video)
+};
+
+// Tuning knobs shared by the GUI worker and the headless CLI.
+// Defaults match the values the original app shipped with, except that the
+// newer pipeline behaviour is on: async_detection, adaptive_detection,
+// tracker_engine = SharedMosse (was cv::legacy MOSSE), association_gate =
+// 9.21 (was IoU only) and detect_min_psr = 8.
+struct PipelineConfig {
+    // Detection
+    float confidence_threshold = 0.4f;
+    float nms_threshold = 0.4f;
+    int input_width = 320;
+    int input_height = 320;
+    int detect_interval = 30;    // Adaptive: longest a track goes without a detection confirming it
+    bool async_detection = true; // Run the network on a worker thread and reconcile later
+    std::set<std::string> desired_classes = {"person", "bicycle", "car", "motorbike", "bus", "truck"};
+    std::string data_path = "../data/"; // Folder holding coco.names / yolov4-tiny.*
+
+    // Detection scheduling (DetectionScheduler)
+    bool adaptive_detection = true;    // false: every detect_interval frames, or whenever nothing is tracked
+    double detect_budget = 0.25;       // Long-run share of frames that triggered detections may use
+    int detect_burst = 3;              // Triggered detections that may run back to back
+    int detect_min_interval = 2;       // Frames between detections, whatever the signals say
+    int detect_max_interval = 90;      // Even an idle scene is checked this often
+    double motion_threshold = 0.003;   // Untracked changed-pixel fraction that counts as activity
+    double edge_margin = 0.08;         // Border band (fraction of width/height) watched for entrants
+    double detect_min_psr = 8.0;       // Detect once an active track's MOSSE peak-to-sidelobe ratio falls below this
+                                       // (the tracker gives up at 5.7); 0 = off. Needs TrackerEngine::SharedMosse
+
+    // Region-of-interest / tiled detection (RoiPlanner)
+    DetectRegionMode detect_regions = DetectRegionMode::Full;
+    double roi_track_grow = 0.5;       // Track box grown by this fraction of its size on each side
+    int roi_min_size = 320;            // Smallest crop side in frame pixels (no upscaling below the input size)
+    int roi_max_regions = 6;           // More crops than this: fall back
+    double roi_max_area = 0.5;         // Crops covering more of the frame than this: fall back
+    int tile_size = 960;               // Tile side in frame pixels
+    int tile_overlap = 96;             // Tiles overlap so an object on a seam is whole in one of them
+
+    // Multi-stream: one network shared by every stream (BatchedDetector)
+    int batch_max = 8;                 // Images per forward pass
+    double batch_deadline_ms = 15.0;   // Longest the first request waits for the batch to fill
+
+    // Tracking
+    double min_iou_threshold = 0.1;
+    double reid_iou_threshold = 0.2;
+    int max_lost_frames = 60;
+    int trajectory_length = 20;
+    TrackerEngine tracker_engine = TrackerEngine::SharedMosse;
+    double processing_scale = 1.0;     // Appearance trackers run on the frame scaled by this (0.1 - 1);
+                                       // track boxes, zones, events and recording stay in native pixels
+
+    // Motion model (MotionModel: constant-velocity Kalman filter per track)
+    int appearance_interval = 1;         // Appearance tracker runs on every k-th frame per track; prediction fills the rest
+    double kalman_process_noise = 1.0;   // Acceleration variance, pixels^2 / frame^4
+    double kalman_tracker_noise = 2.0;   // Appearance tracker centre error, pixels (std)
+    double kalman_detection_noise = 0.1; // Detection centre error, fraction of the box side (std)
+    double association_gate = 9.21;      // Chi-square gate on detection centre vs. track state (2 dof); 0 = off
+    bool parallel_track_update = true; // Spread tracker->update() over cv::parallel_for_
+    int parallel_min_tracks = 4;       // Below this, the thread hand-off costs more than it saves
+
+    // Alerts
+    double speed_threshold_pixels_per_sec = 150.0;
+    std::string zones_file;            // Zone polygons and rules (see ZoneMap.h); empty = top-left quarter as "Restricted"
+
+    // Threading: frames buffered between stages of StagedPipeline
+    int queue_depth = 4;
+
+    // Metrics (MetricsRegistry / MetricsExporter)
+    std::string metrics_file;                     // Prometheus text file rewritten every metrics_interval_sec; empty = off
+    double metrics_interval_sec = 5.0;
+    std::string metrics_stream;                   // `stream` label on this pipeline's counters and gauges; empty = none
+
+    // Track / alert events (EventBus -> EventLogWriter)
+    std::string events_file;                      // JSONL event log, appended to; empty = off
+    int event_queue_depth = 4096;                 // Events buffered per stream before new ones are dropped
+
+    // Recording (RecordingWriter, on its own encoder thread)
+    std::string output_filename_base = "../output_video";
+    int output_fourcc = cv::VideoWriter::fourcc('M','J','P','G');
+    int record_queue_depth = 16;                  // Frames waiting for the encoder
+    RecordFullPolicy record_full_policy = RecordFullPolicy::Degrade;
+    int record_degraded_quality = 50;             // MJPG quality while degraded (normal: encoder default)
+    double record_segment_seconds = 0.0;          // Start a new file after this much video; 0 = never
+    long long record_segment_bytes = 0;           // ...or once the file reaches this size; 0 = never
+    bool record_raw = false;                      // Record the unannotated stream plus a .tracks sidecar per segment
+                                                  // (OverlaySidecar); the worker then draws no overlay at all
+    // Event-triggered recording: nothing is written until a zone or speed alert; each
+    // incident (pre-roll + alerts + post-roll) goes to its own <base>_event_NNN.avi
+    bool record_on_alert = false;
+    double record_preroll_seconds = 5.0;          // Video kept in memory before the first alert
+    double record_postroll_seconds = 10.0;        // Keep recording this long after the last alert
+    long long record_preroll_bytes = 64ll << 20;  // Memory ceiling for the pre-roll (JPEG-compressed)
+    int record_preroll_quality = 85;              // JPEG quality of pre-roll frames
+};
+
+#endif // PIPELINECONFIG_H
@@ -0,0 +1,48 @@
+#include "PrerollBuffer.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+
+void PrerollBuffer::configure(size_t max_frames, size_t max_bytes, int jpeg_quality) {
+    ring.clear(); ring.resize(max_frames);
+    head = 0; count = 0; held = 0; high_water = 0; evicted_ = 0;
+    byte_limit = max_bytes;
+    params = {cv::IMWRITE_JPEG_QUALITY, std::max(1, std::min(100, jpeg_quality))};
+}
+
+size_t PrerollBuffer::footprint(const PrerollFrame& f) {
+    return f.jpeg.capacity() + f.tracks.capacity() * sizeof(SidecarTrack);
+}
+
+void PrerollBuffer::dropOldest(bool free_buffers) {
+    PrerollFrame& old = ring[head];
+    if (free_buffers) {
+        held -= footprint(old);
+        std::vector<unsigned char>().swap(old.jpeg);
+        std::vector<SidecarTrack>().swap(old.tracks);
+    }
+    head = (head + 1) % ring.size();
+    count--;
+    evicted_++;
+}
+
+void PrerollBuffer::push(const cv::Mat& frame, long long frame_index, long long timestamp_us, const std::vector<SidecarTrack>& tracks) {
+    if (ring.empty() || frame.empty()) return;
+    if (count == ring.size()) { dropOldest(false); } // Its slot is overwritten below
+    PrerollFrame& f = ring[(head + count) % ring.size()];
+    held -= footprint(f);
+    if (!cv::imencode(".jpg", frame, f.jpeg, params)) { f.jpeg.clear(); }
+    f.frame_index = frame_index; f.timestamp_us = timestamp_us;
+    f.tracks.assign(tracks.begin(), tracks.end());
+    held += footprint(f);
+    count++;
+    while (held > byte_limit && count > 1) { dropOldest(true); }
+    high_water = std::max(high_water, held);
+}
+
+bool PrerollBuffer::decode(size_t i, cv::Mat& out) const {
+    if (i >= count || at(i).jpeg.empty()) return false;
+    cv::imdecode(at(i).jpeg, cv::IMREAD_COLOR, &out);
+    return !out.empty();
+}
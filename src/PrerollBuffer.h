@@ -0,0 +1,69 @@
+#ifndef PREROLLBUFFER_H
+#define PREROLLBUFFER_H
+
+// The last few seconds of video, JPEG-compressed in memory, for
+// event-triggered recording (PipelineConfig::record_on_alert). The
+// recorder's encoder thread pushes every frame while no incident is open;
+// when an alert fires it decodes the buffer, oldest first, into the new
+// incident file a few frames at a time (popOldest()), queueing live frames
+// behind them until it is empty.
+//
+// Memory is bounded twice: at most `max_frames` frames (the pre-roll
+// length at the stream's frame rate), and at most `max_bytes` of encoded
+// data. Slots are reused, so a steady stream allocates nothing; when the
+// byte budget is exceeded the oldest frames' buffers are freed, so the
+// budget is a true ceiling on what the buffer holds. A frame that alone
+// exceeds the budget is kept (a pre-roll of one frame).
+
+#include "OverlaySidecar.h"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct PrerollFrame {
+    std::vector<unsigned char> jpeg;
+    long long frame_index = -1;
+    long long timestamp_us = 0;
+    std::vector<SidecarTrack> tracks;    // record_raw only
+};
+
+class PrerollBuffer
+{
+public:
+    void configure(size_t max_frames, size_t max_bytes, int jpeg_quality);
+    // Encodes `frame` as the newest entry, evicting the oldest to stay within both bounds
+    void push(const cv::Mat& frame, long long frame_index, long long timestamp_us, const std::vector<SidecarTrack>& tracks);
+    // Forgets every frame; buffers are kept for reuse
+    void clear() { head = 0; count = 0; }
+    // Forgets the oldest frame once it has been written out; buffers are kept for reuse
+    void popOldest() { if (count > 0) { head = (head + 1) % ring.size(); count--; } }
+
+    size_t size() const { return count; }
+    // Entry `i`, 0 = oldest
+    const PrerollFrame& at(size_t i) const { return ring[(head + i) % ring.size()]; }
+    // Decodes entry `i` into `out` (its buffer reused)
+    bool decode(size_t i, cv::Mat& out) const;
+
+    size_t bytes() const { return held; }          // Memory held by encoded frames and their tracks
+    size_t highWater() const { return high_water; }
+    size_t maxFrames() const { return ring.size(); }
+    size_t maxBytes() const { return byte_limit; }
+    uint64_t evicted() const { return evicted_; }  // Frames pushed out before an alert used them
+
+private:
+    std::vector<PrerollFrame> ring;
+    size_t head = 0;
+    size_t count = 0;
+    size_t byte_limit = 0;
+    size_t held = 0;
+    size_t high_water = 0;
+    uint64_t evicted_ = 0;
+    std::vector<int> params;               // imencode() parameters
+
+    static size_t footprint(const PrerollFrame& f);
+    void dropOldest(bool free_buffers);
+};
+
+#endif // PREROLLBUFFER_H
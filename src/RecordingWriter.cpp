@@ -0,0 +1,273 @@
+#include "RecordingWriter.h"
+#include "TrackingPipeline.h" // StageTimings
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+static const int SIZE_CHECK_EVERY = 30; // Frames between file-size checks
+
+static long long fileSize(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return 0;
+    std::fseek(f, 0, SEEK_END);
+    long long size = std::ftell(f);
+    std::fclose(f);
+    return size;
+}
+
+RecordingWriter::RecordingWriter(const PipelineConfig& config)
+    : cfg(config), queue((size_t)std::max(1, config.record_queue_depth)),
+      queue_gauge(MetricsRegistry::global().gauge("objtrack_queue_depth", "Frames waiting in a stage's input queue.",
+                                                  metricLabels({{"stream", config.metrics_stream}, {"queue", "record"}}))),
+      dropped_metric(MetricsRegistry::global().counter("objtrack_record_frames_dropped_total", "Frames the recorder dropped.",
+                                                       metricLabels({{"stream", config.metrics_stream}})))
+{
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    close();
+}
+
+std::string RecordingWriter::segmentPath(int index) const {
+    if (cfg.record_on_alert) return base + cv::format("_event_%03d.avi", index);
+    bool rotating = cfg.record_segment_seconds > 0 || cfg.record_segment_bytes > 0;
+    return rotating ? base + cv::format("_%03d.avi", index) : base + ".avi";
+}
+
+bool RecordingWriter::open(const std::string& base_path, double frame_rate, cv::Size size) {
+    close();
+    base = base_path;
+    fps = (frame_rate > 0 && frame_rate <= 100) ? frame_rate : 30.0;
+    frame_size = size;
+    segment_index = 0;
+    writer_degraded = false; producer_degraded = false; degrade = false; degraded_counter = 0;
+    written_ = 0; dropped_ = 0; degraded_ = 0; write_ticks_ = 0; preroll_bytes_ = 0; preroll_high_ = 0;
+    queue.clear();
+    abort_flag = false;
+    { std::lock_guard<std::mutex> lock(paths_mutex); paths.clear(); }
+
+    in_incident = false; quiet_frames = 0;
+    if (cfg.record_on_alert) {
+        const size_t preroll_frames = (size_t)std::max(0.0, std::ceil(cfg.record_preroll_seconds * fps));
+        preroll.configure(preroll_frames, (size_t)std::max(0ll, cfg.record_preroll_bytes), cfg.record_preroll_quality);
+    } else if (!openSegment()) {
+        return false;
+    }
+    opened = true;
+    worker = std::thread(&RecordingWriter::run, this);
+    return true;
+}
+
+bool RecordingWriter::openSegment() {
+    current_path = segmentPath(segment_index);
+    segment_frames = 0;
+    try {
+        if (!writer.open(current_path, cfg.output_fourcc, fps, frame_size, true)) {
+            std::cerr << "Error: Could not open recording segment " << current_path << std::endl;
+            return false;
+        }
+    } catch (const cv::Exception& ex) {
+        std::cerr << "OpenCV Exception opening recording segment: " << ex.what() << std::endl;
+        return false;
+    }
+    if (cfg.record_raw && !sidecar.open(sidecarPath(current_path), frame_size, fps)) {
+        std::cerr << "Warning: Could not open overlay sidecar for " << current_path << std::endl;
+    }
+    normal_quality = writer.get(cv::VIDEOWRITER_PROP_QUALITY);
+    if (writer_degraded && normal_quality > 0) { writer.set(cv::VIDEOWRITER_PROP_QUALITY, cfg.record_degraded_quality); }
+    std::lock_guard<std::mutex> lock(paths_mutex);
+    paths.push_back(current_path);
+    return true;
+}
+
+void RecordingWriter::finishSegment() {
+    if (!writer.isOpened()) return;
+    writer.release();
+    sidecar.close();
+    if (file_cb) { file_cb(current_path); }
+}
+
+bool RecordingWriter::segmentFull() const {
+    if (segment_frames == 0 || cfg.record_on_alert) return false;
+    if (cfg.record_segment_seconds > 0 && segment_frames >= cfg.record_segment_seconds * fps) return true;
+    if (cfg.record_segment_bytes > 0 && segment_frames % SIZE_CHECK_EVERY == 0) {
+        return fileSize(current_path) >= cfg.record_segment_bytes;
+    }
+    return false;
+}
+
+bool RecordingWriter::write(const cv::Mat& frame, const std::vector<TrackOverlay>* overlay, long long frame_index) {
+    if (!opened || frame.empty()) return false;
+    if (cfg.record_full_policy == RecordFullPolicy::Degrade) {
+        // Hysteresis: degrade at half full, recover once drained to a quarter
+        size_t occupancy = queue.size(), capacity = queue.capacity();
+        if (!producer_degraded && occupancy * 2 >= capacity) { producer_degraded = true; degrade.store(true, std::memory_order_relaxed); }
+        else if (producer_degraded && occupancy * 4 <= capacity) { producer_degraded = false; degrade.store(false, std::memory_order_relaxed); }
+    }
+    queue_gauge.set((double)queue.size());
+    pending.frame = frame; // Shares pixels; the capture stage will not reuse them while queued
+    pending.frame_index = frame_index;
+    pending.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    if (cfg.record_raw && overlay) { toSidecar(*overlay, pending.tracks); }
+    else { pending.tracks.clear(); }
+    pending.alert = false;
+    if (overlay) { for (const TrackOverlay& t : *overlay) { if (t.alerting()) { pending.alert = true; break; } } }
+    bool queued = cfg.record_full_policy == RecordFullPolicy::Block ? queue.push(pending, abort_flag) : queue.tryPush(pending);
+    if (!queued) {
+        pending.frame.release();
+        if (cfg.record_full_policy != RecordFullPolicy::Block) { dropped_.fetch_add(1, std::memory_order_relaxed); dropped_metric.add(); }
+    }
+    return queued;
+}
+
+void RecordingWriter::close() {
+    if (!opened) return;
+    Item end_marker; // Empty frame tells the encoder to finish
+    queue.push(end_marker, abort_flag);
+    if (worker.joinable()) { worker.join(); }
+    finishSegment();
+    in_incident = false;
+    preroll.clear();
+    opened = false;
+}
+
+// --- Encoder thread ---
+void RecordingWriter::run() {
+    Item item;
+    cv::Mat& frame = item.frame;
+    while (queue.pop(item, abort_flag)) {
+        if (frame.empty()) break;
+
+        bool want_degraded = degrade.load(std::memory_order_relaxed);
+        if (want_degraded != writer_degraded) {
+            writer_degraded = want_degraded;
+            if (normal_quality > 0 && writer.isOpened()) {
+                writer.set(cv::VIDEOWRITER_PROP_QUALITY, writer_degraded ? cfg.record_degraded_quality : normal_quality);
+            }
+        }
+        // Encoder without a quality knob: halve the frame rate instead
+        if (writer_degraded && normal_quality <= 0 && (degraded_counter++ % 2) == 1) {
+            dropped_.fetch_add(1, std::memory_order_relaxed); dropped_metric.add();
+            frame.release();
+            continue;
+        }
+
+        if (cfg.record_on_alert) {
+            if (!followIncident(item)) { frame.release(); continue; } // Kept in the pre-roll
+            if (preroll.size() > 0) { flushPreroll(&item); frame.release(); continue; } // Incident still catching up
+        }
+        if (segmentFull()) {
+            finishSegment();
+            segment_index++;
+            openSegment();
+        }
+        if (!writer.isOpened()) { dropped_.fetch_add(1, std::memory_order_relaxed); dropped_metric.add(); frame.release(); continue; }
+
+        encode(frame, item.frame_index, item.timestamp_us, item.tracks);
+        frame.release(); // Hand the buffer back before waiting for the next frame
+    }
+    if (in_incident) { flushPreroll(nullptr); }
+}
+
+void RecordingWriter::encode(const cv::Mat& frame, long long frame_index, long long timestamp_us, const std::vector<SidecarTrack>& tracks) {
+    long long start_tick = cv::getTickCount();
+    try {
+        writer.write(frame);
+    } catch (const cv::Exception& ex) {
+        std::cerr << "OpenCV Exception during video_writer.write(): " << ex.what() << std::endl;
+    }
+    const long long write_ticks = cv::getTickCount() - start_tick;
+    write_ticks_.fetch_add((uint64_t)write_ticks, std::memory_order_relaxed);
+    stageLatency(PipelineStage::Encode).observe(((double)write_ticks / cv::getTickFrequency()) * 1000);
+    if (sidecar.isOpen()) { sidecar.write(frame_index, timestamp_us, tracks); } // Record n <-> frame n
+    written_.fetch_add(1, std::memory_order_relaxed);
+    if (writer_degraded) { degraded_.fetch_add(1, std::memory_order_relaxed); }
+    segment_frames++;
+}
+
+// Quiet frames go to the pre-roll. The first alert opens an incident file
+// that the pre-roll is flushed into (see flushPreroll()); every frame up to
+// record_postroll_seconds after the last alert then goes to that file, and
+// the next quiet frame after that starts a fresh pre-roll (so no frame is
+// written twice).
+bool RecordingWriter::followIncident(const Item& item) {
+    if (in_incident) {
+        if (item.alert) { quiet_frames = 0; return true; }
+        if (++quiet_frames <= (long long)std::llround(cfg.record_postroll_seconds * fps)) return true;
+        flushPreroll(nullptr); // Post-roll shorter than the flush
+        finishSegment();
+        in_incident = false;
+        segment_index++;
+    }
+    if (!item.alert) {
+        preroll.push(item.frame, item.frame_index, item.timestamp_us, item.tracks);
+        preroll_bytes_.store(preroll.bytes(), std::memory_order_relaxed);
+        preroll_high_.store(preroll.highWater(), std::memory_order_relaxed);
+        return false;
+    }
+    if (!openSegment()) { dropped_.fetch_add(1, std::memory_order_relaxed); dropped_metric.add(); return false; }
+    in_incident = true;
+    quiet_frames = 0;
+    return true;
+}
+
+// One step of the pre-roll flush per live frame. Ring frames are written
+// oldest first while the queue is below a quarter full (at least one, so
+// the ring has room for `live`); the rest of the queue's slack is left to
+// live frames. Ring frames evicted by the byte budget meanwhile are lost.
+void RecordingWriter::flushPreroll(const Item* live) {
+    size_t written = 0;
+    while (preroll.size() > 0 && (!live || written == 0 || queue.size() * 4 <= queue.capacity())) {
+        const PrerollFrame& f = preroll.at(0);
+        if (preroll.decode(0, decoded)) { encode(decoded, f.frame_index, f.timestamp_us, f.tracks); }
+        preroll.popOldest();
+        written++;
+    }
+    if (live) {
+        if (preroll.size() == 0) { encode(live->frame, live->frame_index, live->timestamp_us, live->tracks); }
+        else { preroll.push(live->frame, live->frame_index, live->timestamp_us, live->tracks); }
+    }
+    preroll_bytes_.store(preroll.bytes(), std::memory_order_relaxed);
+    preroll_high_.store(preroll.highWater(), std::memory_order_relaxed);
+}
+
+std::vector<std::string> RecordingWriter::segmentPaths() const {
+    std::lock_guard<std::mutex> lock(paths_mutex);
+    return paths;
+}
+
+std::string RecordingWriter::lastSegmentPath() const {
+    std::lock_guard<std::mutex> lock(paths_mutex);
+    return paths.empty() ? std::string() : paths.back();
+}
+
+RecordingStats RecordingWriter::stats() const {
+    RecordingStats s;
+    s.frames_written = written_.load(std::memory_order_relaxed);
+    s.frames_dropped = dropped_.load(std::memory_order_relaxed);
+    s.frames_degraded = degraded_.load(std::memory_order_relaxed);
+    { std::lock_guard<std::mutex> lock(paths_mutex); s.segments = paths.size(); }
+    if (s.frames_written > 0) {
+        s.write_ms = ((double)write_ticks_.load(std::memory_order_relaxed) / cv::getTickFrequency()) * 1000 / s.frames_written;
+        s.write_fps = s.write_ms > 1e-6 ? 1000.0 / s.write_ms : 0.0;
+    }
+    s.queue_occupancy = queue.size();
+    s.queue_capacity = queue.capacity();
+    s.queue_high_water = queue.highWater();
+    s.preroll_bytes = preroll_bytes_.load(std::memory_order_relaxed);
+    s.preroll_high_water = preroll_high_.load(std::memory_order_relaxed);
+    s.preroll_limit = cfg.record_on_alert ? (size_t)std::max(0ll, cfg.record_preroll_bytes) : 0;
+    return s;
+}
+
+void RecordingWriter::fillTimings(StageTimings& t) const {
+    if (!opened) { t.record_queue_capacity = 0; return; }
+    RecordingStats s = stats();
+    t.record_fps = s.write_fps;
+    t.record_queue = (int)s.queue_occupancy;
+    t.record_queue_capacity = (int)s.queue_capacity;
+}
@@ -0,0 +1,167 @@
+#ifndef RECORDINGWRITER_H
+#define RECORDINGWRITER_H
+
+// Writes the annotated stream on its own encoder thread so disk stalls and
+// MJPG encode cost no longer hold up tracking. Frames are handed over
+// through a bounded queue (sharing pixels, no copy); what happens when the
+// queue is full is set by PipelineConfig::record_full_policy. Output can be
+// split into time- or size-limited segments.
+//
+// With PipelineConfig::record_raw the frames arrive unannotated and the
+// overlay travels with them: the encoder thread writes it to a sidecar
+// (OverlaySidecar, "name.tracks" next to "name.avi") record for record with
+// the frames it encodes, rotating with the segments.
+//
+// With PipelineConfig::record_on_alert nothing is written while all is
+// quiet: the encoder thread keeps the last record_preroll_seconds of frames
+// JPEG-compressed in a bounded PrerollBuffer. A frame with a zone or speed
+// alert opens an incident file (<base>_event_NNN.avi), the pre-roll is
+// decoded into it, and recording continues until record_postroll_seconds
+// of video without an alert have followed. Segment limits do not apply.
+// The pre-roll is flushed in steps, not in one go (150 frames at 1080p take
+// seconds to decode and encode): until it is empty, live frames join the
+// back of the ring and the encoder writes ring frames only while its queue
+// stays below a quarter full, at least one per live frame. So the frames
+// right after the alert are not dropped (Degrade/Drop) and capture does not
+// stall (Block) while the pre-roll goes out; they do pass through JPEG.
+
+#include "Metrics.h"
+#include "OverlaySidecar.h"
+#include "PrerollBuffer.h"
+#include "PipelineConfig.h"
+#include "SpscQueue.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct StageTimings;
+struct TrackOverlay;
+
+struct RecordingStats {
+    uint64_t frames_written = 0;
+    uint64_t frames_dropped = 0;    // Queue full (Drop/Degrade), or skipped while degraded
+    uint64_t frames_degraded = 0;   // Written at reduced quality
+    uint64_t segments = 0;
+    double write_ms = 0.0;          // Average encoder time per written frame
+    double write_fps = 0.0;         // Frames the encoder could sustain (1000 / write_ms)
+    size_t queue_occupancy = 0;
+    size_t queue_capacity = 0;
+    size_t queue_high_water = 0;
+    size_t preroll_bytes = 0;       // record_on_alert: memory held by the pre-roll now...
+    size_t preroll_high_water = 0;  // ...and at most
+    size_t preroll_limit = 0;
+};
+
+class RecordingWriter
+{
+public:
+    // A finished file: a segment rotated out, an incident's post-roll over, or close()
+    using FileCallback = std::function<void(const std::string& path)>;
+
+    explicit RecordingWriter(const PipelineConfig& config = PipelineConfig());
+    ~RecordingWriter();
+
+    RecordingWriter(const RecordingWriter&) = delete;
+    RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+    // Opens the first segment (so a bad path is reported here; with
+    // record_on_alert the first file waits for an alert) and starts the
+    // encoder thread. `base_path` has no extension; ".avi", "_NNN.avi" or
+    // "_event_NNN.avi" is added.
+    bool open(const std::string& base_path, double fps, cv::Size frame_size);
+    // Called on the encoder thread (or in close()) for every finished file; set before open()
+    void setFileCallback(FileCallback cb) { file_cb = std::move(cb); }
+    bool isOpen() const { return opened; }
+
+    // Producer side (one thread). Returns false if the frame was not queued.
+    // `overlay` and `frame_index` are only kept in record_raw mode; with
+    // record_on_alert the overlay's alert flags decide what is recorded.
+    bool write(const cv::Mat& frame, const std::vector<TrackOverlay>* overlay = nullptr, long long frame_index = -1);
+
+    // Drains the queue, finishes the current segment and joins the thread
+    void close();
+
+    std::vector<std::string> segmentPaths() const;
+    std::string lastSegmentPath() const;
+    RecordingStats stats() const;
+    void fillTimings(StageTimings& t) const; // Writer figures for the on-screen overlay
+
+private:
+    // Queue slot. Moving swaps the track vectors, so the producer, the ring
+    // and the encoder trade buffers instead of allocating per frame.
+    struct Item {
+        cv::Mat frame;                    // Empty = end of recording
+        long long frame_index = -1;
+        long long timestamp_us = 0;
+        bool alert = false;               // A track is in an alerting zone or over speed
+        std::vector<SidecarTrack> tracks;
+        Item() = default;
+        Item(Item&& other) noexcept { *this = std::move(other); }
+        Item& operator=(Item&& other) noexcept {
+            frame = std::move(other.frame); frame_index = other.frame_index; timestamp_us = other.timestamp_us; alert = other.alert;
+            tracks.swap(other.tracks);
+            return *this;
+        }
+    };
+
+    PipelineConfig cfg;
+    SpscQueue<Item> queue;
+    std::thread worker;
+    std::atomic<bool> abort_flag{false};  // Hard stop: blocked push/pop give up
+    bool opened = false;
+
+    // Encoder thread state
+    cv::VideoWriter writer;
+    OverlaySidecarWriter sidecar;         // record_raw only
+    std::string base;
+    double fps = 30.0;
+    cv::Size frame_size;
+    std::string current_path;
+    int segment_index = 0;
+    long long segment_frames = 0;
+    double normal_quality = 0.0;          // 0 = encoder has no quality knob
+    bool writer_degraded = false;
+    long long degraded_counter = 0;
+    PrerollBuffer preroll;                // record_on_alert only
+    cv::Mat decoded;                      // Pre-roll frame being flushed
+    bool in_incident = false;
+    long long quiet_frames = 0;           // Frames since the incident's last alert
+    FileCallback file_cb;
+
+    // Producer state
+    Item pending;
+    bool producer_degraded = false;
+    std::atomic<bool> degrade{false};     // Producer -> encoder
+
+    mutable std::mutex paths_mutex;
+    std::vector<std::string> paths;       // Guarded by paths_mutex
+
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> degraded_{0};
+    std::atomic<uint64_t> write_ticks_{0};
+    std::atomic<size_t> preroll_bytes_{0};
+    std::atomic<size_t> preroll_high_{0};
+    Gauge& queue_gauge;                   // Exported (MetricsRegistry)
+    Counter& dropped_metric;
+
+    void run();
+    void encode(const cv::Mat& frame, long long frame_index, long long timestamp_us, const std::vector<SidecarTrack>& tracks);
+    bool followIncident(const Item& item); // record_on_alert: true if `item` goes to a file
+    // Writes pre-roll frames (all if `live` is null, else as the queue allows), then
+    // `live` directly once the ring is empty or behind the remaining frames
+    void flushPreroll(const Item* live);
+    bool openSegment();
+    void finishSegment();
+    bool segmentFull() const;
+    std::string segmentPath(int index) const;
+};
+
+#endif // RECORDINGWRITER_H
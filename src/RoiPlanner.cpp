@@ -0,0 +1,93 @@
+#include "RoiPlanner.h"
+
+#include <algorithm>
+
+RoiPlanner::RoiPlanner(const PipelineConfig& config) : cfg(config) {}
+
+void RoiPlanner::tiles(cv::Size frame, int tile_size, int overlap, std::vector<cv::Rect>& out) {
+    out.clear();
+    const int tw = std::min(tile_size, frame.width), th = std::min(tile_size, frame.height);
+    const int stride = std::max(1, tile_size - overlap);
+    // Last tile in each direction is pinned to the frame edge
+    for (int y = 0;; y += stride) {
+        int ty = std::min(y, frame.height - th);
+        for (int x = 0;; x += stride) {
+            int tx = std::min(x, frame.width - tw);
+            out.emplace_back(tx, ty, tw, th);
+            if (tx + tw >= frame.width) break;
+        }
+        if (ty + th >= frame.height) break;
+    }
+}
+
+void RoiPlanner::fallback(cv::Size frame) {
+    if (frame.width > cfg.tile_size || frame.height > cfg.tile_size) { tiles(frame, cfg.tile_size, cfg.tile_overlap, regions); }
+    else { regions.assign(1, cv::Rect(0, 0, frame.width, frame.height)); }
+}
+
+// Union rects whose intersection is at least `min_overlap` of the smaller
+// one (0: any touch), until nothing changes
+void RoiPlanner::mergeOverlapping(std::vector<cv::Rect>& rects, double min_overlap) const {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < rects.size() && !merged; ++i) {
+            for (size_t j = i + 1; j < rects.size(); ++j) {
+                int inter = (rects[i] & rects[j]).area();
+                bool touch = min_overlap <= 0 ? inter > 0 : inter >= min_overlap * std::min(rects[i].area(), rects[j].area());
+                if (!touch) continue;
+                rects[i] |= rects[j];
+                rects.erase(rects.begin() + j);
+                merged = true;
+                break;
+            }
+        }
+    }
+}
+
+// Square with side max(w, h, roi_min_size), same centre, shifted inside the frame
+cv::Rect RoiPlanner::squareUp(const cv::Rect& r, cv::Size frame) const {
+    int side = std::max({r.width, r.height, cfg.roi_min_size});
+    int w = std::min(side, frame.width), h = std::min(side, frame.height);
+    int x = r.x + r.width / 2 - w / 2, y = r.y + r.height / 2 - h / 2;
+    x = std::max(0, std::min(x, frame.width - w)); y = std::max(0, std::min(y, frame.height - h));
+    return cv::Rect(x, y, w, h);
+}
+
+const std::vector<cv::Rect>& RoiPlanner::plan(cv::Size frame, const cv::Mat& motion_mask, const std::vector<cv::Rect>& track_boxes) {
+    regions.clear();
+    if (cfg.detect_regions == DetectRegionMode::Full || frame.area() == 0) { regions.emplace_back(0, 0, frame.width, frame.height); return regions; }
+    if (cfg.detect_regions == DetectRegionMode::Tiles) { tiles(frame, cfg.tile_size, cfg.tile_overlap, regions); return regions; }
+
+    const cv::Rect bounds(0, 0, frame.width, frame.height);
+    candidates.clear();
+    for (const cv::Rect& b : track_boxes) {
+        int gx = (int)(b.width * cfg.roi_track_grow), gy = (int)(b.height * cfg.roi_track_grow);
+        cv::Rect r = cv::Rect(b.x - gx, b.y - gy, b.width + 2 * gx, b.height + 2 * gy) & bounds;
+        if (r.area() > 0) { candidates.push_back(r); }
+    }
+    if (!motion_mask.empty()) {
+        const double sx = (double)frame.width / motion_mask.cols, sy = (double)frame.height / motion_mask.rows;
+        int n = cv::connectedComponentsWithStats(motion_mask, labels, stats, centroids, 8, CV_32S);
+        for (int i = 1; i < n; ++i) { // 0 is background
+            const int* s = stats.ptr<int>(i);
+            if (s[cv::CC_STAT_AREA] < 2) continue; // Single-pixel noise
+            cv::Rect r((int)((s[cv::CC_STAT_LEFT] - 1) * sx), (int)((s[cv::CC_STAT_TOP] - 1) * sy),
+                       (int)((s[cv::CC_STAT_WIDTH] + 2) * sx), (int)((s[cv::CC_STAT_HEIGHT] + 2) * sy));
+            r &= bounds;
+            if (r.area() > 0) { candidates.push_back(r); }
+        }
+    }
+    if (candidates.empty()) { fallback(frame); return regions; }
+
+    mergeOverlapping(candidates, 0.0);
+    for (cv::Rect& r : candidates) { r = squareUp(r, frame); }
+    mergeOverlapping(candidates, 0.3); // Squares that mostly cover each other
+    for (cv::Rect& r : candidates) { r = squareUp(r, frame); }
+
+    long long area = 0;
+    for (const cv::Rect& r : candidates) { area += r.area(); }
+    if ((int)candidates.size() > cfg.roi_max_regions || area > cfg.roi_max_area * frame.area()) { fallback(frame); return regions; }
+    regions.swap(candidates);
+    return regions;
+}
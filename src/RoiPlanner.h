@@ -0,0 +1,41 @@
+#ifndef ROIPLANNER_H
+#define ROIPLANNER_H
+
+// Picks the parts of a frame the network should look at (see
+// DetectRegionMode). In Roi mode candidates come from connected components
+// of the scheduler's untracked-motion mask and from grown track boxes;
+// overlapping candidates are merged and each is squared up to at least
+// roi_min_size so the network sees it at (close to) native resolution.
+// When there is nothing to go on, or the crops would cover too much of the
+// frame, it falls back to tiles on frames larger than one tile and to the
+// full frame otherwise.
+
+#include "PipelineConfig.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+class RoiPlanner
+{
+public:
+    explicit RoiPlanner(const PipelineConfig& config = PipelineConfig());
+
+    // Regions in frame coordinates; valid until the next call.
+    // `motion_mask` is a (thumbnail-sized) binary mask, may be empty.
+    const std::vector<cv::Rect>& plan(cv::Size frame, const cv::Mat& motion_mask, const std::vector<cv::Rect>& track_boxes);
+
+    static void tiles(cv::Size frame, int tile_size, int overlap, std::vector<cv::Rect>& out);
+
+private:
+    PipelineConfig cfg;
+    std::vector<cv::Rect> regions;
+    std::vector<cv::Rect> candidates;
+    cv::Mat labels, stats, centroids;
+
+    void mergeOverlapping(std::vector<cv::Rect>& rects, double min_overlap) const;
+    cv::Rect squareUp(const cv::Rect& r, cv::Size frame) const;
+    void fallback(cv::Size frame);
+};
+
+#endif // ROIPLANNER_H
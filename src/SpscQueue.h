@@ -0,0 +1,104 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+// Bounded lock-free single-producer / single-consumer ring buffer used to
+// connect pipeline stages. One slot is kept free to tell full from empty.
+// Blocking push/pop spin briefly, then yield, then sleep, and count every
+// call that had to wait as a stall.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) : ring(capacity < 1 ? 2 : capacity + 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side. Moves from `item` only on success.
+    bool tryPush(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t next = increment(head);
+        if (next == tail_.load(std::memory_order_acquire)) return false; // Full
+        ring[head] = std::move(item);
+        head_.store(next, std::memory_order_release);
+        size_t occ = size();
+        size_t hw = high_water_.load(std::memory_order_relaxed);
+        if (occ > hw) high_water_.store(occ, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer side.
+    bool tryPop(T& out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false; // Empty
+        out = std::move(ring[tail]);
+        tail_.store(increment(tail), std::memory_order_release);
+        return true;
+    }
+
+    // Blocking variants; give up (return false) once `cancel` is set.
+    bool push(T& item, const std::atomic<bool>& cancel) {
+        if (tryPush(item)) return true;
+        full_stalls_.fetch_add(1, std::memory_order_relaxed);
+        for (int spin = 0; !cancel.load(std::memory_order_relaxed); ++spin) {
+            backoff(spin);
+            if (tryPush(item)) return true;
+        }
+        return false;
+    }
+
+    bool pop(T& out, const std::atomic<bool>& cancel) {
+        if (tryPop(out)) return true;
+        empty_stalls_.fetch_add(1, std::memory_order_relaxed);
+        for (int spin = 0; !cancel.load(std::memory_order_relaxed); ++spin) {
+            backoff(spin);
+            if (tryPop(out)) return true;
+        }
+        return false;
+    }
+
+    // --- Counters (approximate when read from a third thread) ---
+    size_t capacity() const { return ring.size() - 1; }
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return head >= tail ? head - tail : head + ring.size() - tail;
+    }
+    size_t highWater() const { return high_water_.load(std::memory_order_relaxed); }
+    uint64_t fullStalls() const { return full_stalls_.load(std::memory_order_relaxed); }
+    uint64_t emptyStalls() const { return empty_stalls_.load(std::memory_order_relaxed); }
+
+    // Only safe while neither side is running
+    void clear() {
+        T discard;
+        while (tryPop(discard)) {}
+        high_water_.store(0); full_stalls_.store(0); empty_stalls_.store(0);
+    }
+
+private:
+    size_t increment(size_t i) const { return (i + 1 == ring.size()) ? 0 : i + 1; }
+
+    static void backoff(int spin) {
+        if (spin < 64) { /* busy spin */ }
+        else if (spin < 256) { std::this_thread::yield(); }
+        else { std::this_thread::sleep_for(std::chrono::microseconds(100)); }
+    }
+
+    std::vector<T> ring;
+    alignas(64) std::atomic<size_t> head_{0}; // Written by producer
+    alignas(64) std::atomic<size_t> tail_{0}; // Written by consumer
+    alignas(64) std::atomic<size_t> high_water_{0};
+    std::atomic<uint64_t> full_stalls_{0};
+    std::atomic<uint64_t> empty_stalls_{0};
+};
+
+#endif // SPSCQUEUE_H
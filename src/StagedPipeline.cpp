@@ -0,0 +1,226 @@
+#include "StagedPipeline.h"
+#include "AsyncDetector.h"
+
+#include <iostream>
+
+static double ticksToMs(long long ticks) {
+    return ((double)ticks / cv::getTickFrequency()) * 1000;
+}
+
+StagedPipeline::StagedPipeline(TrackingPipeline& pipeline, size_t queue_depth)
+    : pipeline(pipeline),
+      to_detect(queue_depth), to_track(queue_depth), to_render(queue_depth), to_encode(queue_depth),
+      packet_pool(4 * queue_depth + StageCount) // Every packet that can be in flight at once
+{
+    static const char* names[StageCount] = {"capture", "detect", "track", "render", "encode"};
+    for (int s = Detect; s < StageCount; ++s) {
+        queue_gauges[s] = &MetricsRegistry::global().gauge("objtrack_queue_depth", "Frames waiting in a stage's input queue.",
+                                                           metricLabels({{"stream", pipeline.config().metrics_stream}, {"queue", names[s]}}));
+    }
+}
+
+StagedPipeline::~StagedPipeline()
+{
+    stop();
+}
+
+bool StagedPipeline::start(cv::VideoCapture* capture, RecordingWriter* recording_writer, FrameCallback frame_cb, EndCallback end_cb) {
+    if (running || !capture || !capture->isOpened()) return false;
+    cap = capture; recorder = recording_writer;
+    on_frame = std::move(frame_cb); on_end = std::move(end_cb);
+
+    to_detect.clear(); to_track.clear(); to_render.clear(); to_encode.clear(); packet_pool.clear();
+    for (StageCounters& c : counters) { c.frames = 0; c.busy_ticks = 0; }
+    stage_totals = StageTotals();
+    throughput_fps = 0.0;
+    end_reason.clear();
+    stop_flag = false;
+    async_detection = pipeline.asyncDetector() != nullptr;
+    record_raw = pipeline.config().record_raw;
+    running = true;
+
+    threads.emplace_back(&StagedPipeline::encodeLoop, this);
+    threads.emplace_back(&StagedPipeline::renderLoop, this);
+    threads.emplace_back(&StagedPipeline::trackLoop, this);
+    if (!async_detection) { threads.emplace_back(&StagedPipeline::detectLoop, this); }
+    threads.emplace_back(&StagedPipeline::captureLoop, this);
+    return true;
+}
+
+void StagedPipeline::stop() {
+    stop_flag = true;
+    for (std::thread& t : threads) {
+        if (t.joinable() && t.get_id() != std::this_thread::get_id()) { t.join(); }
+        else if (t.joinable()) { t.detach(); } // stop() from a callback: the thread exits on its own
+    }
+    threads.clear();
+    running = false;
+}
+
+void StagedPipeline::addBusy(Stage stage, long long start_tick) {
+    counters[stage].frames.fetch_add(1, std::memory_order_relaxed);
+    counters[stage].busy_ticks.fetch_add((uint64_t)(cv::getTickCount() - start_tick), std::memory_order_relaxed);
+}
+
+// --- Stage 1: Capture / decode ---
+void StagedPipeline::captureLoop() {
+    SpscQueue<FramePacket>& out = async_detection ? to_track : to_detect;
+    long long index = 0;
+    while (!stop_flag) {
+        FramePacket packet;
+        if (packet_pool.acquire(packet)) {
+            // Reuse the buffers, but never write into pixels a frame
+            // callback is still holding on to
+            if (!soleOwner(packet.frame)) { packet.frame.release(); }
+            packet.run_detection = false;
+            packet.detections.clear();
+            packet.timings = StageTimings();
+        }
+        packet.capture_tick = cv::getTickCount();
+        bool success = false;
+        try {
+            success = cap->read(packet.frame);
+        } catch (const cv::Exception& ex) {
+            std::cerr << "OpenCV Exception during cap.read(): " << ex.what() << std::endl;
+            end_reason = "Error: Failed to read frame from source.";
+            break;
+        }
+        if (!success || packet.frame.empty()) { end_reason = "Status: End of video file or camera error."; break; }
+        packet.index = index++;
+        packet.timings.capture_ms = ticksToMs(cv::getTickCount() - packet.capture_tick);
+        stageLatency(PipelineStage::Capture).observe(packet.timings.capture_ms);
+        addBusy(Capture, packet.capture_tick);
+        if (!out.push(packet, stop_flag)) return;
+    }
+    FramePacket end_marker; // index == -1
+    out.push(end_marker, stop_flag);
+}
+
+// --- Stage 2: Detection (network forward + decode) ---
+void StagedPipeline::detectLoop() {
+    FramePacket packet;
+    while (to_detect.pop(packet, stop_flag)) {
+        queue_gauges[Detect]->set((double)to_detect.size());
+        if (packet.index >= 0) {
+            long long start_tick = cv::getTickCount();
+            packet.run_detection = pipeline.shouldDetect(packet.frame, packet.index); // Track signals lag by the queue depth
+            if (packet.run_detection) { pipeline.detect(packet.frame, packet.detections, packet.timings.detection_ms); }
+            addBusy(Detect, start_tick);
+        }
+        bool end = packet.index < 0;
+        if (!to_track.push(packet, stop_flag) || end) return;
+    }
+}
+
+// --- Stage 3: Tracker update + association (owns all track state) ---
+void StagedPipeline::trackLoop() {
+    double last_detection_ms = 0.0;
+    FramePacket packet;
+    while (to_track.pop(packet, stop_flag)) {
+        queue_gauges[Track]->set((double)to_track.size());
+        if (packet.index >= 0) {
+            long long start_tick = cv::getTickCount();
+            pipeline.updateTracks(packet.frame);
+            packet.timings.tracker_update_ms = pipeline.lastTimings().tracker_update_ms;
+            if (async_detection) {
+                packet.run_detection = pipeline.stepAsyncDetection(packet.frame, packet.index, packet.timings.detection_ms);
+            } else if (packet.run_detection) {
+                pipeline.recordTrace(packet.index, packet.detections);
+                pipeline.associateAndTrack(packet.frame, packet.detections.boxes, packet.detections.classIds);
+            }
+            if (packet.run_detection) {
+                last_detection_ms = packet.timings.detection_ms;
+            } else {
+                packet.timings.detection_ms = last_detection_ms; // Keep the on-screen figure steady
+            }
+            pipeline.collectOverlay(packet.overlay);
+            addBusy(Track, start_tick);
+        }
+        bool end = packet.index < 0;
+        if (!to_render.push(packet, stop_flag) || end) return;
+    }
+}
+
+// --- Stage 4: Overlay rendering ---
+void StagedPipeline::renderLoop() {
+    long long last_done_tick = 0;
+    double fps = 0.0;
+    FramePacket packet;
+    while (to_render.pop(packet, stop_flag)) {
+        queue_gauges[Render]->set((double)to_render.size());
+        if (packet.index >= 0) {
+            long long start_tick = cv::getTickCount();
+            if (recorder) { recorder->fillTimings(packet.timings); }
+            if (!record_raw) { pipeline.drawOverlay(packet.frame, packet.overlay, packet.index, packet.timings, fps); }
+            long long now = cv::getTickCount();
+            if (last_done_tick > 0) {
+                double interval_ms = ticksToMs(now - last_done_tick);
+                if (interval_ms > 1e-3) { fps = fps > 0 ? 0.9 * fps + 0.1 * (1000.0 / interval_ms) : 1000.0 / interval_ms; }
+                throughput_fps.store(fps, std::memory_order_relaxed);
+            }
+            last_done_tick = now;
+            addBusy(Render, start_tick);
+        }
+        bool end = packet.index < 0;
+        if (!to_encode.push(packet, stop_flag) || end) return;
+    }
+}
+
+// --- Stage 5: Encode / hand-off ---
+void StagedPipeline::encodeLoop() {
+    FramePacket packet;
+    while (to_encode.pop(packet, stop_flag)) {
+        queue_gauges[Encode]->set((double)to_encode.size());
+        if (packet.index < 0) {
+            if (on_end) { on_end(end_reason); }
+            return;
+        }
+        long long start_tick = cv::getTickCount();
+        if (recorder && recorder->isOpen()) { recorder->write(packet.frame, &packet.overlay, packet.index); } // Queued, encoded on the writer's thread
+        // Latency from capture to hand-off, not the sum of stage times
+        packet.timings.total_ms = ticksToMs(cv::getTickCount() - packet.capture_tick);
+        if (on_frame) { on_frame(packet.frame, packet.overlay, packet.timings); }
+        stage_totals.add(packet.timings, packet.run_detection);
+        addBusy(Encode, start_tick);
+        packet_pool.release(packet);
+    }
+}
+
+std::vector<StageReport> StagedPipeline::report() const {
+    static const char* names[StageCount] = {"capture", "detect", "track", "render", "encode"};
+    const SpscQueue<FramePacket>* inputs[StageCount] = {nullptr, &to_detect, &to_track, &to_render, &to_encode};
+    const SpscQueue<FramePacket>* outputs[StageCount] = {&to_detect, &to_track, &to_render, &to_encode, nullptr};
+
+    std::vector<StageReport> out;
+    for (int s = 0; s < StageCount; ++s) {
+        StageReport r;
+        r.name = names[s];
+        r.frames = counters[s].frames.load(std::memory_order_relaxed);
+        r.busy_ms = ticksToMs((long long)counters[s].busy_ticks.load(std::memory_order_relaxed));
+        if (inputs[s]) {
+            r.input_stalls = inputs[s]->emptyStalls();
+            r.queue_occupancy = inputs[s]->size();
+            r.queue_capacity = inputs[s]->capacity();
+            r.queue_high_water = inputs[s]->highWater();
+        }
+        if (outputs[s]) { r.output_stalls = outputs[s]->fullStalls(); }
+        out.push_back(r);
+    }
+
+    // Async mode: the detect row describes the detector thread. Its "queue"
+    // is the single snapshot slot and input stalls are snapshots refused
+    // because the previous one was still running.
+    const AsyncDetector* detector = pipeline.asyncDetector();
+    if (async_detection && detector) {
+        StageReport& r = out[Detect];
+        r.frames = detector->completed();
+        r.busy_ms = detector->busyMs();
+        r.input_stalls = detector->skipped();
+        r.output_stalls = 0;
+        r.queue_occupancy = detector->idle() ? 0 : 1;
+        r.queue_capacity = 1;
+        r.queue_high_water = detector->submitted() > 0 ? 1 : 0;
+        out[Capture].output_stalls = to_track.fullStalls();
+    }
+    return out;
+}
@@ -0,0 +1,125 @@
+#ifndef STAGEDPIPELINE_H
+#define STAGEDPIPELINE_H
+
+// Multi-threaded driver for TrackingPipeline. Each stage runs on its own
+// thread and hands frames to the next through a bounded SpscQueue:
+//
+//   capture -> detect -> track -> render -> encode
+//
+// so steady-state throughput is set by the slowest stage rather than the
+// sum of all of them. The tracking state only ever lives on the track
+// thread; the render stage draws from a per-frame TrackOverlay snapshot.
+// With PipelineConfig::record_raw it draws nothing: the snapshot goes on to
+// the recorder's sidecar and the frame callback, which draw it if they want.
+//
+// With PipelineConfig::async_detection the detect stage is replaced by the
+// pipeline's AsyncDetector thread: the track stage submits snapshots and
+// reconciles results itself, and capture feeds the track stage directly.
+//
+// Finished packets go back from encode to capture through a BufferPool, so
+// frame Mats, detection and overlay vectors are reused rather than
+// allocated per frame.
+
+#include "BufferPool.h"
+#include "Metrics.h"
+#include "RecordingWriter.h"
+#include "SpscQueue.h"
+#include "TrackingPipeline.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One frame travelling through the stages
+struct FramePacket {
+    cv::Mat frame;
+    long long index = -1;        // -1 marks end of stream
+    long long capture_tick = 0;
+    bool run_detection = false;
+    Detections detections;
+    std::vector<TrackOverlay> overlay;
+    StageTimings timings;
+};
+
+// Snapshot of one stage's counters. Input stalls count pops that found the
+// upstream queue empty, output stalls pushes that found the downstream full.
+struct StageReport {
+    std::string name;
+    uint64_t frames = 0;
+    double busy_ms = 0.0;
+    uint64_t input_stalls = 0;
+    uint64_t output_stalls = 0;
+    size_t queue_occupancy = 0;   // Frames waiting in this stage's input queue
+    size_t queue_capacity = 0;
+    size_t queue_high_water = 0;
+};
+
+class StagedPipeline
+{
+public:
+    // Called on the encode thread for every finished frame; `overlay` is the
+    // frame's track snapshot (already drawn into `frame` unless record_raw)
+    using FrameCallback = std::function<void(const cv::Mat& frame, const std::vector<TrackOverlay>& overlay, const StageTimings& timings)>;
+    // Called on the encode thread once the last frame drained; `reason` says why
+    using EndCallback = std::function<void(const std::string& reason)>;
+
+    StagedPipeline(TrackingPipeline& pipeline, size_t queue_depth);
+    ~StagedPipeline();
+
+    // `cap` (and `recorder`, if not null) must outlive stop()
+    bool start(cv::VideoCapture* cap, RecordingWriter* recorder, FrameCallback on_frame, EndCallback on_end);
+    void stop(); // Joins all stage threads; safe to call more than once
+    bool isRunning() const { return running; }
+
+    std::vector<StageReport> report() const;
+    const StageTotals& totals() const { return stage_totals; } // Stable after stop()
+    double throughputFps() const { return throughput_fps.load(std::memory_order_relaxed); }
+    // Recycled packets (hits) vs. newly built ones (misses)
+    const BufferPool<FramePacket>& packetPool() const { return packet_pool; }
+
+private:
+    enum Stage { Capture = 0, Detect, Track, Render, Encode, StageCount };
+
+    struct StageCounters {
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> busy_ticks{0};
+    };
+
+    TrackingPipeline& pipeline;
+    cv::VideoCapture* cap = nullptr;
+    RecordingWriter* recorder = nullptr;
+    FrameCallback on_frame;
+    EndCallback on_end;
+
+    // Queue feeding each stage after capture
+    SpscQueue<FramePacket> to_detect;
+    SpscQueue<FramePacket> to_track;
+    SpscQueue<FramePacket> to_render;
+    SpscQueue<FramePacket> to_encode;
+    BufferPool<FramePacket> packet_pool; // encode -> capture
+
+    std::vector<std::thread> threads;
+    std::atomic<bool> stop_flag{false}; // Makes every blocked push/pop give up
+    bool running = false;
+    bool async_detection = false;
+    bool record_raw = false;             // Render stage skips drawing
+    std::string end_reason;
+    StageCounters counters[StageCount];
+    Gauge* queue_gauges[StageCount] = {}; // Exported input-queue occupancy (none for capture)
+    StageTotals stage_totals;
+    std::atomic<double> throughput_fps{0.0};
+
+    void captureLoop();
+    void detectLoop();
+    void trackLoop();
+    void renderLoop();
+    void encodeLoop();
+    void addBusy(Stage stage, long long start_tick);
+};
+
+#endif // STAGEDPIPELINE_H
@@ -0,0 +1,84 @@
+#include "TrackStore.h"
+
+#include <algorithm>
+
+TrackStore::TrackStore(int trajectory_length) : traj_len(std::max(trajectory_length, 1)) {}
+
+void TrackStore::clear() {
+    // Keep the capacity; a restarted source usually reaches the same track count
+    for (int s : live) { tracker[s].release(); state[s] = TrackState::Free; }
+    free_slots.clear();
+    for (int s = (int)state.size() - 1; s >= 0; --s) { free_slots.push_back(s); }
+    live.clear(); active.clear();
+    active_count = lost_count = 0;
+}
+
+int TrackStore::create(int track_id, int cls, const cv::Rect& box) {
+    int slot;
+    if (!free_slots.empty()) { slot = free_slots.back(); free_slots.pop_back(); }
+    else {
+        slot = (int)state.size();
+        bbox.emplace_back(); motion.emplace_back(); velocity.push_back(0.0); frames_since_detected.push_back(0);
+        state.push_back(TrackState::Free); updated.push_back(0); psr.push_back(0.f);
+        id.push_back(-1); class_id.push_back(-1); last_update_tick.push_back(0); alerts.push_back(0); zones.push_back(0); tracker.emplace_back();
+        traj_points.resize(traj_points.size() + traj_len);
+        traj_head.push_back(0); traj_count.push_back(0);
+    }
+    bbox[slot] = box; motion[slot] = MotionModel(); velocity[slot] = 0.0; frames_since_detected[slot] = 0;
+    updated[slot] = 0; psr[slot] = 0.f; id[slot] = track_id; class_id[slot] = cls; last_update_tick[slot] = 0; alerts[slot] = 0; zones[slot] = 0;
+    traj_head[slot] = 0; traj_count[slot] = 0;
+    state[slot] = TrackState::Active; countState(TrackState::Active, +1);
+
+    insertById(live, slot);
+    insertById(active, slot);
+    return slot;
+}
+
+// Track ids only grow, so appending usually keeps the list sorted by id
+void TrackStore::insertById(std::vector<int>& slots, int slot) {
+    const int track_id = id[slot];
+    if (!slots.empty() && id[slots.back()] > track_id) {
+        slots.insert(std::upper_bound(slots.begin(), slots.end(), track_id,
+                                      [this](int tid, int s) { return tid < id[s]; }), slot);
+    } else { slots.push_back(slot); }
+}
+
+void TrackStore::eraseById(std::vector<int>& slots, int slot) {
+    auto it = std::lower_bound(slots.begin(), slots.end(), id[slot], [this](int s, int tid) { return id[s] < tid; });
+    if (it != slots.end() && *it == slot) { slots.erase(it); }
+}
+
+void TrackStore::release(int slot) {
+    if (state[slot] == TrackState::Free) return;
+    countState(state[slot], -1);
+    if (state[slot] == TrackState::Active) { eraseById(active, slot); }
+    state[slot] = TrackState::Free;
+    tracker[slot].release();
+    eraseById(live, slot);
+    free_slots.push_back(slot);
+}
+
+void TrackStore::setState(int slot, TrackState new_state) {
+    if (state[slot] == new_state || state[slot] == TrackState::Free || new_state == TrackState::Free) return;
+    countState(state[slot], -1);
+    if (new_state == TrackState::Active) { insertById(active, slot); }
+    else if (state[slot] == TrackState::Active) { eraseById(active, slot); }
+    state[slot] = new_state;
+    countState(new_state, +1);
+}
+
+int TrackStore::findId(int track_id) const {
+    auto it = std::lower_bound(live.begin(), live.end(), track_id, [this](int s, int tid) { return id[s] < tid; });
+    return (it != live.end() && id[*it] == track_id) ? *it : -1;
+}
+
+void TrackStore::pushTrajectory(int slot, cv::Point p) {
+    traj_points[(size_t)slot * traj_len + traj_head[slot]] = p;
+    traj_head[slot] = (traj_head[slot] + 1) % traj_len;
+    if (traj_count[slot] < traj_len) traj_count[slot]++;
+}
+
+void TrackStore::countState(TrackState s, int delta) {
+    if (s == TrackState::Active) active_count += delta;
+    else if (s == TrackState::Lost) lost_count += delta;
+}
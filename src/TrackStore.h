@@ -0,0 +1,90 @@
+#ifndef TRACKSTORE_H
+#define TRACKSTORE_H
+
+// Flat table of tracks. The per-frame fields are stored struct-of-arrays
+// and indexed by slot. A track keeps its slot from creation until it
+// expires: losing it and re-identifying it only flips `state`, nothing is
+// copied. Active slots are also listed on their own, so per-frame loops
+// never walk the lost ones. Each slot owns a fixed-capacity trajectory ring. Freed slots are
+// recycled, so once the table has grown to the scene's peak track count,
+// per-frame bookkeeping allocates nothing.
+
+#include "MotionModel.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/tracking.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TrackState : uint8_t { Free = 0, Active, Lost };
+
+// TrackStore::alerts bits
+static const uint8_t ALERT_SPEED = 1;
+
+class TrackStore
+{
+public:
+    explicit TrackStore(int trajectory_length = 20);
+
+    void clear();
+
+    // New active track in a free (or new) slot; returns the slot
+    int create(int id, int class_id, const cv::Rect& box);
+    void release(int slot);                      // Track expired; slot becomes free
+    void setState(int slot, TrackState new_state);
+
+    // Live (active + lost) slots in ascending track-id order
+    const std::vector<int>& liveSlots() const { return live; }
+    // Active slots only, same order (per-frame work should not touch lost tracks)
+    const std::vector<int>& activeSlots() const { return active; }
+    int findId(int track_id) const;              // Slot, or -1
+    size_t activeCount() const { return active_count; }
+    size_t lostCount() const { return lost_count; }
+
+    // --- Trajectory ring (index 0 = oldest point) ---
+    void pushTrajectory(int slot, cv::Point p);
+    void clearTrajectory(int slot) { traj_count[slot] = 0; }
+    int trajectorySize(int slot) const { return traj_count[slot]; }
+    cv::Point trajectoryAt(int slot, int i) const {
+        int start = traj_head[slot] - traj_count[slot] + i;
+        if (start < 0) start += traj_len;
+        return traj_points[(size_t)slot * traj_len + start];
+    }
+
+    // --- Hot fields, indexed by slot ---
+    std::vector<cv::Rect> bbox;
+    std::vector<MotionModel> motion;             // Kalman state; predicted every frame while active; advanced from the loss step only when queried for re-ID
+    std::vector<double> velocity;                // Pixels per second, from `motion`
+    std::vector<int> frames_since_detected;      // Updates since a detection last matched the track
+    std::vector<TrackState> state;
+    std::vector<uint8_t> updated;                // Tracker succeeded this frame (byte per slot: written in parallel)
+    std::vector<float> psr;                      // Peak-to-sidelobe ratio of the last appearance update; 0 = not measured
+
+    // --- Cold fields ---
+    std::vector<int> id;
+    std::vector<int> class_id;                   // Index into the pipeline's class names
+    std::vector<long long> last_update_tick;
+    std::vector<uint8_t> alerts;                 // ALERT_* bits raised on the last frame (alerts are edge-triggered)
+    std::vector<uint64_t> zones;                 // ZoneMap zones the track was in on the last frame
+    std::vector<cv::Ptr<cv::Tracker>> tracker;
+
+private:
+    int traj_len;
+    std::vector<cv::Point> traj_points;          // traj_len points per slot
+    std::vector<int> traj_head;                  // Next write position
+    std::vector<int> traj_count;
+
+    std::vector<int> free_slots;
+    std::vector<int> live;
+    std::vector<int> active;
+    size_t active_count = 0;
+    size_t lost_count = 0;
+
+    void countState(TrackState s, int delta);
+    void insertById(std::vector<int>& slots, int slot);
+    void eraseById(std::vector<int>& slots, int slot);
+};
+
+#endif // TRACKSTORE_H
@@ -0,0 +1,62 @@
+#include "TrackerPool.h"
+#include "Log.h"
+
+#include <opencv2/tracking/tracking_legacy.hpp>
+
+#include <algorithm>
+
+// Idle trackers looked at for a patch-size match before taking any
+static const size_t MATCH_SCAN = 32;
+
+// Adapts the legacy MOSSE tracker to the cv::Tracker interface
+namespace {
+class LegacyTrackerWrapper : public cv::Tracker {
+  public:
+    LegacyTrackerWrapper(const cv::Ptr<cv::legacy::Tracker>& lt) : legacy_tracker_(lt) { CV_Assert(lt); }
+    void init(cv::InputArray i, const cv::Rect& b) CV_OVERRIDE {
+         cv::Rect2d bd = b; if (!legacy_tracker_->init(i, bd)) { LOG_WARN("Legacy tracker init() returned false."); } }
+    bool update(cv::InputArray i, cv::Rect& b) CV_OVERRIDE {
+         cv::Rect2d bd = b; bool s = legacy_tracker_->update(i, bd);
+         if (s) { b = cv::Rect(cvRound(bd.x), cvRound(bd.y), cvRound(bd.width), cvRound(bd.height)); } return s; }
+  private:
+    cv::Ptr<cv::legacy::Tracker> legacy_tracker_;
+};
+}
+
+TrackerPool::TrackerPool(TrackerEngine tracker_engine, size_t max_idle_trackers)
+    : engine(tracker_engine), max_idle(max_idle_trackers) {}
+
+cv::Ptr<cv::Tracker> TrackerPool::acquire(const cv::Rect& box) {
+    if (engine == TrackerEngine::MotionOnly) return cv::Ptr<cv::Tracker>();
+    if (engine == TrackerEngine::LegacyMosse) {
+        cv::Ptr<cv::legacy::Tracker> legacy_tracker = cv::legacy::TrackerMOSSE::create();
+        if (!legacy_tracker) return cv::Ptr<cv::Tracker>();
+        created_.fetch_add(1, std::memory_order_relaxed);
+        return cv::makePtr<LegacyTrackerWrapper>(legacy_tracker);
+    }
+    if (free_trackers.empty()) {
+        created_.fetch_add(1, std::memory_order_relaxed);
+        return cv::makePtr<MosseTracker>();
+    }
+    // Most recently released first; take the first whose buffers already fit
+    const cv::Size want = MosseTracker::patchSizeFor(box);
+    size_t pick = free_trackers.size() - 1;
+    for (size_t k = 0; k < std::min(MATCH_SCAN, free_trackers.size()); ++k) {
+        size_t i = free_trackers.size() - 1 - k;
+        if (free_trackers[i]->patchSize() == want) { pick = i; break; }
+    }
+    cv::Ptr<MosseTracker> tracker = std::move(free_trackers[pick]);
+    free_trackers[pick] = std::move(free_trackers.back());
+    free_trackers.pop_back();
+    idle_.store(free_trackers.size(), std::memory_order_relaxed);
+    reused_.fetch_add(1, std::memory_order_relaxed);
+    return tracker;
+}
+
+void TrackerPool::release(cv::Ptr<cv::Tracker>& tracker) {
+    if (tracker && engine == TrackerEngine::SharedMosse && free_trackers.size() < max_idle) {
+        free_trackers.push_back(tracker.staticCast<MosseTracker>());
+        idle_.store(free_trackers.size(), std::memory_order_relaxed);
+    }
+    tracker.release();
+}
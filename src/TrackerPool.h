@@ -0,0 +1,59 @@
+#ifndef TRACKERPOOL_H
+#define TRACKERPOOL_H
+
+// Recycles appearance trackers so track churn does not allocate a fresh
+// filter and FFT buffers for every new or re-identified track. Trackers of
+// expired tracks come back here and are re-initialised in place on the
+// next box; an idle tracker whose patch size already fits the new box is
+// preferred, so its buffers are reused as they are. A re-identified track
+// re-initialises its own tracker and never goes through the pool.
+//
+// Only MosseTracker can be re-initialised: with TrackerEngine::LegacyMosse
+// every acquire() creates a new instance (cv::legacy trackers refuse a
+// second init()) and release() just drops it. TrackerEngine::MotionOnly has
+// no appearance tracker at all: acquire() returns an empty pointer.
+//
+// Used from the tracking thread only; the counters may be read from anywhere.
+
+#include "MosseTracker.h"
+#include "PipelineConfig.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/tracking.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TrackerPool
+{
+public:
+    explicit TrackerPool(TrackerEngine engine = TrackerEngine::SharedMosse, size_t max_idle = 256);
+
+    // A tracker ready for init() on `box` (recycled when possible)
+    cv::Ptr<cv::Tracker> acquire(const cv::Rect& box);
+    // Take back a tracker that is no longer used; `tracker` is left empty
+    void release(cv::Ptr<cv::Tracker>& tracker);
+    // A tracker was re-initialised in place (re-ID or weak-track refresh), counted as a reuse
+    void noteReinit() { reused_.fetch_add(1, std::memory_order_relaxed); }
+    bool canReinit() const { return engine == TrackerEngine::SharedMosse; }
+    bool hasAppearance() const { return engine != TrackerEngine::MotionOnly; }
+    // Every tracker handed out is a MosseTracker, so MosseTracker::psr() can be read
+    bool measuresPsr() const { return engine == TrackerEngine::SharedMosse; }
+
+    // --- Counters ---
+    uint64_t created() const { return created_.load(std::memory_order_relaxed); }
+    uint64_t reused() const { return reused_.load(std::memory_order_relaxed); }
+    size_t idle() const { return idle_.load(std::memory_order_relaxed); }
+
+private:
+    TrackerEngine engine;
+    size_t max_idle;
+    std::vector<cv::Ptr<MosseTracker>> free_trackers;
+    std::atomic<uint64_t> created_{0};
+    std::atomic<uint64_t> reused_{0};
+    std::atomic<size_t> idle_{0};
+};
+
+#endif // TRACKERPOOL_H
@@ -0,0 +1,650 @@
+#include "TrackingPipeline.h"
+#include "AsyncDetector.h"
+#include "BatchedDetector.h"
+#include "BufferPool.h"
+#include "DetectionTrace.h"
+#include "Log.h"
+#include "RecordingWriter.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+
+void StageTotals::add(const StageTimings& t, bool detected) {
+    frames++;
+    if (detected) { detection_runs++; detection_ms += t.detection_ms; }
+    capture_ms += t.capture_ms;
+    tracker_update_ms += t.tracker_update_ms;
+    drawing_ms += t.drawing_ms;
+    total_ms += t.total_ms;
+}
+
+// Velocity variance of a new track's motion model (pixels^2 / frame^2)
+static const float INITIAL_VELOCITY_VAR = 100.f;
+
+// Index of the lowest set bit of a non-zero mask
+static int lowestBit(uint64_t mask) {
+    int i = 0;
+    while (!(mask & 1)) { mask >>= 1; ++i; }
+    return i;
+}
+
+static double ticksToMs(long long ticks) {
+    return ((double)ticks / cv::getTickFrequency()) * 1000;
+}
+
+// Formats into a per-thread buffer so per-frame overlay labels do not
+// allocate once the buffer has grown. Valid until the next call.
+static const std::string& formatLabel(const char* fmt, ...) {
+    thread_local std::string buffer;
+    char text[128];
+    va_list args;
+    va_start(args, fmt);
+    std::vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    buffer.assign(text);
+    return buffer;
+}
+
+TrackingPipeline::ExportedMetrics::ExportedMetrics(const std::string& stream)
+    : frames(MetricsRegistry::global().counter("objtrack_frames_total", "Frames processed.", metricLabels({{"stream", stream}}))),
+      detections(MetricsRegistry::global().counter("objtrack_detection_runs_total", "Network runs that completed.", metricLabels({{"stream", stream}}))),
+      objects(MetricsRegistry::global().counter("objtrack_detected_objects_total", "Detections after NMS and class filtering.", metricLabels({{"stream", stream}}))),
+      tracks_created(MetricsRegistry::global().counter("objtrack_tracks_created_total", "New tracks.", metricLabels({{"stream", stream}}))),
+      tracks_reidentified(MetricsRegistry::global().counter("objtrack_tracks_reidentified_total", "Lost tracks matched to a detection again.", metricLabels({{"stream", stream}}))),
+      tracks_lost(MetricsRegistry::global().counter("objtrack_tracks_lost_total", "Active tracks moved to lost (tracker failure, or a missed detection run with no appearance tracker).", metricLabels({{"stream", stream}}))),
+      tracks_expired(MetricsRegistry::global().counter("objtrack_tracks_expired_total", "Lost tracks deleted after max_lost_frames.", metricLabels({{"stream", stream}}))),
+      tracker_errors(MetricsRegistry::global().counter("objtrack_tracker_errors_total", "Exceptions from tracker init/update.", metricLabels({{"stream", stream}}))),
+      active_tracks(MetricsRegistry::global().gauge("objtrack_tracks", "Live tracks by state.", metricLabels({{"stream", stream}, {"state", "active"}}))),
+      lost_tracks(MetricsRegistry::global().gauge("objtrack_tracks", "Live tracks by state.", metricLabels({{"stream", stream}, {"state", "lost"}})))
+{
+}
+
+// Constructor
+TrackingPipeline::TrackingPipeline(const PipelineConfig& config) : cfg(config), metrics(config.metrics_stream), track_store(config.trajectory_length), tracker_pool(config.tracker_engine), detect_scheduler(config), roi_planner(config)
+{
+    lost_index.configure(cfg.max_lost_frames, cfg.detect_interval);
+    tracker_scale = std::max(0.1, std::min(1.0, cfg.processing_scale));
+    tracker_frame.configure(tracker_scale, cfg.tracker_engine == TrackerEngine::SharedMosse);
+    if (cfg.async_detection) {
+        async_detector = std::make_unique<AsyncDetector>(
+            [this](const cv::Mat& input_blob, const std::vector<cv::Rect>& regions, Detections& out, double& detection_ms) {
+                return forwardAndDecode(input_blob, regions, out, detection_ms);
+            });
+    }
+}
+
+// Destructor (joins the detector thread before the network goes away)
+TrackingPipeline::~TrackingPipeline()
+{
+    async_detector.reset();
+}
+
+void TrackingPipeline::reportStatus(const std::string& status) const {
+    if (status_cb) { status_cb(status); }
+    else { std::cerr << status << std::endl; }
+}
+
+// Load class names (enough for association/tracking without the network)
+bool TrackingPipeline::loadClassNames() {
+     class_names.clear();
+     names_path = cfg.data_path + "coco.names";
+     LOG_DEBUG("Using class names path: " << names_path);
+     std::ifstream ifs(names_path);
+     if (!ifs.is_open()) {
+         reportStatus("Error: Could not load class names file: " + names_path);
+         return false;
+     }
+     std::string line;
+     while (std::getline(ifs, line)) { class_names.push_back(line); }
+     ifs.close(); // Close the file
+     LOG_DEBUG("Loaded " << class_names.size() << " class names.");
+     if (class_names.empty()) {
+         reportStatus("Error: Class names file is empty: " + names_path);
+         return false;
+     }
+     yolo_decoder.configure(class_names, cfg.desired_classes, cfg.confidence_threshold, cfg.nms_threshold);
+     return loadZones();
+}
+
+bool TrackingPipeline::loadZones() {
+     if (cfg.zones_file.empty()) return true;
+     std::string error;
+     if (!zone_map.load(cfg.zones_file, error)) {
+         reportStatus("Error: Could not load zones: " + error);
+         return false;
+     }
+     LOG_DEBUG("Loaded " << zone_map.zones().size() << " zones from " << cfg.zones_file);
+     return true;
+}
+
+const std::string& TrackingPipeline::className(int class_id) const {
+    static const std::string unknown = "?";
+    return (class_id >= 0 && class_id < (int)class_names.size()) ? class_names[class_id] : unknown;
+}
+
+// Load Network
+bool TrackingPipeline::loadNetwork() {
+     _modelLoaded = false;
+     if (!loadClassNames()) { return false; }
+
+     std::string model_weights = cfg.data_path + "yolov4-tiny.weights";
+     std::string model_config = cfg.data_path + "yolov4-tiny.cfg";
+     LOG_DEBUG("Loading network from: " << model_config << " and " << model_weights);
+     try {
+         net = cv::dnn::readNetFromDarknet(model_config, model_weights);
+         if (net.empty()) {
+             reportStatus("Error: Can't load network using provided files.");
+             return false;
+         }
+         net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+         net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+         output_layer_names = net.getUnconnectedOutLayersNames();
+         LOG_DEBUG("Network loaded successfully.");
+         _modelLoaded = true;
+         return true; // Success
+     } catch (const cv::Exception& ex) {
+         reportStatus(std::string("Error: OpenCV exception loading network: ") + ex.what());
+         return false;
+     }
+}
+
+void TrackingPipeline::reset() {
+    for (int s : track_store.liveSlots()) { tracker_pool.release(track_store.tracker[s]); }
+    track_store.clear(); lost_index.clear(); tracker_frame.clear(); next_track_id = 0; frame_count = 0;
+    current_fps = 0.0; timings = StageTimings(); stage_totals = StageTotals();
+    detect_scheduler.reset(); failed_updates = 0;
+    last_track_tick = 0; frame_interval_sec = 0.0; track_step = 0;
+    region_runs = 0; region_count = 0; region_source_px = 0; region_network_px = 0; region_frame_px = 0;
+    if (async_detector) { async_detector->discard(); }
+}
+
+// One full processing step for a frame already read by the caller
+void TrackingPipeline::processFrame(cv::Mat& frame, long long loop_start_tick) {
+    if (loop_start_tick == 0) { loop_start_tick = cv::getTickCount(); }
+    detected_this_frame = false;
+
+    updateTracks(frame);
+    if (async_detector) {
+        detected_this_frame = stepAsyncDetection(frame, frame_count, timings.detection_ms);
+    } else if (shouldDetect(frame, frame_count)) {
+        detect(frame, frame_detections, timings.detection_ms);
+        recordTrace(frame_count, frame_detections);
+        // Associate tracks (pass frame needed for tracker init)
+        associateAndTrack(frame, frame_detections.boxes, frame_detections.classIds);
+        detected_this_frame = true;
+    }
+    collectOverlay(frame_overlay);
+    if (recorder) { recorder->fillTimings(timings); }
+    if (!cfg.record_raw) { drawOverlay(frame, frame_overlay, frame_count, timings, current_fps); }
+    else { timings.drawing_ms = 0.0; } // Drawn at display time from lastOverlay()
+
+    timings.total_ms = ((double)(cv::getTickCount() - loop_start_tick) / cv::getTickFrequency()) * 1000;
+    if (timings.total_ms > 1e-3) { current_fps = 1000.0 / timings.total_ms; }
+    stage_totals.add(timings, detected_this_frame);
+    frame_count++;
+}
+
+void TrackingPipeline::setCaptureTime(double ms) {
+    timings.capture_ms = ms;
+    stageLatency(PipelineStage::Capture).observe(ms);
+}
+
+// --- Reset, Update Trackers, Manage Lost Tracks ---
+// Tracker updates are independent per track, so they run in parallel over
+// the active slots taken in id order. Each worker only writes its own
+// slot; velocity/trajectory bookkeeping and lost-track transitions are then
+// applied serially in the same id order, so results do not depend on
+// thread count or scheduling.
+// Every active track's motion model is predicted first (a lost track's is
+// only advanced when a re-ID query needs it). With
+// appearance_interval k > 1 each active track runs its appearance tracker
+// on one frame in k (staggered by slot, so every frame carries about 1/k of
+// the work) and takes the predicted box on the others.
+// With processing_scale < 1 the trackers see the frame shrunk once per
+// frame (TrackerFrame); their boxes are mapped in and out of that image so
+// everything downstream keeps native coordinates.
+void TrackingPipeline::updateTracks(const cv::Mat& frame) {
+    TrackStore& ts = track_store;
+    long long tracker_update_start_tick = cv::getTickCount();
+    long long current_tick = cv::getTickCount();
+    if (last_track_tick > 0) { // Smoothed wall-clock frame interval, for pixels/second
+        double dt = (double)(current_tick - last_track_tick) / cv::getTickFrequency();
+        frame_interval_sec = frame_interval_sec > 0 ? 0.9 * frame_interval_sec + 0.1 * dt : dt;
+    }
+    last_track_tick = current_tick;
+    const int k = std::max(1, cfg.appearance_interval);
+    const float q = (float)cfg.kalman_process_noise;
+    const float tracker_var = (float)(cfg.kalman_tracker_noise * cfg.kalman_tracker_noise);
+
+    const long long now = ++track_step;
+    event_frame = now - 1; // Frames since reset(), as processFrame() and StagedPipeline number them
+    event_time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    frame_size = frame.size();
+    lost_index.setFrameSize(frame.size());
+    metrics.frames.add();
+
+    const cv::Mat& input = trackerInput(frame, true);
+    const bool has_appearance = tracker_pool.hasAppearance(), has_psr = tracker_pool.measuresPsr();
+    update_slots.clear();
+    for (int s : ts.activeSlots()) {
+        ts.updated[s] = 0;
+        MotionModel& m = ts.motion[s];
+        m.predict(q);
+        const bool moving = m.corrections >= 2; // Has a velocity estimate
+        const bool appearance = has_appearance && (k == 1 || !moving || (now + s) % k == 0);
+        if (moving) { ts.bbox[s] = m.box(ts.bbox[s].size()); } // Search starts at the prediction
+        update_slots.push_back({s, false, false, appearance});
+    }
+
+    auto updateRange = [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            TrackUpdateSlot& slot = update_slots[i];
+            if (!slot.appearance) { slot.success = true; continue; } // Predicted box stands
+            if (!ts.tracker[slot.slot]) continue;
+            try {
+                slot.success = updateTracker(*ts.tracker[slot.slot], input, ts.bbox[slot.slot]);
+                if (has_psr) { ts.psr[slot.slot] = (float)static_cast<const MosseTracker&>(*ts.tracker[slot.slot]).psr(); }
+            } catch (const cv::Exception&) {
+                slot.success = false; // Treat exception as tracking failure
+                slot.threw = true;
+            }
+        }
+    };
+    const int n = (int)update_slots.size();
+    if (cfg.parallel_track_update && n >= cfg.parallel_min_tracks) { cv::parallel_for_(cv::Range(0, n), updateRange); }
+    else { updateRange(cv::Range(0, n)); }
+
+    failed_updates = 0;
+    for (const TrackUpdateSlot& slot : update_slots) {
+        const int s = slot.slot; const int id = ts.id[s];
+        ts.frames_since_detected[s]++;
+        if (slot.threw) { metrics.tracker_errors.add(); LOG_WARN("OpenCV Exception during tracker->update() for ID " << id); }
+        if (slot.success) {
+            ts.updated[s] = 1;
+            MotionModel& m = ts.motion[s];
+            cv::Point current_center = getCenter(ts.bbox[s]);
+            if (slot.appearance) { m.correct(cv::Point2f(current_center), tracker_var); }
+            ts.pushTrajectory(s, current_center);
+            ts.velocity[s] = (m.corrections >= 2 && frame_interval_sec > 1e-3) ? cv::norm(m.vel) / frame_interval_sec : 0.0;
+            ts.last_update_tick[s] = current_tick;
+        } else {
+            markLost(s, now); failed_updates++;
+        }
+    }
+    timings.tracker_update_ms = ticksToMs(cv::getTickCount() - tracker_update_start_tick);
+    stageLatency(PipelineStage::Track).observe(timings.tracker_update_ms);
+
+    lost_index.expire(now, expired_slots);
+    for (int s : expired_slots) { LOG_DEBUG("Permanently deleted Lost Track ID " << ts.id[s]); emitEvent(EventType::TrackExpired, s); tracker_pool.release(ts.tracker[s]); ts.release(s); }
+    metrics.tracks_expired.add(expired_slots.size());
+    metrics.active_tracks.set((double)ts.activeCount()); metrics.lost_tracks.set((double)ts.lostCount());
+    detect_scheduler.observeTracks(ts, frame.size(), failed_updates, lost_index.recentlyLost());
+}
+
+bool TrackingPipeline::shouldDetect(const cv::Mat& frame, long long frame_index) {
+    return detect_scheduler.decide(frame, frame_index);
+}
+
+// --- Detection (network + decode only, no tracking state) ---
+bool TrackingPipeline::detect(const cv::Mat& frame, Detections& out, double& detection_ms) {
+    out.clear();
+    const std::vector<cv::Rect>& regions = planRegions(frame.size());
+    if (!prepareBlob(frame, regions, blob)) { detection_ms = 0; return false; }
+    return forwardAndDecode(blob, regions, out, detection_ms);
+}
+
+const std::vector<cv::Rect>& TrackingPipeline::planRegions(cv::Size frame) {
+    const std::vector<cv::Rect>& regions = roi_planner.plan(frame, detect_scheduler.motionMask(), detect_scheduler.trackBoxes());
+    uint64_t source_px = 0;
+    for (const cv::Rect& r : regions) { source_px += (uint64_t)r.area(); }
+    region_runs.fetch_add(1, std::memory_order_relaxed);
+    region_count.fetch_add(regions.size(), std::memory_order_relaxed);
+    region_source_px.fetch_add(source_px, std::memory_order_relaxed);
+    region_network_px.fetch_add((uint64_t)regions.size() * cfg.input_width * cfg.input_height, std::memory_order_relaxed);
+    region_frame_px.fetch_add((uint64_t)frame.area(), std::memory_order_relaxed);
+    return regions;
+}
+
+RegionStats TrackingPipeline::regionStats() const {
+    RegionStats s;
+    s.runs = region_runs.load(std::memory_order_relaxed); s.regions = region_count.load(std::memory_order_relaxed);
+    s.source_px = region_source_px.load(std::memory_order_relaxed); s.network_px = region_network_px.load(std::memory_order_relaxed);
+    s.frame_px = region_frame_px.load(std::memory_order_relaxed);
+    return s;
+}
+
+// One image per region, each squashed to the network input size
+bool TrackingPipeline::prepareBlob(const cv::Mat& frame, const std::vector<cv::Rect>& regions, cv::Mat& blob_out) {
+    long long start_tick = cv::getTickCount();
+    try {
+        const cv::Size input_size(cfg.input_width, cfg.input_height);
+        if (regions.size() == 1 && regions[0].size() == frame.size()) {
+            cv::dnn::blobFromImage(frame, blob_out, 1./255., input_size, cv::Scalar(), true, false);
+        } else {
+            region_crops.resize(regions.size());
+            for (size_t i = 0; i < regions.size(); ++i) { region_crops[i] = frame(regions[i]); } // Views, no copy
+            cv::dnn::blobFromImages(region_crops, blob_out, 1./255., input_size, cv::Scalar(), true, false);
+            for (cv::Mat& crop : region_crops) { crop.release(); } // Don't pin the frame's pixels
+        }
+        stageLatency(PipelineStage::Preprocess).observe(ticksToMs(cv::getTickCount() - start_tick));
+        return true;
+    } catch (const cv::Exception& ex) {
+        std::cerr << "OpenCV Exception during blobFromImage: " << ex.what() << std::endl;
+        return false;
+    }
+}
+
+bool TrackingPipeline::forwardAndDecode(const cv::Mat& input_blob, const std::vector<cv::Rect>& regions, Detections& out, double& detection_ms) {
+    out.clear();
+    long long detection_start_tick = cv::getTickCount();
+    try { // Add try-catch around DNN operations
+         bool forwarded = true;
+         if (shared_detector) { forwarded = shared_detector->infer(input_blob, dnn_outs); } // Waits for its batch
+         else { net.setInput(input_blob); net.forward(dnn_outs, output_layer_names); } // Output headers reused across runs
+         detection_ms = ticksToMs(cv::getTickCount() - detection_start_tick);
+         if (!forwarded) { reportStatus("Error: Detection failed."); detection_ms = 0; return false; }
+         stageLatency(PipelineStage::Forward).observe(detection_ms);
+         long long decode_start_tick = cv::getTickCount();
+         yolo_decoder.decode(dnn_outs, regions, out);
+         stageLatency(PipelineStage::Decode).observe(ticksToMs(cv::getTickCount() - decode_start_tick));
+    } catch (const cv::Exception& ex) {
+         std::cerr << "OpenCV Exception during detection/DNN processing: " << ex.what() << std::endl;
+         reportStatus("Error: Detection failed.");
+         detection_ms = 0; out.clear();
+         return false;
+    }
+    metrics.detections.add(); metrics.objects.add(out.boxes.size());
+    LOG_DEBUG("YOLO Detection took: " << detection_ms << " ms. Relevant Detections: " << out.boxes.size());
+    return true;
+}
+
+// --- Asynchronous Detection ---
+bool TrackingPipeline::stepAsyncDetection(const cv::Mat& frame, long long frame_index, double& detection_ms) {
+    bool associated = false;
+
+    // 1. Reconcile a finished snapshot against the tracks as they are now
+    DetectionResult result;
+    if (async_detector->poll(result)) {
+        if (result.ok) {
+            recordTrace(result.frame_index, result.detections); // As detected, before motion compensation
+            std::vector<cv::Rect> boxes = result.detections.boxes;
+            compensateMotion(result, boxes);
+            associateAndTrack(frame, boxes, result.detections.classIds);
+            detection_ms = result.detection_ms;
+            associated = true;
+        }
+    }
+
+    // 2. Submit this frame if the worker is free and the scheduler wants a
+    // detection (asked only when free, so its counters are submittable frames)
+    if (async_detector->idle() && shouldDetect(frame, frame_index)) {
+        // Reuse the snapshot buffer once the worker has let go of the last one
+        if (!soleOwner(snapshot_blob)) { snapshot_blob.release(); }
+        const std::vector<cv::Rect>& regions = planRegions(frame.size());
+        if (prepareBlob(frame, regions, snapshot_blob)) {
+            std::vector<std::pair<int, cv::Rect>> track_boxes;
+            track_boxes.reserve(track_store.activeCount());
+            for (int s : track_store.activeSlots()) { track_boxes.emplace_back(track_store.id[s], track_store.bbox[s]); }
+            async_detector->submit(snapshot_blob, regions, frame_index, std::move(track_boxes));
+        }
+    }
+    return associated;
+}
+
+void TrackingPipeline::recordTrace(long long frame_index, const Detections& detections) {
+    if (trace_writer) { trace_writer->write(frame_index, detections); }
+}
+
+// Shift each detection by the motion of the track it overlapped at snapshot
+// time, so boxes from a frame or two ago line up with the current frame.
+// Detections that matched no track (new objects) are left where they were.
+void TrackingPipeline::compensateMotion(const DetectionResult& result, std::vector<cv::Rect>& boxes) const {
+    for (cv::Rect& box : boxes) {
+        int best_id = -1; double best_iou = cfg.min_iou_threshold; cv::Rect best_then;
+        for (auto const& [id, then_box] : result.track_boxes) {
+            double iou = calculateIoU(then_box, box);
+            if (iou > best_iou) { best_iou = iou; best_id = id; best_then = then_box; }
+        }
+        if (best_id == -1) continue;
+        int s = track_store.findId(best_id);
+        if (s < 0 || track_store.state[s] != TrackState::Active || !track_store.updated[s]) continue;
+        cv::Point shift = getCenter(track_store.bbox[s]) - getCenter(best_then);
+        box.x += shift.x; box.y += shift.y;
+    }
+}
+
+// Copy what the overlay needs out of the live tracks. Existing elements
+// of `out` are overwritten in place so their trajectory buffers are reused.
+// Alerts are edge-triggered: an event (and a log line) when a track enters
+// or leaves a zone or goes over the speed threshold, not one per frame it
+// stays there. Zone membership is one ZoneMap lookup per track; only the
+// zones whose bit changed are visited.
+void TrackingPipeline::collectOverlay(std::vector<TrackOverlay>& out) {
+    TrackStore& ts = track_store;
+    const bool check_zone = _drawRestrictedZone, check_speed = _checkSpeedAlert;
+    if (check_zone) { zone_map.prepare(frame_size, class_names); } // Rasterises on the first frame of a size only
+    const uint64_t alert_zones = check_zone ? zone_map.alertMask() : 0;
+    size_t n = 0;
+    for (int s : ts.activeSlots()) {
+        if (!ts.updated[s]) continue;
+        const uint64_t zones = check_zone ? zone_map.lookup(ts.bbox[s], ts.class_id[s]) : 0;
+        const bool over_speed = check_speed && ts.velocity[s] > cfg.speed_threshold_pixels_per_sec;
+        for (uint64_t changed = zones ^ ts.zones[s]; changed; changed &= changed - 1) {
+            const int z = lowestBit(changed);
+            const bool entered = (zones >> z) & 1;
+            emitEvent(entered ? EventType::ZoneEnter : EventType::ZoneExit, s, z);
+            if (entered && zone_map.zones()[z].alert) { LOG_INFO("ALERT: ID " << ts.id[s] << " (" << className(ts.class_id[s]) << ") entered zone '" << zone_map.zones()[z].name << "'!"); }
+        }
+        if (over_speed && !(ts.alerts[s] & ALERT_SPEED)) {
+            emitEvent(EventType::SpeedAlert, s);
+            LOG_INFO("** SPEED ALERT: ID " << ts.id[s] << " (" << className(ts.class_id[s]) << ") V=" << ts.velocity[s] << " px/s **");
+        }
+        ts.zones[s] = zones;
+        ts.alerts[s] = over_speed ? ALERT_SPEED : 0;
+        const bool in_zone = zones != 0;
+
+        if (n == out.size()) { out.emplace_back(); }
+        TrackOverlay& item = out[n++];
+        item.id = ts.id[s]; item.boundingBox = ts.bbox[s]; item.classId = ts.class_id[s]; item.velocity = ts.velocity[s];
+        item.in_zone = in_zone; item.zone_alert = (zones & alert_zones) != 0; item.over_speed = over_speed;
+        item.trajectory.resize(ts.trajectorySize(s));
+        for (int i = 0; i < ts.trajectorySize(s); ++i) { item.trajectory[i] = ts.trajectoryAt(s, i); }
+    }
+    out.resize(n);
+}
+
+// --- Draw Results & Check Alerts ---
+void TrackingPipeline::drawOverlay(cv::Mat& frame, const std::vector<TrackOverlay>& tracks, long long frame_index,
+                                   StageTimings& t, double fps) const {
+    long long drawing_start_tick = cv::getTickCount();
+    bool alert_active_this_frame = false;
+    const bool draw_zone = _drawRestrictedZone, draw_trajectory = _drawTrajectory, check_speed = _checkSpeedAlert;
+
+    for (const TrackOverlay& tobj : tracks) {
+        const int id = tobj.id;
+        const std::string& class_name = className(tobj.classId);
+        cv::Scalar box_color = cv::Scalar(0, 255, 0); // Default Green
+        std::string alert_text = ""; // Text to add near label
+
+        // Restricted Zone Alert (decided by collectOverlay); events-only zones just tint the box
+        if (draw_zone && tobj.zone_alert) {
+            alert_active_this_frame = true; box_color = cv::Scalar(0, 0, 255); // Red
+            alert_text += "[ZONE]";
+        } else if (draw_zone && tobj.in_zone) {
+            box_color = cv::Scalar(200, 200, 200); // Grey
+        }
+
+        // Speed Alert (decided by collectOverlay)
+        if (check_speed && tobj.over_speed) {
+            alert_active_this_frame = true;
+            if (!(draw_zone && tobj.zone_alert)) { box_color = cv::Scalar(0, 165, 255); } // Orange if not already red
+            alert_text += "[SPEED]";
+        }
+
+        // Draw box, label, velocity
+        cv::rectangle(frame, tobj.boundingBox, box_color, 2);
+        cv::Point label_origin = cv::Point(tobj.boundingBox.x, tobj.boundingBox.y - 5);
+        cv::Point vel_origin = cv::Point(tobj.boundingBox.x, tobj.boundingBox.y + tobj.boundingBox.height + 15);
+        cv::putText(frame, formatLabel("%s ID:%d %s", class_name.c_str(), id, alert_text.c_str()), label_origin, cv::FONT_HERSHEY_SIMPLEX, 0.5, box_color, 1);
+        cv::putText(frame, formatLabel("V:%.1f px/s", tobj.velocity), vel_origin, cv::FONT_HERSHEY_SIMPLEX, 0.4, box_color, 1);
+
+        // Draw Trajectory (Conditional)
+        if (draw_trajectory && tobj.trajectory.size() > 1) {
+             for(size_t i = 1; i < tobj.trajectory.size(); ++i) {
+                 cv::line(frame, tobj.trajectory[i-1], tobj.trajectory[i], cv::Scalar(0, 255, 255), 2); // Yellow trail
+             }
+        }
+    }
+
+    // Draw Zones (Conditional); the polygon buffer is per thread so drawing allocates nothing once grown
+    if (draw_zone) {
+        thread_local std::vector<cv::Point> polygon;
+        for (const Zone& zone : zone_map.zones()) {
+            ZoneMap::scaled(zone, frame.size(), polygon);
+            const cv::Scalar zone_color = zone.alert ? cv::Scalar(0, 0, 255) : cv::Scalar(200, 200, 200); // Red, or grey for events only
+            cv::polylines(frame, polygon, true, zone_color, 2);
+            cv::putText(frame, zone.name, polygon[0] + cv::Point(5, 15), cv::FONT_HERSHEY_SIMPLEX, 0.5, zone_color, 1);
+        }
+    }
+
+    // Draw Timings
+    t.drawing_ms = ticksToMs(cv::getTickCount() - drawing_start_tick);
+    stageLatency(PipelineStage::Draw).observe(t.drawing_ms);
+    cv::putText(frame, formatLabel("Detect: %.1f ms", t.detection_ms), cv::Point(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255), 1);
+    cv::putText(frame, formatLabel("TrackUpd: %.1f ms", t.tracker_update_ms), cv::Point(10, 40), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255), 1);
+    cv::putText(frame, formatLabel("Draw: %.1f ms", t.drawing_ms), cv::Point(10, 60), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255), 1);
+    if (t.record_queue_capacity > 0) { cv::putText(frame, formatLabel("Rec: %.0f fps q %d/%d", t.record_fps, t.record_queue, t.record_queue_capacity), cv::Point(10, 80), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255), 1); }
+    cv::putText(frame, formatLabel("FPS: %.1f", fps), cv::Point(frame.cols - 100, 20), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255), 2);
+    if (alert_active_this_frame && (draw_zone || check_speed)) { cv::Point alert_origin(frame.cols / 2 - 60, frame.rows - 20); cv::putText(frame, "ALERT!", alert_origin, cv::FONT_HERSHEY_TRIPLEX, 1.0, cv::Scalar(0, 0, 255), 2); }
+}
+
+
+// --- Helper Function Implementations ---
+
+// Objectness early-out, desired-class argmax and class-aware NMS (see YoloDecoder)
+void TrackingPipeline::processYoloOutput(const std::vector<cv::Mat>& outs, cv::Size imgSize, Detections& out)
+{
+    yolo_decoder.decode(outs, imgSize, out);
+}
+
+
+void TrackingPipeline::associateAndTrack(const cv::Mat& frame, // Pass frame for tracker init
+                                         const std::vector<cv::Rect>& detected_boxes,
+                                         const std::vector<int>& detected_classIds)
+{
+    // --- NOTE: This function assumes detected_boxes and detected_classIds are the FINAL lists after NMS and class filtering ---
+    TrackStore& ts = track_store;
+    long long associate_start_tick = cv::getTickCount();
+    detection_matched.assign(detected_boxes.size(), 0);
+    const cv::Mat& input = trackerInput(frame, false); // Normally the grayscale updateTracks() made
+
+    // Match detections to ACTIVE tracks (optimal assignment over grid-pruned pairs)
+    const MotionGate* gate = cfg.association_gate > 0 ? &motion_gate : nullptr;
+    assoc_boxes.clear(); assoc_slots.clear(); motion_gate.clear(); motion_gate.max_d2 = cfg.association_gate;
+    for (int s : ts.activeSlots()) { if (!ts.updated[s]) continue; assoc_boxes.push_back(ts.bbox[s]); assoc_slots.push_back(s); addGate(ts.motion[s], ts.bbox[s]); }
+    associator.match(assoc_boxes, detected_boxes, cfg.min_iou_threshold, det_to_track, gate);
+    for (size_t i = 0; i < detected_boxes.size(); ++i) { if (det_to_track[i] != -1) { int s = assoc_slots[det_to_track[i]]; detection_matched[i] = 1; ts.frames_since_detected[s] = 0; ts.motion[s].correct(boxCentre(detected_boxes[i]), detectionVariance(detected_boxes[i]));
+         // A weak filter that still follows its target would keep the scheduler's WeakTracks signal up; retrain it on the detection
+         if (ts.psr[s] > 0.f && ts.psr[s] < cfg.detect_min_psr && tracker_pool.canReinit() && ts.tracker[s]) {
+             try { ts.tracker[s]->init(input, toTrackerBox(detected_boxes[i])); tracker_pool.noteReinit(); ts.bbox[s] = detected_boxes[i]; ts.psr[s] = 0.f; }
+             catch (const cv::Exception& ex) { metrics.tracker_errors.add(); LOG_WARN("Exception during tracker refresh for ID " << ts.id[s] << ": " << ex.what()); }
+         } } }
+    // Without an appearance tracker nothing else ever loses a track: a detection run that missed it does
+    if (!tracker_pool.hasAppearance()) { for (int s : assoc_slots) { if (ts.frames_since_detected[s] > 0) { markLost(s, track_step); } } }
+
+    // Match remaining detections to LOST tracks (Re-ID), same solver. Only lost tracks the
+    // index puts near a detection are considered, at their predicted positions
+    assoc_boxes.clear(); assoc_slots.clear(); motion_gate.clear(); unmatched_dets.clear(); unmatched_boxes.clear(); reid_motion.clear();
+    for (size_t i = 0; i < detected_boxes.size(); ++i) { if (!detection_matched[i]) { unmatched_dets.push_back((int)i); unmatched_boxes.push_back(detected_boxes[i]); } }
+    lost_index.query(unmatched_boxes, lost_candidates);
+    std::sort(lost_candidates.begin(), lost_candidates.end(), [&ts](int a, int b) { return ts.id[a] < ts.id[b]; }); // Fixed order for the solver
+    for (int s : lost_candidates) { reid_motion.push_back(predictLost(s)); cv::Rect predicted = reid_motion.back().box(ts.bbox[s].size()); assoc_boxes.push_back(predicted); assoc_slots.push_back(s); addGate(reid_motion.back(), predicted); }
+    associator.match(assoc_boxes, unmatched_boxes, cfg.reid_iou_threshold, det_to_track, gate);
+    for (size_t k = 0; k < unmatched_dets.size(); ++k) { if (det_to_track[k] == -1) continue; size_t i = unmatched_dets[k]; int s = assoc_slots[det_to_track[k]]; int best_lost_match_id = ts.id[s];
+         const bool in_place = tracker_pool.canReinit() && ts.tracker[s]; // Reuse the track's own tracker
+         cv::Ptr<cv::Tracker> tracker = in_place ? ts.tracker[s] : tracker_pool.acquire(toTrackerBox(detected_boxes[i]));
+         if (tracker || !tracker_pool.hasAppearance()) { try { if (tracker) { tracker->init(input, toTrackerBox(detected_boxes[i])); } if (in_place) { tracker_pool.noteReinit(); } else { tracker_pool.release(ts.tracker[s]); ts.tracker[s] = tracker; } ts.bbox[s] = detected_boxes[i]; lost_index.remove(s, track_step); ts.motion[s] = reid_motion[det_to_track[k]]; ts.motion[s].correct(boxCentre(detected_boxes[i]), detectionVariance(detected_boxes[i])); ts.updated[s] = 1; ts.psr[s] = 0.f; ts.frames_since_detected[s] = 0; ts.clearTrajectory(s); ts.pushTrajectory(s, getCenter(detected_boxes[i])); ts.last_update_tick[s] = cv::getTickCount(); ts.velocity[s] = 0; ts.setState(s, TrackState::Active); detection_matched[i] = 1; metrics.tracks_reidentified.add(); emitEvent(EventType::TrackReidentified, s); LOG_DEBUG("Re-identified detection " << i << " as Track ID " << best_lost_match_id); }
+              catch (const cv::Exception& ex) { if (!in_place) { tracker_pool.release(tracker); } metrics.tracker_errors.add(); LOG_WARN("Exception during tracker re-init for ID " << best_lost_match_id << ": " << ex.what()); }
+         } else { LOG_WARN("Failed to create MOSSE tracker instance for Re-ID " << best_lost_match_id); } }
+
+    // Create NEW tracks for remaining unmatched detections
+    for (size_t i = 0; i < detected_boxes.size(); ++i) { if (detection_matched[i]) continue;
+          cv::Ptr<cv::Tracker> tracker = tracker_pool.acquire(toTrackerBox(detected_boxes[i]));
+          if (tracker || !tracker_pool.hasAppearance()) { try { if (tracker) { tracker->init(input, toTrackerBox(detected_boxes[i])); } int s = ts.create(next_track_id++, detected_classIds[i], detected_boxes[i]); ts.tracker[s] = tracker; ts.motion[s].init(boxCentre(detected_boxes[i]), detectionVariance(detected_boxes[i]), INITIAL_VELOCITY_VAR); ts.updated[s] = 1; ts.pushTrajectory(s, getCenter(detected_boxes[i])); ts.last_update_tick[s] = cv::getTickCount(); metrics.tracks_created.add(); emitEvent(EventType::TrackBorn, s); LOG_DEBUG("Initialized new Track ID " << ts.id[s] << " (" << className(ts.class_id[s]) << ")"); }
+               catch (const cv::Exception& ex) { tracker_pool.release(tracker); metrics.tracker_errors.add(); LOG_WARN("Exception during tracker init for new track: " << ex.what()); }
+          } else { LOG_WARN("Failed to create MOSSE tracker instance for new detection."); } }
+    tracker_frame.invalidate();
+    metrics.active_tracks.set((double)ts.activeCount()); metrics.lost_tracks.set((double)ts.lostCount());
+    stageLatency(PipelineStage::Associate).observe(ticksToMs(cv::getTickCount() - associate_start_tick));
+    detect_scheduler.observeTracks(ts, frame.size(), failed_updates, lost_index.recentlyLost());
+}
+
+float TrackingPipeline::detectionVariance(const cv::Rect& box) const {
+    float sd = std::max(1.f, (float)(cfg.kalman_detection_noise * std::max(box.width, box.height)));
+    return sd * sd;
+}
+
+// Gate entry for one track: its motion-model centre against a detection the size of `box`
+void TrackingPipeline::addGate(const MotionModel& m, const cv::Rect& box) {
+    motion_gate.model.push_back(m);
+    motion_gate.meas_var.push_back(detectionVariance(box));
+}
+
+// A lost track's motion model advanced from the step it was lost to now
+MotionModel TrackingPipeline::predictLost(int slot) const {
+    MotionModel m = track_store.motion[slot];
+    const float q = (float)cfg.kalman_process_noise;
+    for (long long step = lost_index.lostAt(slot); step < track_step; ++step) { m.predict(q); }
+    return m;
+}
+
+// Active -> lost: indexed by where its predicted box can go before it
+// expires (straight line: the two ends)
+void TrackingPipeline::markLost(int slot, long long now) {
+    TrackStore& ts = track_store;
+    ts.setState(slot, TrackState::Lost);
+    const MotionModel& m = ts.motion[slot];
+    const cv::Point2f travel = m.vel * (float)cfg.max_lost_frames;
+    cv::Rect at_loss = m.box(ts.bbox[slot].size()), at_expiry = at_loss + cv::Point(cvRound(travel.x), cvRound(travel.y));
+    lost_index.add(slot, now, at_loss | at_expiry);
+    metrics.tracks_lost.add();
+    emitEvent(EventType::TrackLost, slot);
+    for (uint64_t left = ts.zones[slot]; left; left &= left - 1) { emitEvent(EventType::ZoneExit, slot, lowestBit(left)); }
+    ts.alerts[slot] = 0; ts.zones[slot] = 0;
+    LOG_DEBUG("Moved Track ID " << ts.id[slot] << " to lost tracks.");
+}
+
+void TrackingPipeline::emitEvent(EventType type, int slot, int zone) {
+    if (!event_bus) return;
+    TrackEvent e;
+    e.type = type; e.track_id = track_store.id[slot]; e.class_id = track_store.class_id[slot]; e.zone = zone;
+    e.speed = (float)track_store.velocity[slot]; e.box = track_store.bbox[slot];
+    e.frame_index = event_frame; e.timestamp_us = event_time_us;
+    event_bus->publish(e);
+}
+
+const cv::Mat& TrackingPipeline::trackerInput(const cv::Mat& frame, bool new_frame) {
+    if (cfg.tracker_engine == TrackerEngine::MotionOnly) return frame;
+    if (cfg.tracker_engine == TrackerEngine::LegacyMosse && tracker_scale >= 1.0) return frame;
+    return new_frame ? tracker_frame.prepare(frame) : tracker_frame.get(frame);
+}
+
+cv::Rect TrackingPipeline::toTrackerBox(const cv::Rect& box) const {
+    if (tracker_scale >= 1.0) return box;
+    return cv::Rect(cvRound(box.x * tracker_scale), cvRound(box.y * tracker_scale),
+                    std::max(1, cvRound(box.width * tracker_scale)), std::max(1, cvRound(box.height * tracker_scale)));
+}
+
+bool TrackingPipeline::updateTracker(cv::Tracker& tracker, const cv::Mat& input, cv::Rect& box) const {
+    if (tracker_scale >= 1.0) return tracker.update(input, box);
+    const cv::Rect start = toTrackerBox(box);
+    cv::Rect moved = start;
+    if (!tracker.update(input, moved)) return false;
+    box.x += cvRound((moved.x - start.x) / tracker_scale); box.y += cvRound((moved.y - start.y) / tracker_scale);
+    return true;
+}
+
+cv::Point TrackingPipeline::getCenter(const cv::Rect& rect) { return cv::Point(rect.x + rect.width / 2, rect.y + rect.height / 2); }
+double TrackingPipeline::calculateIoU(const cv::Rect& box1, const cv::Rect& box2) { cv::Rect intersection = box1 & box2; double intersectionArea = intersection.area(); if (intersectionArea <= 0) return 0.0; double unionArea = box1.area() + box2.area() - intersectionArea; if (unionArea <= 0) return 0.0; return intersectionArea / unionArea; }
@@ -0,0 +1,291 @@
+#ifndef TRACKINGPIPELINE_H
+#define TRACKINGPIPELINE_H
+
+// Qt-free detection + tracking core. VideoProcessor (GUI) and the
+// ObjectTrackingCli target both drive this class one frame at a time.
+
+#include "Association.h"
+#include "DetectionScheduler.h"
+#include "EventLog.h"
+#include "LostTrackIndex.h"
+#include "Metrics.h"
+#include "MosseTracker.h"
+#include "PipelineConfig.h"
+#include "RoiPlanner.h"
+#include "TrackStore.h"
+#include "TrackerPool.h"
+#include "YoloDecoder.h"
+#include "ZoneMap.h"
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+#include <opencv2/tracking.hpp>
+
+#include <atomic>
+#include <functional>
+#include <iostream> // For cerr/cout
+#include <memory>
+#include <string>
+#include <vector>
+
+// Post-NMS, class-filtered detector output for one frame
+struct Detections {
+    std::vector<cv::Rect> boxes;
+    std::vector<int> classIds;
+    std::vector<float> confidences;
+    void clear() { boxes.clear(); classIds.clear(); confidences.clear(); }
+};
+
+// What the overlay stage needs from one track, copied out of the
+// tracking state so drawing can run on another thread
+struct TrackOverlay {
+    int id = -1;
+    cv::Rect boundingBox;
+    int classId = -1;
+    double velocity = 0.0;
+    std::vector<cv::Point> trajectory;
+    bool in_zone = false;          // In any zone; alert state decided by collectOverlay()
+    bool zone_alert = false;       // ...in one whose `alert` is set
+    bool over_speed = false;
+    bool alerting() const { return zone_alert || over_speed; } // What record_on_alert and review count as an alert
+};
+
+// Per-frame stage timings (ms) plus running totals for throughput reports.
+struct StageTimings {
+    double capture_ms = 0.0;
+    double tracker_update_ms = 0.0;
+    double detection_ms = 0.0;
+    double drawing_ms = 0.0;
+    double total_ms = 0.0;
+    // Recording writer (filled by RecordingWriter::fillTimings)
+    double record_fps = 0.0;
+    int record_queue = 0;
+    int record_queue_capacity = 0; // 0 = not recording
+};
+
+struct StageTotals {
+    long long frames = 0;
+    long long detection_runs = 0;
+    double capture_ms = 0.0;
+    double tracker_update_ms = 0.0;
+    double detection_ms = 0.0;
+    double drawing_ms = 0.0;
+    double total_ms = 0.0;
+
+    void add(const StageTimings& t, bool detected);
+};
+
+// Pixels handed to the network on detection runs, against full-frame mode
+struct RegionStats {
+    uint64_t runs = 0;
+    uint64_t regions = 0;
+    uint64_t source_px = 0;   // Frame pixels inside the regions (tile overlaps counted twice)
+    uint64_t network_px = 0;  // regions * input_width * input_height
+    uint64_t frame_px = 0;    // Full-frame mode: the whole frame on every run
+};
+
+class AsyncDetector;
+class BatchedDetector;
+class DetectionTraceWriter;
+class RecordingWriter;
+struct DetectionResult;
+
+class TrackingPipeline
+{
+public:
+    using StatusCallback = std::function<void(const std::string&)>;
+
+    explicit TrackingPipeline(const PipelineConfig& config = PipelineConfig());
+    ~TrackingPipeline();
+
+    bool loadNetwork();      // Class names + YOLO weights
+    bool loadClassNames();   // Class names and zones only (tracking without a network)
+    bool loadZones();        // cfg.zones_file, if set (loadClassNames() calls this)
+    bool isModelLoaded() const { return _modelLoaded; }
+    const PipelineConfig& config() const { return cfg; }
+    const std::vector<std::string>& classNames() const { return class_names; }
+    const std::string& className(int class_id) const;
+
+    // Status/error messages (the GUI forwards these to its status label)
+    void setStatusCallback(StatusCallback cb) { status_cb = std::move(cb); }
+    // Run forwards through a network shared with other streams instead of
+    // this pipeline's own (loadClassNames() is then all this pipeline needs)
+    void setSharedDetector(BatchedDetector* detector) { shared_detector = detector; }
+    // Writer whose queue/fps processFrame() shows in the overlay (may be null)
+    void setRecorder(const RecordingWriter* writer) { recorder = writer; }
+    // Every detection run is appended to this trace for later replay (may be null)
+    void setTraceWriter(DetectionTraceWriter* writer) { trace_writer = writer; }
+    // Track and alert events go to this bus (the tracking thread is its producer; may be null)
+    void setEventBus(EventBus* bus) { event_bus = bus; }
+
+    // Clear all tracks and counters before a new source is processed
+    void reset();
+
+    // Run one full step: tracker update, (periodic) detection, overlay.
+    // `frame` is annotated in place (left untouched with cfg.record_raw).
+    // `loop_start_tick` lets the caller include its capture time in the
+    // on-screen FPS figure.
+    void processFrame(cv::Mat& frame, long long loop_start_tick = 0);
+    // Overlay collected by the last processFrame() (recorder sidecar, display)
+    const std::vector<TrackOverlay>& lastOverlay() const { return frame_overlay; }
+
+    // --- Individual stages, exposed so callers can schedule them separately ---
+    // Tracking state (updateTracks / associateAndTrack / collectOverlay) must
+    // stay on one thread. shouldDetect()/detect() only touch the network and
+    // the scheduler's decision state, and drawOverlay() only its arguments,
+    // so each may run on its own thread.
+    void updateTracks(const cv::Mat& frame);
+    // Scheduler decision for `frame_index` (thread that picks detection frames)
+    bool shouldDetect(const cv::Mat& frame, long long frame_index);
+    bool detect(const cv::Mat& frame, Detections& out, double& detection_ms);
+    // Regions to feed the network for `frame` (see RoiPlanner); call on the
+    // thread that just ran shouldDetect(), which it takes its inputs from
+    const std::vector<cv::Rect>& planRegions(cv::Size frame);
+    bool prepareBlob(const cv::Mat& frame, const std::vector<cv::Rect>& regions, cv::Mat& blob_out);
+    bool forwardAndDecode(const cv::Mat& input_blob, const std::vector<cv::Rect>& regions, Detections& out, double& detection_ms);
+    // Asynchronous detection (tracking thread): reconcile a finished result
+    // into the tracks and/or submit this frame as the next snapshot.
+    // Returns true when detections were associated on this frame.
+    bool stepAsyncDetection(const cv::Mat& frame, long long frame_index, double& detection_ms);
+    // Detections of `frame_index` to the trace writer, if one is set (the
+    // async path and processFrame() call it themselves)
+    void recordTrace(long long frame_index, const Detections& detections);
+    const AsyncDetector* asyncDetector() const { return async_detector.get(); }
+    const AssociationStats& associationStats() const { return associator.lastStats(); }
+    const DetectionScheduler& scheduler() const { return detect_scheduler; }
+    const TrackerPool& trackerPool() const { return tracker_pool; }
+    const ZoneMap& zoneMap() const { return zone_map; }
+    RegionStats regionStats() const;
+    // Copy of the tracks updated this frame for drawOverlay(); zone and speed
+    // alerts are decided here, on the tracking thread, and raise their events
+    // (zone membership is a ZoneMap lookup, whatever the number of zones)
+    void collectOverlay(std::vector<TrackOverlay>& out);
+    void drawOverlay(cv::Mat& frame, const std::vector<TrackOverlay>& tracks, long long frame_index, StageTimings& t, double fps) const;
+
+    // --- Overlay / alert switches (safe to flip from any thread) ---
+    void setDrawRestrictedZone(bool enabled) { _drawRestrictedZone = enabled; }
+    void setDrawTrajectory(bool enabled) { _drawTrajectory = enabled; }
+    void setCheckSpeedAlert(bool enabled) { _checkSpeedAlert = enabled; }
+
+    // --- Introspection ---
+    const TrackStore& tracks() const { return track_store; }
+    size_t activeTrackCount() const { return track_store.activeCount(); }
+    size_t lostTrackCount() const { return track_store.lostCount(); }
+    const StageTimings& lastTimings() const { return timings; }
+    const StageTotals& totals() const { return stage_totals; }
+    void setCaptureTime(double ms); // Also recorded as the capture stage latency
+    int frameCount() const { return frame_count; }
+
+    // Helpers (public so they can be exercised in isolation)
+    void compensateMotion(const DetectionResult& result, std::vector<cv::Rect>& boxes) const;
+    void processYoloOutput(const std::vector<cv::Mat>& outs, cv::Size imgSize, Detections& out);
+    void associateAndTrack(const cv::Mat& frame, const std::vector<cv::Rect>& detected_boxes, const std::vector<int>& detected_classIds);
+    static cv::Point getCenter(const cv::Rect& rect);
+    static double calculateIoU(const cv::Rect& box1, const cv::Rect& box2);
+
+private:
+    PipelineConfig cfg;
+    StatusCallback status_cb;
+
+    // This pipeline's series in MetricsRegistry::global(), looked up once
+    struct ExportedMetrics {
+        Counter& frames;
+        Counter& detections;
+        Counter& objects;
+        Counter& tracks_created;
+        Counter& tracks_reidentified;
+        Counter& tracks_lost;
+        Counter& tracks_expired;
+        Counter& tracker_errors;
+        Gauge& active_tracks;
+        Gauge& lost_tracks;
+        explicit ExportedMetrics(const std::string& stream);
+    } metrics;
+
+    // OpenCV Objects
+    cv::dnn::Net net;
+    std::vector<std::string> class_names;
+    std::vector<cv::String> output_layer_names;
+    cv::Mat blob;
+    cv::Mat snapshot_blob;               // Async submissions (track thread)
+    std::vector<cv::Mat> dnn_outs;       // net.forward() outputs (detecting thread)
+    std::string names_path; // Path for coco.names file
+    YoloDecoder yolo_decoder;
+
+    // Tracking State
+    TrackStore track_store;
+    TrackerPool tracker_pool;            // Appearance trackers of expired tracks, re-initialised for new ones
+    TrackerFrame tracker_frame;          // Grayscale of the frame being tracked, shared by all trackers
+    double tracker_scale = 1.0;          // cfg.processing_scale, clamped; tracker_frame is this size
+    int next_track_id = 0;
+    int frame_count = 0;
+    double current_fps = 0.0;
+    bool detected_this_frame = false;
+    Detections frame_detections;
+    std::vector<TrackOverlay> frame_overlay;
+    StageTimings timings;
+    StageTotals stage_totals;
+    std::unique_ptr<AsyncDetector> async_detector;
+    const RecordingWriter* recorder = nullptr;
+    BatchedDetector* shared_detector = nullptr;
+    DetectionTraceWriter* trace_writer = nullptr;
+    EventBus* event_bus = nullptr;
+    long long event_frame = -1;          // Frame (and its wall-clock time) events are stamped with
+    long long event_time_us = 0;
+    cv::Size frame_size;                 // Of the frame being tracked
+    ZoneMap zone_map;                    // Loaded before processing; rasterised on the tracking thread
+
+    // Per-track result of the parallel tracker update, merged serially
+    struct TrackUpdateSlot {
+        int slot;
+        bool success;
+        bool threw;
+        bool appearance;                 // false: motion-model prediction only this frame
+    };
+    std::vector<TrackUpdateSlot> update_slots;
+
+    // Association scratch, reused across detection frames
+    Associator associator;
+    std::vector<cv::Rect> assoc_boxes;
+    std::vector<int> assoc_slots;
+    std::vector<int> det_to_track;
+    std::vector<int> unmatched_dets;
+    std::vector<cv::Rect> unmatched_boxes;
+    std::vector<char> detection_matched;
+    std::vector<int> expired_slots;
+    MotionGate motion_gate;
+    LostTrackIndex lost_index;           // Lost tracks: re-ID candidates by area, expiry by timing wheel
+    std::vector<int> lost_candidates;
+    std::vector<MotionModel> reid_motion;  // Predicted models of lost_candidates
+    long long last_track_tick = 0;
+    double frame_interval_sec = 0.0;     // Smoothed time between updateTracks() calls
+    long long track_step = 0;            // updateTracks() calls: staggers appearance updates, clocks lost tracks
+    DetectionScheduler detect_scheduler;
+    RoiPlanner roi_planner;              // Detection-deciding thread
+    std::vector<cv::Mat> region_crops;
+    std::atomic<uint64_t> region_runs{0}, region_count{0}, region_source_px{0}, region_network_px{0}, region_frame_px{0};
+    int failed_updates = 0;              // Tracker failures on the last updateTracks()
+
+    // State Flags
+    bool _modelLoaded = false;
+    std::atomic<bool> _drawRestrictedZone{true};
+    std::atomic<bool> _drawTrajectory{false};
+    std::atomic<bool> _checkSpeedAlert{true};
+
+    void reportStatus(const std::string& status) const;
+    static cv::Point2f boxCentre(const cv::Rect& r) { return cv::Point2f(r.x + r.width * 0.5f, r.y + r.height * 0.5f); }
+    float detectionVariance(const cv::Rect& box) const;
+    void addGate(const MotionModel& m, const cv::Rect& box);
+    MotionModel predictLost(int slot) const;
+    void markLost(int slot, long long now);
+    void emitEvent(EventType type, int slot, int zone = -1);
+    // What trackers are fed for `frame`: the shared grayscale, or the frame itself (legacy),
+    // shrunk by tracker_scale
+    const cv::Mat& trackerInput(const cv::Mat& frame, bool new_frame);
+    // Native box <-> tracker image. A tracker update only moves the box, so
+    // its shift is scaled back and the native size is kept as is.
+    cv::Rect toTrackerBox(const cv::Rect& box) const;
+    bool updateTracker(cv::Tracker& tracker, const cv::Mat& input, cv::Rect& box) const;
+};
+
+#endif // TRACKINGPIPELINE_H
@@ -0,0 +1,157 @@
+#include "YoloDecoder.h"
+#include "TrackingPipeline.h" // Detections
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <numeric>
+
+// Across crops, a box this much inside another of its class is a duplicate
+static const double CONTAINED = 0.7;
+
+void YoloDecoder::configure(const std::vector<std::string>& class_names, const std::set<std::string>& desired_classes,
+                            float confidence_threshold, float nms_thresh) {
+    conf_threshold = confidence_threshold;
+    nms_threshold = nms_thresh;
+    class_count = (int)class_names.size();
+    desired_ids.clear();
+    for (int i = 0; i < class_count; ++i) {
+        if (desired_classes.count(class_names[i])) { desired_ids.push_back(i); }
+    }
+    class_mask.assign(((class_count + 3) / 4) * 4, 0u);
+    for (int id : desired_ids) { class_mask[id] = 0xFFFFFFFFu; }
+    // Masked pass up to the last desired column, when that is no more vector
+    // steps than the gather has reads
+    mask_end = desired_ids.empty() ? 0 : std::min((desired_ids.back() / 4 + 1) * 4, class_count);
+#if CV_SIMD128
+    masked_pass = (size_t)(mask_end + 3) / 4 <= desired_ids.size();
+#else
+    masked_pass = false;
+#endif
+}
+
+int YoloDecoder::bestDesiredClass(const float* scores, float& best_score) const {
+    int best_id = -1; best_score = -FLT_MAX;
+    if (!masked_pass) {
+        for (int id : desired_ids) {
+            if (scores[id] > best_score) { best_score = scores[id]; best_id = id; }
+        }
+        return best_id;
+    }
+
+    int i = 0;
+#if CV_SIMD128
+    // Masked max over the class columns up to the last desired one, four at a time
+    const cv::v_float32x4 v_low = cv::v_setall_f32(-FLT_MAX);
+    cv::v_float32x4 v_best = v_low;
+    for (; i + 4 <= mask_end; i += 4) {
+        cv::v_float32x4 v = cv::v_load(scores + i);
+        cv::v_float32x4 m = cv::v_reinterpret_as_f32(cv::v_load(&class_mask[i]));
+        v_best = cv::v_max(v_best, cv::v_select(m, v, v_low));
+    }
+    best_score = cv::v_reduce_max(v_best);
+#endif
+    for (; i < mask_end; ++i) {
+        if (class_mask[i] && scores[i] > best_score) { best_score = scores[i]; }
+    }
+    // First desired column holding the max (same tie-break as minMaxLoc)
+    for (int id : desired_ids) {
+        if (scores[id] == best_score) { best_id = id; break; }
+    }
+    return best_id;
+}
+
+void YoloDecoder::decode(const std::vector<cv::Mat>& outs, cv::Size img_size, Detections& out) {
+    out.clear();
+    cand_boxes.clear(); cand_scores.clear(); cand_classes.clear(); cand_regions.clear();
+    rows_seen = 0; rows_passed = 0;
+    if (desired_ids.empty()) return;
+
+    const cv::Rect whole(0, 0, img_size.width, img_size.height);
+    for (const cv::Mat& output : outs) { decodeRows(output, whole, 0); }
+    classAwareNms(out, false);
+}
+
+void YoloDecoder::decode(const std::vector<cv::Mat>& outs, const std::vector<cv::Rect>& regions, Detections& out) {
+    out.clear();
+    cand_boxes.clear(); cand_scores.clear(); cand_classes.clear(); cand_regions.clear();
+    rows_seen = 0; rows_passed = 0;
+    if (desired_ids.empty() || regions.empty()) return;
+
+    const int n = (int)regions.size();
+    cv::Mat view;
+    for (const cv::Mat& head : outs) {
+        for (int i = 0; i < n; ++i) {
+            if (batchSlice(head, n, i, 1, view)) { decodeRows(view, regions[i], i); }
+        }
+    }
+    classAwareNms(out, n > 1);
+}
+
+bool YoloDecoder::batchSlice(const cv::Mat& head, int n, int first, int count, cv::Mat& view) {
+    if (head.dims == 3 && head.size[0] == n) {
+        if (count == 1) { view = cv::Mat(head.size[1], head.size[2], head.type(), (void*)head.ptr(first)); }
+        else { int sizes[3] = {count, head.size[1], head.size[2]}; view = cv::Mat(3, sizes, head.type(), (void*)head.ptr(first)); }
+        return true;
+    }
+    if (head.dims == 2 && n > 0 && head.rows % n == 0) {
+        int rows = head.rows / n;
+        view = head.rowRange(first * rows, (first + count) * rows);
+        return true;
+    }
+    return false;
+}
+
+// Rows of one image's output head; boxes are relative to `region`
+void YoloDecoder::decodeRows(const cv::Mat& output, const cv::Rect& region, int region_index) {
+    if (output.dims != 2 || output.cols < 5 + class_count) return; // Not a YOLO head we understand
+    const float* data = (const float*)output.data;
+    const size_t row_step = output.step1();
+    rows_seen += output.rows;
+    for (int i = 0; i < output.rows; ++i, data += row_step) {
+        if (data[4] <= conf_threshold) continue; // Objectness early-out
+        rows_passed++;
+        float score;
+        int class_id = bestDesiredClass(data + 5, score);
+        if (class_id < 0 || score <= conf_threshold) continue;
+        int centerX = region.x + (int)(data[0] * region.width); int centerY = region.y + (int)(data[1] * region.height);
+        int width = (int)(data[2] * region.width); int height = (int)(data[3] * region.height);
+        cand_boxes.push_back(cv::Rect(centerX - width / 2, centerY - height / 2, width, height));
+        cand_scores.push_back(score);
+        cand_classes.push_back(class_id);
+        cand_regions.push_back(region_index);
+    }
+}
+
+// Greedy NMS in descending score order; a box only suppresses boxes of its
+// own class. Output stays in descending score order.
+void YoloDecoder::classAwareNms(Detections& out, bool across_regions) {
+    const int n = (int)cand_boxes.size();
+    order.resize(n);
+    std::iota(order.begin(), order.end(), 0);
+    // Ties broken by index: the stable order without stable_sort's merge buffer
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return cand_scores[a] > cand_scores[b] || (cand_scores[a] == cand_scores[b] && a < b);
+    });
+    suppressed.assign(n, 0);
+
+    for (int oi = 0; oi < n; ++oi) {
+        int i = order[oi];
+        if (suppressed[i]) continue;
+        out.boxes.push_back(cand_boxes[i]);
+        out.classIds.push_back(cand_classes[i]);
+        out.confidences.push_back(cand_scores[i]);
+        const cv::Rect& a = cand_boxes[i];
+        for (int oj = oi + 1; oj < n; ++oj) {
+            int j = order[oj];
+            if (suppressed[j] || cand_classes[j] != cand_classes[i]) continue;
+            const cv::Rect& b = cand_boxes[j];
+            double inter = (a & b).area();
+            double uni = (double)a.area() + b.area() - inter;
+            if (uni > 0 && inter / uni > nms_threshold) { suppressed[j] = 1; }
+            // Part of an object cut off by another crop's edge
+            else if (across_regions && cand_regions[j] != cand_regions[i] && inter > CONTAINED * std::min(a.area(), b.area())) { suppressed[j] = 1; }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef YOLODECODER_H
+#define YOLODECODER_H
+
+// Decodes raw YOLO output rows ([cx, cy, w, h, objectness, 80 class
+// scores] per row) into final detections:
+//  1. rows whose objectness is at or below the confidence threshold are
+//     rejected before any class score is touched (Darknet class scores are
+//     already objectness * class probability, so none could pass);
+//  2. argmax runs only over the desired class columns: a masked SIMD max
+//     over the columns up to the last desired class when that is no more
+//     vector steps than there are desired classes (the default set, ids
+//     0-7, takes two), else a scalar read of each desired column;
+//  3. class-aware NMS runs on the survivors only.
+// A batch may hold several crops of one frame (ROI / tiled detection); each
+// crop's boxes are mapped back to frame coordinates and NMS then runs across
+// crops, also dropping a box mostly contained in a higher-scoring box from
+// another crop (an object cut in two by a crop edge).
+// All scratch space lives in member buffers that are reused across calls.
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+struct Detections;
+
+class YoloDecoder
+{
+public:
+    YoloDecoder() = default;
+
+    // Resolve desired class names to column indices; call after loading names
+    void configure(const std::vector<std::string>& class_names, const std::set<std::string>& desired_classes,
+                   float confidence_threshold, float nms_threshold);
+
+    void decode(const std::vector<cv::Mat>& outs, cv::Size img_size, Detections& out);
+    // `outs` hold regions.size() images, image i being the crop regions[i]
+    void decode(const std::vector<cv::Mat>& outs, const std::vector<cv::Rect>& regions, Detections& out);
+
+    // 2D view of images [first, first + count) of one batched output head
+    // (3D [N, rows, cols] or 2D with N * rows stacked); false if it can't split
+    static bool batchSlice(const cv::Mat& head, int n, int first, int count, cv::Mat& view);
+
+    // Rows seen / rows past the objectness test in the last decode()
+    int rowsSeen() const { return rows_seen; }
+    int rowsPassed() const { return rows_passed; }
+
+private:
+    float conf_threshold = 0.4f;
+    float nms_threshold = 0.4f;
+    int class_count = 0;
+    std::vector<int> desired_ids;       // Column offsets (0-based class ids)
+    std::vector<uint32_t> class_mask;   // All-ones bits for desired classes, padded to a multiple of 4
+    int mask_end = 0;                   // Columns the masked pass covers (past the last desired class)
+    bool masked_pass = false;           // Masked SIMD max instead of reading each desired column
+
+    // Reused scratch
+    std::vector<cv::Rect> cand_boxes;
+    std::vector<float> cand_scores;
+    std::vector<int> cand_classes;
+    std::vector<int> cand_regions;
+    std::vector<int> order;
+    std::vector<char> suppressed;
+    int rows_seen = 0;
+    int rows_passed = 0;
+
+    // Returns best desired class for one row's class scores, or -1
+    int bestDesiredClass(const float* scores, float& best_score) const;
+    void decodeRows(const cv::Mat& output, const cv::Rect& region, int region_index);
+    void classAwareNms(Detections& out, bool across_regions);
+};
+
+#endif // YOLODECODER_H
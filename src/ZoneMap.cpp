@@ -0,0 +1,124 @@
+#include "ZoneMap.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+ZoneMap::ZoneMap() {
+    Zone restricted;
+    restricted.name = "Restricted";
+    restricted.polygon = {cv::Point2f(0.f, 0.f), cv::Point2f(0.5f, 0.f), cv::Point2f(0.5f, 0.5f), cv::Point2f(0.f, 0.5f)};
+    zone_list.push_back(restricted);
+}
+
+bool ZoneMap::load(const std::string& path, std::string& error) {
+    cv::FileStorage fs;
+    try {
+        if (!fs.open(path, cv::FileStorage::READ)) { error = "could not open " + path; return false; }
+    } catch (const cv::Exception& ex) {
+        error = ex.what();
+        return false;
+    }
+    std::vector<Zone> loaded;
+    cv::FileNode list = fs["zones"];
+    if (!list.isSeq()) { error = "no `zones` list in " + path; return false; }
+    for (cv::FileNodeIterator it = list.begin(); it != list.end(); ++it) {
+        cv::FileNode n = *it;
+        Zone z;
+        z.name = n["name"].isNone() ? "zone " + std::to_string(loaded.size()) : (std::string)n["name"];
+        std::vector<float> xy;
+        cv::FileNode poly = n["polygon"];
+        for (cv::FileNodeIterator p = poly.begin(); p != poly.end(); ++p) { xy.push_back((float)*p); }
+        if (xy.size() < 6 || xy.size() % 2 != 0) { error = "zone '" + z.name + "': polygon needs at least 3 x, y pairs"; return false; }
+        for (size_t i = 0; i < xy.size(); i += 2) { z.polygon.emplace_back(xy[i], xy[i + 1]); }
+        cv::FileNode classes = n["classes"];
+        for (cv::FileNodeIterator c = classes.begin(); c != classes.end(); ++c) { z.classes.insert((std::string)*c); }
+        z.alert = n["alert"].isNone() || (int)n["alert"] != 0;
+        loaded.push_back(z);
+    }
+    if (loaded.size() > (size_t)MAX_ZONES) { error = "more than " + std::to_string(MAX_ZONES) + " zones"; return false; }
+    setZones(loaded);
+    return true;
+}
+
+void ZoneMap::setZones(const std::vector<Zone>& zones) {
+    zone_list.assign(zones.begin(), zones.begin() + std::min(zones.size(), (size_t)MAX_ZONES));
+    frame_size = cv::Size(); // Rebuilt on the next prepare()
+}
+
+uint64_t ZoneMap::alertMask() const {
+    uint64_t mask = 0;
+    for (size_t z = 0; z < zone_list.size(); ++z) { if (zone_list[z].alert) { mask |= (uint64_t)1 << z; } }
+    return mask;
+}
+
+void ZoneMap::scaled(const Zone& zone, cv::Size frame, std::vector<cv::Point>& out) {
+    out.clear();
+    for (const cv::Point2f& p : zone.polygon) { out.emplace_back(cvRound(p.x * frame.width), cvRound(p.y * frame.height)); }
+}
+
+// Each zone is filled into a scratch mask, then every cell it covers moves
+// from its current label to the label for (current zones | this zone).
+// Labels are created as combinations are first seen, so the table only
+// holds combinations that actually occur.
+void ZoneMap::prepare(cv::Size frame, const std::vector<std::string>& class_names) {
+    if (frame == frame_size && class_zones.size() == class_names.size()) return;
+    frame_size = frame;
+    const cv::Size grid((frame.width + CELL - 1) / CELL, (frame.height + CELL - 1) / CELL);
+    labels.create(grid, CV_16U);
+    labels.setTo(cv::Scalar::all(0));
+    label_zones.assign(1, 0);
+    std::unordered_map<uint64_t, uint16_t> label_of;
+    label_of[0] = 0;
+
+    cv::Mat mask(grid, CV_8U);
+    std::vector<cv::Point> pts;
+    std::vector<int> remap;
+    for (size_t z = 0; z < zone_list.size(); ++z) {
+        mask.setTo(cv::Scalar::all(0));
+        scaled(zone_list[z], grid, pts);
+        cv::fillPoly(mask, std::vector<std::vector<cv::Point>>{pts}, cv::Scalar(255));
+        const cv::Rect area = cv::boundingRect(pts) & cv::Rect(cv::Point(), grid);
+        const uint64_t bit = (uint64_t)1 << z;
+        remap.assign(label_zones.size(), -1);
+        for (int y = area.y; y < area.y + area.height; ++y) {
+            const uint8_t* m = mask.ptr<uint8_t>(y);
+            uint16_t* l = labels.ptr<uint16_t>(y);
+            for (int x = area.x; x < area.x + area.width; ++x) {
+                if (!m[x]) continue;
+                int& to = remap[l[x]];
+                if (to < 0) {
+                    const uint64_t zones = label_zones[l[x]] | bit;
+                    auto found = label_of.find(zones);
+                    if (found == label_of.end()) {
+                        if (label_zones.size() > 0xFFFF) continue; // Out of labels: cell keeps its old zones
+                        found = label_of.emplace(zones, (uint16_t)label_zones.size()).first;
+                        label_zones.push_back(zones);
+                    }
+                    to = found->second;
+                }
+                l[x] = (uint16_t)to;
+            }
+        }
+    }
+
+    class_zones.assign(class_names.size(), 0);
+    any_class_zones = 0;
+    for (size_t z = 0; z < zone_list.size(); ++z) {
+        const uint64_t bit = (uint64_t)1 << z;
+        if (zone_list[z].classes.empty()) { any_class_zones |= bit; }
+        for (size_t c = 0; c < class_names.size(); ++c) {
+            if (zone_list[z].classes.empty() || zone_list[z].classes.count(class_names[c])) { class_zones[c] |= bit; }
+        }
+    }
+}
+
+uint64_t ZoneMap::lookup(const cv::Rect& box, int class_id) const {
+    if (labels.empty()) return 0;
+    const int x = box.x + box.width / 2, y = box.y + box.height - 1; // Foot point
+    if (x < 0 || y < 0 || x >= frame_size.width || y >= frame_size.height) return 0;
+    const uint64_t zones = label_zones[labels.at<uint16_t>(y / CELL, x / CELL)];
+    const uint64_t applies = class_id >= 0 && class_id < (int)class_zones.size() ? class_zones[class_id] : any_class_zones;
+    return zones & applies;
+}
@@ -0,0 +1,73 @@
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+// Polygon zones with per-zone rules, looked up per track in constant time.
+// The polygons are rasterised once per frame size into a label grid (one
+// cell per CELL x CELL pixels). Each label stands for one combination of
+// overlapping zones and maps to a 64-bit zone mask, so a track's
+// membership is a single grid read at its foot point (bottom centre of the
+// box) ANDed with the zones that apply to its class, however many zones
+// there are. Enter/exit transitions are the XOR of that mask with the
+// track's mask from the previous frame.
+//
+// Zones come from a YAML or JSON file (cv::FileStorage), polygon vertices
+// given as fractions of the frame width/height so one file fits any
+// resolution:
+//   zones:
+//     - name: loading_dock
+//       polygon: [0.05, 0.60, 0.40, 0.55, 0.45, 0.95, 0.05, 0.98]   # x, y pairs
+//       classes: [person, bicycle]     # Optional; default every class
+//       alert: 1                       # Optional; 0 = events only, no ALERT log line
+// Without a file there is one zone, "Restricted": the top-left quarter.
+//
+// At most MAX_ZONES zones (the width of the mask). load() runs before
+// processing starts; prepare() and lookup() belong to the tracking thread,
+// zones() may be read from any thread (it does not change once loaded).
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+struct Zone {
+    std::string name;
+    std::vector<cv::Point2f> polygon;   // Fractions of frame width / height
+    std::set<std::string> classes;      // Class names the zone applies to; empty = all
+    bool alert = true;                  // Log an ALERT when a track enters
+};
+
+class ZoneMap
+{
+public:
+    static const int MAX_ZONES = 64;
+    static const int CELL = 4;          // Grid cell side in pixels
+
+    ZoneMap();                          // The default "Restricted" zone
+
+    // Replaces the zones; false (zones unchanged) with `error` set on a bad file
+    bool load(const std::string& path, std::string& error);
+    void setZones(const std::vector<Zone>& zones);
+    const std::vector<Zone>& zones() const { return zone_list; }
+    // Zones with `alert` set, as a zone mask
+    uint64_t alertMask() const;
+
+    // Rasterise for `frame` unless already done for that size; `class_names`
+    // resolves the per-zone class filters to class ids
+    void prepare(cv::Size frame, const std::vector<std::string>& class_names);
+    // Zones containing the foot point of `box` that apply to `class_id`
+    uint64_t lookup(const cv::Rect& box, int class_id) const;
+    // Polygon in pixels for a frame of `frame` size (drawing)
+    static void scaled(const Zone& zone, cv::Size frame, std::vector<cv::Point>& out);
+
+private:
+    std::vector<Zone> zone_list;
+    cv::Size frame_size;                // Size the grid was built for; empty = stale
+    cv::Mat labels;                     // CV_16U, one label per cell
+    std::vector<uint64_t> label_zones;  // Label -> zone mask
+    std::vector<uint64_t> class_zones;  // Class id -> zones that apply to it
+    uint64_t any_class_zones = 0;       // Zones without a class filter (unknown class ids)
+};
+
+#endif // ZONEMAP_H
@@ -0,0 +1,702 @@
+// Headless batch runner: processes a video file or camera index at full
+// speed with no window and prints per-stage throughput.
+//
+// Usage: ObjectTrackingCli <video-file | camera-index> [more sources...] [options]
+//        ObjectTrackingCli [video-file] --replay-trace <trace> [--no-video] [--tracks-out <file>]
+//        ObjectTrackingCli --review <recording.avi> [--review-out <file>] [--no-video] [--tracks-out <file>]
+//   With several sources every stream runs its own stage threads, but all
+//   of them share one network whose forwards are batched (BatchedDetector).
+//   Replay feeds a trace written by --record-trace into the tracker instead
+//   of running the network (see DetectionTrace.h).
+//   Review re-draws a --record-raw recording from its .tracks sidecar
+//   (see OverlaySidecar.h) into an annotated copy.
+//   --data <dir>        Folder with coco.names / yolov4-tiny.* (default ../data/)
+//   --max-frames <n>    Stop after n frames (default: until end of stream)
+//   --report-every <n>  Print a throughput line every n frames (default 100)
+//   --record <file>     Write the annotated stream to an MJPG .avi (on its own thread)
+//   --record-policy <p> When the recording queue is full: block | drop | degrade (default)
+//   --segment-seconds <s>  Start a new file every s seconds of video (<file>_NNN.avi)
+//   --segment-mb <n>    Start a new file once the current one reaches n MB
+//   --record-raw        Record the stream without overlay plus a .tracks sidecar per
+//                       segment; nothing is drawn on the worker threads
+//   --record-on-alert   Only record incidents: a zone or speed alert writes the
+//                       pre-roll, then video until the post-roll has passed without
+//                       another alert (<file>_event_NNN.avi per incident)
+//   --preroll <s>       Seconds kept in memory before an alert (default 5)
+//   --postroll <s>      Seconds recorded after the last alert (default 10)
+//   --preroll-mb <n>    Memory cap for the compressed pre-roll (default 64)
+//   --no-overlay        Skip drawing zone/trajectory overlays
+//   --sequential        Run all stages on one thread (the old QTimer behaviour)
+//   --queue-depth <n>   Frames buffered between stages in threaded mode (default 4)
+//   --sync-detect       Run the network inline on the detection frame instead of
+//                       asynchronously on a snapshot
+//   --fixed-detect      Detect every 30 frames (or when nothing is tracked) instead
+//                       of letting DetectionScheduler pick frames
+//   --detect-budget <f> Share of frames triggered detections may use (default 0.25)
+//   --min-psr <f>       Detect when a tracker's peak-to-sidelobe ratio drops below f
+//                       (default 8; 0 disables)
+//   --detect-regions <m>  full (default) | roi (crops around motion and tracks) | tiles
+//   --tile-size <px>    Tile side for tiles / roi fallback (default 960)
+//   --legacy-tracker    cv::legacy::TrackerMOSSE per track instead of MosseTracker
+//                       on the shared grayscale frame
+//   --appearance-interval <k>  Run each track's appearance tracker every k frames,
+//                       Kalman prediction in between (default 1)
+//   --processing-scale <s>  Appearance trackers work on the frame scaled by s (0.1 - 1,
+//                       default 1); boxes, zones and recording stay at native size
+//   --batch-max <n>     Multi-stream: images per batched forward (default 8)
+//   --batch-deadline <ms>  Multi-stream: longest a request waits for its batch (default 15)
+//   --metrics-file <f>  Rewrite Prometheus-format metrics to f every few seconds
+//   --metrics-interval <s>  Seconds between metrics file writes (default 5)
+//   --log-level <l>     error | warn | info (default: alerts) | debug (every track event)
+//   --record-trace <f>  Append every detection run's boxes to a binary trace (single source)
+//   --replay-trace <f>  Track from a recorded trace; no network is loaded
+//   --no-video          Replay without decoding video: boxes follow the motion model only
+//   --tracks-out <f>    Replay / review: write every frame's tracks as MOTChallenge CSV
+//                       (frame,id,x,y,w,h,1,-1,-1,-1), for diffing two runs
+//   --review <f>        Draw a raw recording's sidecar onto it (<f>_review.avi)
+//   --review-out <f>    ...into this file instead; with --no-video only the sidecar is read
+//   --events <f>        Append track / zone / speed events to f as JSON lines (see EventLog.h)
+//   --zones <f>         Zone polygons and rules, YAML or JSON (see ZoneMap.h)
+//
+// Every [window] line is followed by heap and cv::Mat allocations per frame
+// over that window; in steady state both should be (close to) zero. The
+// run ends with per-stage latency percentiles from the metrics registry.
+
+#include "AllocationCounters.h"
+#include "BatchedDetector.h"
+#include "BufferPool.h"
+#include "DetectionTrace.h"
+#include "EventLog.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "OverlaySidecar.h"
+#include "RecordingWriter.h"
+#include "StagedPipeline.h"
+#include "TrackingPipeline.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void printUsage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " <video-file | camera-index> [more sources...] [--data <dir>] [--max-frames <n>]"
+              << " [--report-every <n>] [--record <file>] [--record-policy <p>]"
+              << " [--segment-seconds <s>] [--segment-mb <n>] [--record-raw]"
+              << " [--record-on-alert] [--preroll <s>] [--postroll <s>] [--preroll-mb <n>] [--no-overlay] [--sequential] [--queue-depth <n>]"
+              << " [--sync-detect] [--fixed-detect] [--detect-budget <f>] [--min-psr <f>]"
+              << " [--detect-regions full|roi|tiles] [--tile-size <px>] [--legacy-tracker] [--appearance-interval <k>] [--processing-scale <s>]"
+              << " [--batch-max <n>] [--batch-deadline <ms>] [--metrics-file <f>] [--metrics-interval <s>]"
+              << " [--log-level error|warn|info|debug] [--record-trace <f>] [--events <f>] [--zones <f>]" << std::endl;
+    std::cerr << "       " << argv0 << " [video-file] --replay-trace <f> [--no-video] [--tracks-out <f>] [--max-frames <n>]" << std::endl;
+    std::cerr << "       " << argv0 << " --review <recording> [--review-out <f>] [--no-video] [--tracks-out <f>] [--zones <f>]" << std::endl;
+}
+
+static bool isCameraIndex(const std::string& s) {
+    if (s.empty()) return false;
+    for (char c : s) { if (c < '0' || c > '9') return false; }
+    return true;
+}
+
+static void printThroughput(const char* tag, const StageTotals& t, double wall_sec) {
+    if (t.frames == 0) return;
+    double n = (double)t.frames;
+    auto stageFps = [](double ms_per_frame) { return ms_per_frame > 1e-6 ? 1000.0 / ms_per_frame : 0.0; };
+    double det_avg = t.detection_runs > 0 ? t.detection_ms / t.detection_runs : 0.0;
+    std::cout << cv::format("%s frames=%lld wall=%.2fs fps=%.1f | capture %.2f ms (%.0f fps) | track %.2f ms (%.0f fps)"
+                            " | detect %.2f ms/run x%lld (%.1f ms/frame) | draw %.2f ms | total %.2f ms",
+                            tag, t.frames, wall_sec, wall_sec > 0 ? n / wall_sec : 0.0,
+                            t.capture_ms / n, stageFps(t.capture_ms / n),
+                            t.tracker_update_ms / n, stageFps(t.tracker_update_ms / n),
+                            det_avg, t.detection_runs, t.detection_ms / n,
+                            t.drawing_ms / n, t.total_ms / n)
+              << std::endl;
+}
+
+static void printStageReport(const std::vector<StageReport>& stages) {
+    for (const StageReport& r : stages) {
+        double avg = r.frames > 0 ? r.busy_ms / r.frames : 0.0;
+        std::cout << cv::format("  %-8s frames=%llu busy=%.2f ms/frame in_stalls=%llu out_stalls=%llu queue=%zu/%zu (max %zu)",
+                                r.name.c_str(), (unsigned long long)r.frames, avg,
+                                (unsigned long long)r.input_stalls, (unsigned long long)r.output_stalls,
+                                r.queue_occupancy, r.queue_capacity, r.queue_high_water)
+                  << std::endl;
+    }
+}
+
+static void printAllocations(const char* tag, const AllocSnapshot& d, long long frames) {
+    if (frames <= 0) return;
+    double n = (double)frames;
+    std::cout << cv::format("%s allocs/frame: heap %.2f (%.0f B) | mat %.2f (%.0f B)%s",
+                            tag, d.heap_allocs / n, d.heap_bytes / n, d.mat_allocs / n, d.mat_bytes / n,
+                            AllocationCounters::heapCountingEnabled() ? "" : " [heap not counted]")
+              << std::endl;
+}
+
+static void printRecording(const RecordingWriter& recorder, const PipelineConfig& config) {
+    RecordingStats s = recorder.stats();
+    if (config.record_on_alert && s.preroll_limit > 0) {
+        std::cout << cv::format("Pre-roll: %.1f s, memory high water %.1f/%.1f MB",
+                                config.record_preroll_seconds, s.preroll_high_water / 1048576.0, s.preroll_limit / 1048576.0)
+                  << std::endl;
+    }
+    if (s.segments == 0) return;
+    std::cout << cv::format("Recording: %llu written, %llu dropped, %llu degraded, %llu %s | encode %.2f ms/frame (%.0f fps) | queue high water %zu/%zu",
+                            (unsigned long long)s.frames_written, (unsigned long long)s.frames_dropped,
+                            (unsigned long long)s.frames_degraded, (unsigned long long)s.segments,
+                            config.record_on_alert ? "incident(s)" : "segment(s)",
+                            s.write_ms, s.write_fps, s.queue_high_water, s.queue_capacity)
+              << std::endl;
+    for (const std::string& path : recorder.segmentPaths()) {
+        std::cout << "  " << path;
+        if (config.record_raw) { std::cout << " + " << sidecarPath(path); }
+        std::cout << std::endl;
+    }
+}
+
+// Appearance trackers built from scratch vs. recycled (TrackerPool)
+static void printTrackerPool(const char* tag, const TrackerPool& pool, double wall_sec) {
+    uint64_t created = pool.created(), reused = pool.reused();
+    if (created + reused == 0) return;
+    std::cout << cv::format("%s trackers: created %llu (%.1f/s) | reused %llu (%.1f/s) | idle %zu",
+                            tag, (unsigned long long)created, wall_sec > 0 ? created / wall_sec : 0.0,
+                            (unsigned long long)reused, wall_sec > 0 ? reused / wall_sec : 0.0, pool.idle())
+              << std::endl;
+}
+
+static void printScheduler(const char* tag, const DetectionScheduler& s) {
+    uint64_t triggered = s.triggeredTotal(), skipped = s.skippedTotal();
+    if (triggered + skipped == 0) return;
+    std::string line = cv::format("%s detections triggered %llu (", tag, (unsigned long long)triggered);
+    const char* sep = "";
+    for (int r = 0; r < (int)DetectReason::Count; ++r) {
+        uint64_t n = s.triggered((DetectReason)r);
+        if (n) { line += cv::format("%s%s %llu", sep, DetectionScheduler::name((DetectReason)r), (unsigned long long)n); sep = ", "; }
+    }
+    line += cv::format(") skipped %llu (", (unsigned long long)skipped);
+    sep = "";
+    for (int r = 0; r < (int)SkipReason::Count; ++r) {
+        uint64_t n = s.skipped((SkipReason)r);
+        if (n) { line += cv::format("%s%s %llu", sep, DetectionScheduler::name((SkipReason)r), (unsigned long long)n); sep = ", "; }
+    }
+    std::cout << line << ")" << std::endl;
+}
+
+// Per-stage latency percentiles (whole run, all streams)
+static void printLatencies() {
+    std::cout << cv::format("%-11s %9s %9s %9s %9s %9s", "stage", "calls", "mean ms", "p50 ms", "p95 ms", "p99 ms") << std::endl;
+    for (int s = 0; s < (int)PipelineStage::Count; ++s) {
+        LatencyHistogram::Snapshot h = stageLatency((PipelineStage)s).snapshot();
+        if (h.count == 0) continue;
+        std::cout << cv::format("%-11s %9llu %9.2f %9.2f %9.2f %9.2f", stageName((PipelineStage)s), (unsigned long long)h.count,
+                                h.mean(), h.quantile(0.5), h.quantile(0.95), h.quantile(0.99))
+                  << std::endl;
+    }
+}
+
+// Pixels the network looked at, against full-frame mode (one input-sized
+// image of the whole frame per run)
+static void printRegions(const char* tag, const RegionStats& s, const PipelineConfig& cfg) {
+    if (s.runs == 0) return;
+    double runs = (double)s.runs;
+    double full_network_px = (double)cfg.input_width * cfg.input_height;
+    std::cout << cv::format("%s detection regions: %.2f/run | source %.0f px/run (%.1f%% of frame) | network input %.0f px/run (%.2fx full-frame)",
+                            tag, s.regions / runs, s.source_px / runs, s.frame_px ? 100.0 * s.source_px / s.frame_px : 0.0,
+                            s.network_px / runs, s.network_px / runs / full_network_px)
+              << std::endl;
+}
+
+static void printTrace(const DetectionTraceWriter& trace, const std::string& path) {
+    if (path.empty() || trace.records() == 0) return;
+    std::cout << "Detection trace: " << trace.records() << " detection run(s) written to " << path << std::endl;
+}
+
+static void startEvents(EventLogWriter& log, const std::vector<EventBus*>& buses, const std::string& path) {
+    if (path.empty()) return;
+    if (!log.start(path, buses)) { std::cerr << "Warning: Event log disabled, could not open " << path << std::endl; }
+}
+
+// Stops the writer, so everything published is on disk before it is counted
+static void printEvents(EventLogWriter& log, const std::vector<const EventBus*>& buses, const std::string& path) {
+    if (!log.isRunning()) return;
+    log.stop();
+    uint64_t dropped = 0;
+    for (const EventBus* bus : buses) { dropped += bus->dropped(); }
+    std::cout << cv::format("Events: %llu written to %s, %llu dropped (ring full)", (unsigned long long)log.written(), path.c_str(),
+                            (unsigned long long)dropped)
+              << std::endl;
+}
+
+static StageTotals windowOf(const StageTotals& now, const StageTotals& start) {
+    StageTotals window = now;
+    window.frames -= start.frames; window.detection_runs -= start.detection_runs;
+    window.capture_ms -= start.capture_ms; window.tracker_update_ms -= start.tracker_update_ms;
+    window.detection_ms -= start.detection_ms; window.drawing_ms -= start.drawing_ms;
+    window.total_ms -= start.total_ms;
+    return window;
+}
+
+static bool openSource(cv::VideoCapture& cap, const std::string& source) {
+    return isCameraIndex(source) ? cap.open(std::atoi(source.c_str())) : cap.open(source);
+}
+
+// --- Multi-stream: N sources, one shared batched network ---
+struct StreamRun {
+    std::string source;
+    cv::VideoCapture cap;
+    std::unique_ptr<TrackingPipeline> pipeline;
+    std::unique_ptr<StagedPipeline> staged;
+    std::unique_ptr<EventBus> events;
+    std::atomic<long long> frames_out{0};
+    std::atomic<bool> done{false};
+};
+
+static int runMultiStream(const std::vector<std::string>& sources, const PipelineConfig& config,
+                          long long max_frames, long long report_every, bool overlay) {
+    BatchedDetector detector(config);
+    if (!detector.loadNetwork()) { std::cerr << "Error: Network model not loaded." << std::endl; return 2; }
+
+    std::vector<std::unique_ptr<StreamRun>> streams;
+    for (const std::string& source : sources) {
+        auto s = std::make_unique<StreamRun>();
+        s->source = source;
+        if (!openSource(s->cap, source)) { std::cerr << "Error: Could not open source: " << source << std::endl; return 3; }
+        PipelineConfig stream_config = config;
+        stream_config.metrics_stream = std::to_string(streams.size());
+        s->pipeline = std::make_unique<TrackingPipeline>(stream_config);
+        if (!s->pipeline->loadClassNames()) { return 2; }
+        s->pipeline->setSharedDetector(&detector);
+        if (!config.events_file.empty()) {
+            s->events = std::make_unique<EventBus>((size_t)config.event_queue_depth, stream_config.metrics_stream);
+            s->pipeline->setEventBus(s->events.get());
+        }
+        s->pipeline->setDrawRestrictedZone(overlay);
+        s->pipeline->setDrawTrajectory(overlay);
+        s->pipeline->reset();
+        s->staged = std::make_unique<StagedPipeline>(*s->pipeline, (size_t)config.queue_depth);
+        streams.push_back(std::move(s));
+    }
+
+    std::vector<EventBus*> buses;
+    for (auto& s : streams) { if (s->events) buses.push_back(s->events.get()); }
+    EventLogWriter event_log; // One writer drains every stream's bus
+    startEvents(event_log, buses, config.events_file);
+
+    std::atomic<int> live{(int)streams.size()};
+    detector.setStreamCount(live);
+    long long run_start_tick = cv::getTickCount();
+    for (size_t i = 0; i < streams.size(); ++i) {
+        StreamRun* s = streams[i].get();
+        auto finish = [s, &live, &detector] {
+            if (s->done.exchange(true)) return;
+            detector.setStreamCount(--live); // Don't hold batches open for a finished stream
+        };
+        bool started = s->staged->start(&s->cap, nullptr,
+            [s, i, finish, max_frames, report_every](const cv::Mat&, const std::vector<TrackOverlay>&, const StageTimings&) {
+                long long n = ++s->frames_out;
+                if (max_frames >= 0 && n >= max_frames) { finish(); }
+                if (report_every > 0 && n % report_every == 0) { std::cout << cv::format("[stream %zu] %lld frames", i, n) << std::endl; }
+            },
+            [s, i, finish](const std::string& reason) { std::cout << "[stream " << i << "] " << reason << std::endl; finish(); });
+        if (!started) { std::cerr << "Error: Could not start processing threads for " << s->source << std::endl; return 4; }
+    }
+    while (live > 0) { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+    for (auto& s : streams) { s->staged->stop(); }
+    printEvents(event_log, std::vector<const EventBus*>(buses.begin(), buses.end()), config.events_file);
+
+    double wall_sec = (double)(cv::getTickCount() - run_start_tick) / cv::getTickFrequency();
+    long long total_frames = 0, total_runs = 0;
+    for (size_t i = 0; i < streams.size(); ++i) {
+        const StageTotals& t = streams[i]->staged->totals();
+        total_frames += t.frames; total_runs += t.detection_runs;
+        printThroughput(cv::format("[stream %zu]", i).c_str(), t, wall_sec);
+        printScheduler(cv::format("[stream %zu]", i).c_str(), streams[i]->pipeline->scheduler());
+        printTrackerPool(cv::format("[stream %zu]", i).c_str(), streams[i]->pipeline->trackerPool(), wall_sec);
+        printRegions(cv::format("[stream %zu]", i).c_str(), streams[i]->pipeline->regionStats(), config);
+    }
+    BatchStats b = detector.stats();
+    std::cout << cv::format("[total] %zu streams, %lld frames, %.1f fps aggregate, %lld detections (%.1f /s)",
+                            streams.size(), total_frames, wall_sec > 0 ? total_frames / wall_sec : 0.0,
+                            total_runs, wall_sec > 0 ? total_runs / wall_sec : 0.0)
+              << std::endl;
+    std::cout << cv::format("Batches: %llu, %.2f images/batch (max %zu), %llu closed by deadline | forward %.1f ms/batch | wait %.1f ms/image",
+                            (unsigned long long)b.batches, b.batches ? (double)b.images / b.batches : 0.0, b.largest_batch,
+                            (unsigned long long)b.deadline_closes, b.batches ? b.forward_ms / b.batches : 0.0,
+                            b.images ? b.wait_ms / b.images : 0.0)
+              << std::endl;
+    printLatencies();
+    return 0;
+}
+
+// --- Replay: detections from a trace instead of the network ---
+// Runs are associated on the frame they were detected on, so a replay is
+// the synchronous pipeline whatever mode recorded the trace. Without video
+// the tracker sees a blank frame of the recorded size and tracks move on
+// their motion models alone (TrackerEngine::MotionOnly).
+static int runReplay(const std::string& trace_path, const std::string& source, PipelineConfig config,
+                     long long max_frames, long long report_every, const std::string& tracks_path) {
+    DetectionTraceReader trace;
+    if (!trace.open(trace_path)) { std::cerr << "Error: Could not read detection trace: " << trace_path << std::endl; return 3; }
+    const bool video = !source.empty();
+    if (!video) { config.tracker_engine = TrackerEngine::MotionOnly; }
+    config.async_detection = false;
+    TrackingPipeline pipeline(config);
+    if (!pipeline.loadClassNames()) { return 2; }
+    EventBus events((size_t)config.event_queue_depth);
+    EventLogWriter event_log;
+    if (!config.events_file.empty()) { pipeline.setEventBus(&events); startEvents(event_log, {&events}, config.events_file); }
+
+    cv::VideoCapture cap;
+    if (video && !openSource(cap, source)) { std::cerr << "Error: Could not open source: " << source << std::endl; return 3; }
+    std::FILE* tracks = nullptr;
+    if (!tracks_path.empty() && !(tracks = std::fopen(tracks_path.c_str(), "w"))) { std::cerr << "Error: Could not write " << tracks_path << std::endl; return 3; }
+
+    cv::Mat frame;
+    if (!video) { frame = cv::Mat::zeros(trace.header().frame_size, CV_8UC3); } // Only its size is looked at
+    Detections detections;
+    std::vector<TrackOverlay> items;
+    long long record_frame = -1, timestamp_us = 0, runs = 0, frames = 0;
+    bool more = trace.next(record_frame, timestamp_us, detections);
+
+    pipeline.reset();
+    long long run_start_tick = cv::getTickCount();
+    for (long long f = 0; max_frames < 0 || f < max_frames; ++f) {
+        long long loop_start_tick = cv::getTickCount();
+        if (video) {
+            if (!cap.read(frame) || frame.empty()) break;
+            pipeline.setCaptureTime(((double)(cv::getTickCount() - loop_start_tick) / cv::getTickFrequency()) * 1000);
+        } else if (!more) {
+            break;
+        }
+        pipeline.updateTracks(frame);
+        while (more && record_frame <= f) { // Every run recorded for this frame
+            pipeline.associateAndTrack(frame, detections.boxes, detections.classIds);
+            runs++;
+            more = trace.next(record_frame, timestamp_us, detections);
+        }
+        pipeline.collectOverlay(items);
+        if (tracks) {
+            for (const TrackOverlay& t : items) {
+                std::fprintf(tracks, "%lld,%d,%d,%d,%d,%d,1,-1,-1,-1\n", f + 1, t.id, t.boundingBox.x, t.boundingBox.y, t.boundingBox.width, t.boundingBox.height);
+            }
+        }
+        frames++;
+        if (report_every > 0 && frames % report_every == 0) {
+            std::cout << cv::format("[replay] %lld frames, %lld detection runs, %zu active tracks", frames, runs, pipeline.activeTrackCount()) << std::endl;
+        }
+    }
+    if (tracks) { std::fclose(tracks); }
+
+    double wall_sec = (double)(cv::getTickCount() - run_start_tick) / cv::getTickFrequency();
+    std::cout << cv::format("[replay] frames=%lld detection runs=%lld wall=%.2fs fps=%.1f (%s)", frames, runs, wall_sec,
+                            wall_sec > 0 ? frames / wall_sec : 0.0, video ? "video decoded" : "no video, motion model only")
+              << std::endl;
+    if (more) { std::cout << "[replay] stopped before the end of the trace (record for frame " << record_frame << " not reached)" << std::endl; }
+    printTrackerPool("[replay]", pipeline.trackerPool(), wall_sec);
+    std::cout << "Active tracks at exit: " << pipeline.activeTrackCount()
+              << ", lost: " << pipeline.lostTrackCount() << std::endl;
+    if (!tracks_path.empty()) { std::cout << "Tracks written to " << tracks_path << std::endl; }
+    printEvents(event_log, {&events}, config.events_file);
+    printLatencies();
+    return 0;
+}
+
+// A raw recording and its sidecar are read side by side, record n with
+// frame n. Trajectories are rebuilt from the box centres of earlier
+// records; the overlay is the same drawOverlay() the live pipeline uses.
+static int runReview(const std::string& video_path, std::string out_path, const PipelineConfig& config, bool overlay,
+                     long long max_frames, const std::string& tracks_path, bool no_video) {
+    OverlaySidecarReader sidecar;
+    const std::string sidecar_path = sidecarPath(video_path);
+    if (!sidecar.open(sidecar_path)) { std::cerr << "Error: Could not read overlay sidecar: " << sidecar_path << std::endl; return 3; }
+    TrackingPipeline pipeline(config);
+    pipeline.setDrawRestrictedZone(overlay);
+    pipeline.setDrawTrajectory(overlay);
+    if (!pipeline.loadClassNames()) { return 2; }
+
+    cv::VideoCapture cap;
+    cv::VideoWriter writer;
+    if (!no_video) {
+        if (!openSource(cap, video_path)) { std::cerr << "Error: Could not open recording: " << video_path << std::endl; return 3; }
+        if (out_path.empty()) {
+            const size_t dot = video_path.find_last_of('.');
+            out_path = (dot == std::string::npos ? video_path : video_path.substr(0, dot)) + "_review.avi";
+        }
+        const double fps = sidecar.fps() > 0 ? sidecar.fps() : 30.0;
+        if (!writer.open(out_path, config.output_fourcc, fps, sidecar.frameSize(), true)) { std::cerr << "Error: Could not write " << out_path << std::endl; return 3; }
+    }
+    std::FILE* tracks = nullptr;
+    if (!tracks_path.empty() && !(tracks = std::fopen(tracks_path.c_str(), "w"))) { std::cerr << "Error: Could not write " << tracks_path << std::endl; return 3; }
+
+    SidecarFrame record;
+    std::vector<TrackOverlay> items;
+    std::map<int, std::vector<cv::Point>> trails;
+    std::set<int> ids;
+    const size_t trail_length = (size_t)std::max(1, config.trajectory_length);
+    long long alert_frames = 0, frames = 0;
+    cv::Mat frame;
+    StageTimings timings;
+    const size_t count = max_frames >= 0 ? std::min(sidecar.frameCount(), (size_t)max_frames) : sidecar.frameCount();
+    for (size_t n = 0; n < count; ++n) {
+        if (!no_video && (!cap.read(frame) || frame.empty())) break;
+        if (!sidecar.read(n, record)) break;
+        items.resize(record.tracks.size());
+        bool alert = false;
+        for (size_t i = 0; i < record.tracks.size(); ++i) {
+            const SidecarTrack& t = record.tracks[i];
+            TrackOverlay& item = items[i];
+            item.id = t.id; item.classId = t.class_id; item.boundingBox = t.box; item.velocity = t.velocity;
+            item.in_zone = (t.flags & SIDECAR_ZONE) != 0; item.over_speed = (t.flags & SIDECAR_SPEED) != 0;
+            item.zone_alert = (t.flags & SIDECAR_ZONE_ALERT) != 0;
+            alert = alert || item.alerting(); // Same rule as the recorder's record_on_alert
+            std::vector<cv::Point>& trail = trails[t.id];
+            trail.emplace_back(t.box.x + t.box.width / 2, t.box.y + t.box.height / 2);
+            if (trail.size() > trail_length) { trail.erase(trail.begin()); }
+            item.trajectory = trail;
+            ids.insert(t.id);
+            if (tracks) { std::fprintf(tracks, "%lld,%d,%d,%d,%d,%d,1,-1,-1,-1\n", record.source_index + 1, t.id, t.box.x, t.box.y, t.box.width, t.box.height); }
+        }
+        if (alert) { alert_frames++; }
+        if (writer.isOpened()) {
+            pipeline.drawOverlay(frame, items, record.source_index, timings, sidecar.fps());
+            writer.write(frame);
+        }
+        frames++;
+    }
+    if (tracks) { std::fclose(tracks); }
+    writer.release();
+
+    std::cout << cv::format("[review] %lld of %zu sidecar frames, %zu tracks, %lld frames with alerts", frames, sidecar.frameCount(), ids.size(), alert_frames) << std::endl;
+    if (!out_path.empty() && !no_video) { std::cout << "Annotated copy written to " << out_path << std::endl; }
+    if (!tracks_path.empty()) { std::cout << "Tracks written to " << tracks_path << std::endl; }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) { printUsage(argv[0]); return 1; }
+
+    std::vector<std::string> sources;
+    PipelineConfig config;
+    long long max_frames = -1;
+    long long report_every = 100;
+    std::string record_path;
+    std::string trace_path, replay_path, tracks_path;
+    std::string review_path, review_out;
+    bool no_video = false;
+    bool overlay = true;
+    bool sequential = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--data" && has_value) { config.data_path = argv[++i]; if (config.data_path.back() != '/') config.data_path += '/'; }
+        else if (arg == "--max-frames" && has_value) { max_frames = std::atoll(argv[++i]); }
+        else if (arg == "--report-every" && has_value) { report_every = std::atoll(argv[++i]); }
+        else if (arg == "--record" && has_value) { record_path = argv[++i]; }
+        else if (arg == "--record-policy" && has_value) {
+            std::string p = argv[++i];
+            if (p == "block") config.record_full_policy = RecordFullPolicy::Block;
+            else if (p == "drop") config.record_full_policy = RecordFullPolicy::Drop;
+            else if (p == "degrade") config.record_full_policy = RecordFullPolicy::Degrade;
+            else { std::cerr << "Unknown record policy: " << p << std::endl; printUsage(argv[0]); return 1; }
+        }
+        else if (arg == "--segment-seconds" && has_value) { config.record_segment_seconds = std::atof(argv[++i]); }
+        else if (arg == "--segment-mb" && has_value) { config.record_segment_bytes = std::atoll(argv[++i]) * 1024 * 1024; }
+        else if (arg == "--record-raw") { config.record_raw = true; }
+        else if (arg == "--record-on-alert") { config.record_on_alert = true; }
+        else if (arg == "--preroll" && has_value) { config.record_preroll_seconds = std::atof(argv[++i]); }
+        else if (arg == "--postroll" && has_value) { config.record_postroll_seconds = std::atof(argv[++i]); }
+        else if (arg == "--preroll-mb" && has_value) { config.record_preroll_bytes = std::atoll(argv[++i]) * 1024 * 1024; }
+        else if (arg == "--review" && has_value) { review_path = argv[++i]; }
+        else if (arg == "--review-out" && has_value) { review_out = argv[++i]; }
+        else if (arg == "--no-overlay") { overlay = false; }
+        else if (arg == "--sequential") { sequential = true; }
+        else if (arg == "--sync-detect") { config.async_detection = false; }
+        else if (arg == "--queue-depth" && has_value) { config.queue_depth = std::max(1, std::atoi(argv[++i])); }
+        else if (arg == "--fixed-detect") { config.adaptive_detection = false; }
+        else if (arg == "--detect-budget" && has_value) { config.detect_budget = std::atof(argv[++i]); }
+        else if (arg == "--min-psr" && has_value) { config.detect_min_psr = std::atof(argv[++i]); }
+        else if (arg == "--detect-regions" && has_value) {
+            std::string m = argv[++i];
+            if (m == "full") config.detect_regions = DetectRegionMode::Full;
+            else if (m == "roi") config.detect_regions = DetectRegionMode::Roi;
+            else if (m == "tiles") config.detect_regions = DetectRegionMode::Tiles;
+            else { std::cerr << "Unknown detect region mode: " << m << std::endl; printUsage(argv[0]); return 1; }
+        }
+        else if (arg == "--tile-size" && has_value) { config.tile_size = std::max(64, std::atoi(argv[++i])); }
+        else if (arg == "--legacy-tracker") { config.tracker_engine = TrackerEngine::LegacyMosse; }
+        else if (arg == "--appearance-interval" && has_value) { config.appearance_interval = std::max(1, std::atoi(argv[++i])); }
+        else if (arg == "--processing-scale" && has_value) { config.processing_scale = std::atof(argv[++i]); }
+        else if (arg == "--batch-max" && has_value) { config.batch_max = std::max(1, std::atoi(argv[++i])); }
+        else if (arg == "--batch-deadline" && has_value) { config.batch_deadline_ms = std::atof(argv[++i]); }
+        else if (arg == "--metrics-file" && has_value) { config.metrics_file = argv[++i]; }
+        else if (arg == "--metrics-interval" && has_value) { config.metrics_interval_sec = std::atof(argv[++i]); }
+        else if (arg == "--log-level" && has_value) {
+            LogLevel level;
+            if (!Log::parseLevel(argv[++i], level)) { std::cerr << "Unknown log level: " << argv[i] << std::endl; printUsage(argv[0]); return 1; }
+            Log::setLevel(level);
+        }
+        else if (arg == "--record-trace" && has_value) { trace_path = argv[++i]; }
+        else if (arg == "--replay-trace" && has_value) { replay_path = argv[++i]; }
+        else if (arg == "--no-video") { no_video = true; }
+        else if (arg == "--tracks-out" && has_value) { tracks_path = argv[++i]; }
+        else if (arg == "--events" && has_value) { config.events_file = argv[++i]; }
+        else if (arg == "--zones" && has_value) { config.zones_file = argv[++i]; }
+        else if (arg.compare(0, 2, "--") != 0) { sources.push_back(arg); }
+        else { std::cerr << "Unknown or incomplete option: " << arg << std::endl; printUsage(argv[0]); return 1; }
+    }
+
+    if (!review_path.empty()) { return runReview(review_path, review_out, config, overlay, max_frames, tracks_path, no_video); }
+    const bool replay_without_video = !replay_path.empty() && no_video;
+    if (sources.empty() && !replay_without_video) { printUsage(argv[0]); return 1; }
+    MetricsExporter exporter; // Final write when main returns
+    if (!config.metrics_file.empty() && !exporter.start(config.metrics_file, config.metrics_interval_sec)) {
+        std::cerr << "Warning: Could not write metrics to " << config.metrics_file << std::endl;
+    }
+    if (!replay_path.empty()) {
+        if (sources.size() > 1 || !record_path.empty() || !trace_path.empty()) { std::cerr << "Warning: Replay uses the first source only and does not record." << std::endl; }
+        return runReplay(replay_path, replay_without_video || sources.empty() ? std::string() : sources[0], config, max_frames, report_every, tracks_path);
+    }
+    if (sources.size() > 1) {
+        if (!record_path.empty() || !trace_path.empty() || sequential) { std::cerr << "Warning: --record, --record-trace and --sequential apply to a single source only." << std::endl; }
+        return runMultiStream(sources, config, max_frames, report_every, overlay);
+    }
+    const std::string& source = sources[0];
+
+    AllocationCounters::installMatAllocator();
+    TrackingPipeline pipeline(config);
+    pipeline.setDrawRestrictedZone(overlay);
+    pipeline.setDrawTrajectory(overlay);
+    if (!pipeline.loadNetwork()) { std::cerr << "Error: Network model not loaded." << std::endl; return 2; }
+
+    cv::VideoCapture cap;
+    if (!openSource(cap, source)) { std::cerr << "Error: Could not open source: " << source << std::endl; return 3; }
+
+    const double fps = cap.get(cv::CAP_PROP_FPS);
+    const cv::Size frame_size((int)cap.get(cv::CAP_PROP_FRAME_WIDTH), (int)cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+    EventBus events((size_t)config.event_queue_depth);
+    EventLogWriter event_log;
+    if (!config.events_file.empty()) { pipeline.setEventBus(&events); startEvents(event_log, {&events}, config.events_file); }
+
+    DetectionTraceWriter trace;
+    if (!trace_path.empty()) {
+        if (trace.open(trace_path, frame_size, fps)) { pipeline.setTraceWriter(&trace); }
+        else { std::cerr << "Warning: Detection trace disabled, could not open " << trace_path << std::endl; }
+    }
+
+    RecordingWriter recorder(config);
+    if (!record_path.empty()) {
+        std::string base = record_path;
+        if (base.size() > 4 && base.compare(base.size() - 4, 4, ".avi") == 0) { base.resize(base.size() - 4); }
+        if (!recorder.open(base, fps, frame_size)) {
+            std::cerr << "Warning: Recording disabled, could not open " << record_path << std::endl;
+        }
+    }
+
+    pipeline.reset();
+    long long run_start_tick = cv::getTickCount();
+
+    if (!sequential) {
+        // --- Threaded: one thread per stage ---
+        StagedPipeline staged(pipeline, (size_t)config.queue_depth);
+        std::atomic<bool> done{false};
+        std::atomic<long long> frames_out{0};
+        // on_frame runs on the encode thread; only that thread touches `window_*`
+        StageTotals window_start;
+        AllocSnapshot window_allocs = AllocationCounters::snapshot();
+        long long window_start_tick = run_start_tick;
+        bool started = staged.start(&cap, recorder.isOpen() ? &recorder : nullptr,
+            [&](const cv::Mat&, const std::vector<TrackOverlay>&, const StageTimings&) {
+                long long n = ++frames_out;
+                if (max_frames >= 0 && n >= max_frames) { done = true; }
+                if (report_every > 0 && n % report_every == 0) {
+                    // totals() is updated after this callback returns, so it lags by one frame
+                    long long now = cv::getTickCount();
+                    const StageTotals& totals = staged.totals();
+                    AllocSnapshot allocs = AllocationCounters::snapshot();
+                    printThroughput("[window]", windowOf(totals, window_start), (double)(now - window_start_tick) / cv::getTickFrequency());
+                    printAllocations("[window]", allocs - window_allocs, report_every);
+                    window_start = totals; window_start_tick = now; window_allocs = allocs;
+                }
+            },
+            [&](const std::string& reason) { std::cout << reason << std::endl; done = true; });
+        if (!started) { std::cerr << "Error: Could not start processing threads." << std::endl; return 4; }
+        while (!done) { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+        staged.stop();
+        recorder.close();
+        trace.close();
+
+        double wall_sec = (double)(cv::getTickCount() - run_start_tick) / cv::getTickFrequency();
+        printThroughput("[total]", staged.totals(), wall_sec);
+        std::cout << "Per-stage (threaded, queue depth " << config.queue_depth << "):" << std::endl;
+        printStageReport(staged.report());
+        const BufferPool<FramePacket>& pool = staged.packetPool();
+        std::cout << "Packet pool: reused " << pool.hits() << ", built " << pool.misses()
+                  << ", dropped " << pool.dropped() << std::endl;
+        printRecording(recorder, config);
+        printTrace(trace, trace_path);
+        printEvents(event_log, {&events}, config.events_file);
+        printScheduler("[total]", pipeline.scheduler());
+        printTrackerPool("[total]", pipeline.trackerPool(), wall_sec);
+        printRegions("[total]", pipeline.regionStats(), config);
+        std::cout << "Active tracks at exit: " << pipeline.activeTrackCount()
+                  << ", lost: " << pipeline.lostTrackCount() << std::endl;
+        printLatencies();
+        return 0;
+    }
+
+    // --- Sequential: every stage in turn on this thread ---
+    if (recorder.isOpen()) { pipeline.setRecorder(&recorder); }
+    cv::Mat frame; // Reused: read() only reallocates if the frame size changes
+    StageTotals window_start;
+    AllocSnapshot window_allocs = AllocationCounters::snapshot();
+    long long window_start_tick = run_start_tick;
+
+    while (max_frames < 0 || pipeline.frameCount() < max_frames) {
+        long long loop_start_tick = cv::getTickCount();
+        bool success = false;
+        if (!frame.empty() && !soleOwner(frame)) { frame.release(); } // Still queued for the recorder
+        try { success = cap.read(frame); }
+        catch (const cv::Exception& ex) { std::cerr << "OpenCV Exception during cap.read(): " << ex.what() << std::endl; break; }
+        if (!success || frame.empty()) break;
+
+        pipeline.setCaptureTime(((double)(cv::getTickCount() - loop_start_tick) / cv::getTickFrequency()) * 1000);
+        pipeline.processFrame(frame, loop_start_tick);
+        if (recorder.isOpen()) { recorder.write(frame, &pipeline.lastOverlay(), pipeline.frameCount() - 1); }
+
+        const StageTotals& totals = pipeline.totals();
+        if (report_every > 0 && totals.frames % report_every == 0) {
+            long long now = cv::getTickCount();
+            AllocSnapshot allocs = AllocationCounters::snapshot();
+            printThroughput("[window]", windowOf(totals, window_start), (double)(now - window_start_tick) / cv::getTickFrequency());
+            printAllocations("[window]", allocs - window_allocs, totals.frames - window_start.frames);
+            window_start = totals; window_start_tick = now; window_allocs = allocs;
+        }
+    }
+
+    recorder.close();
+    trace.close();
+    double wall_sec = (double)(cv::getTickCount() - run_start_tick) / cv::getTickFrequency();
+    printThroughput("[total]", pipeline.totals(), wall_sec);
+    printRecording(recorder, config);
+    printTrace(trace, trace_path);
+    printEvents(event_log, {&events}, config.events_file);
+    printScheduler("[total]", pipeline.scheduler());
+    printTrackerPool("[total]", pipeline.trackerPool(), wall_sec);
+    printRegions("[total]", pipeline.regionStats(), config);
+    std::cout << "Active tracks at exit: " << pipeline.activeTrackCount()
+              << ", lost: " << pipeline.lostTrackCount() << std::endl;
+    printLatencies();
+    return 0;
+}